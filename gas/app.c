@@ -430,6 +430,20 @@ scan_for_multibyte_characters (const unsigned char *  start,
     {
       unsigned char c;
 
+      /* Compiler generated input is almost entirely ASCII, so skip
+	 over it a word at a time before looking at single bytes.  */
+      while ((size_t) (end - start) >= sizeof (uint64_t))
+	{
+	  uint64_t word;
+
+	  memcpy (&word, start, sizeof (word));
+	  if ((word & 0x8080808080808080ULL) != 0)
+	    break;
+	  start += sizeof (word);
+	}
+      if (start == end)
+	break;
+
       if ((c = * start++) <= 0x7f)
 	continue;
 
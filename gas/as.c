@@ -253,6 +253,10 @@ Options:\n\
              (DEFAULT_COMPRESSED_DEBUG_ALGORITHM_HELP));
 
   fprintf (stream, _("\
+  --compress-debug-threads=N\n\
+                          compress DWARF debug sections in pieces on N\n\
+                          threads\n"));
+  fprintf (stream, _("\
   --nocompress-debug-sections\n\
                           don't compress DWARF debug sections\n"));
   fprintf (stream, _("\
@@ -505,7 +509,8 @@ parse_args (int * pargc, char *** pargv)
       OPTION_SFRAME,
       OPTION_SCFI,
       OPTION_INFO,
-      OPTION_NOINFO
+      OPTION_NOINFO,
+      OPTION_COMPRESS_DEBUG_THREADS
     /* When you add options here, check that they do
        not collide with OPTION_MD_BASE.  See as.h.  */
     };
@@ -524,6 +529,7 @@ parse_args (int * pargc, char *** pargv)
     /* Handle -al=<FILE>.  */
     ,{"al", optional_argument, NULL, OPTION_AL}
     ,{"compress-debug-sections", optional_argument, NULL, OPTION_COMPRESS_DEBUG}
+    ,{"compress-debug-threads", required_argument, NULL, OPTION_COMPRESS_DEBUG_THREADS}
     ,{"nocompress-debug-sections", no_argument, NULL, OPTION_NOCOMPRESS_DEBUG}
     ,{"debug-prefix-map", required_argument, NULL, OPTION_DEBUG_PREFIX_MAP}
     ,{"defsym", required_argument, NULL, OPTION_DEFSYM}
@@ -762,6 +768,18 @@ This program has absolutely no warranty.\n"));
 	    flag_compress_debug = DEFAULT_COMPRESSED_DEBUG_ALGORITHM;
 	  break;
 
+	case OPTION_COMPRESS_DEBUG_THREADS:
+	  {
+	    char *end;
+	    unsigned long threads = strtoul (optarg, &end, 0);
+
+	    if (*optarg == '\0' || *end != '\0' || threads > 256)
+	      as_fatal (_("invalid --compress-debug-threads option: `%s'"),
+			optarg);
+	    flag_compress_debug_threads = threads;
+	  }
+	  break;
+
 	case OPTION_NOCOMPRESS_DEBUG:
 	  flag_compress_debug = COMPRESS_DEBUG_NONE;
 	  break;
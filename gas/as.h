@@ -350,6 +350,11 @@ COMMON int flag_traditional_format;
 /* Type of compressed debug sections we should generate.   */
 COMMON enum compressed_debug_section_type flag_compress_debug;
 
+/* Number of threads to compress debug sections with, split into
+   pieces.  0 compresses each section in one piece on the main
+   thread.  */
+COMMON unsigned int flag_compress_debug_threads;
+
 /* TRUE if .note.GNU-stack section with SEC_CODE should be created */
 COMMON int flag_execstack;
 
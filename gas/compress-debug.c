@@ -20,11 +20,16 @@
 
 #include "config.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <zlib.h>
 #if HAVE_ZSTD
 #include <zstd.h>
 #endif
+#if defined (HAVE_PTHREAD_H) && defined (HAVE_PTHREAD_CREATE)
+#include <pthread.h>
+#define COMPRESS_THREADS 1
+#endif
 #include "ansidecl.h"
 #include "compress-debug.h"
 
@@ -135,3 +140,208 @@ compress_finish (bool use_zstd, void *ctx, char **next_out,
     return -1;
   return 1;
 }
+
+/* Compress a zlib piece into a raw deflate stream, primed with the
+   window preceding it so that the pieces compress nearly as well as
+   one stream would, and ending on a byte boundary so that they can be
+   concatenated.  The first piece of a section gets the zlib header.  */
+
+static bool
+compress_piece_zlib (struct compress_piece *piece)
+{
+  struct z_stream_s strm;
+  size_t header_size = piece->dict_size == 0 ? 2 : 0;
+  size_t size;
+  int x;
+
+  memset (&strm, 0, sizeof (strm));
+  if (deflateInit2 (&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+		    8, Z_DEFAULT_STRATEGY) != Z_OK)
+    return false;
+  if (piece->dict_size != 0
+      && deflateSetDictionary (&strm,
+			       (const Bytef *) piece->in - piece->dict_size,
+			       piece->dict_size) != Z_OK)
+    {
+      deflateEnd (&strm);
+      return false;
+    }
+
+  /* Leave room for the empty block a sync flush ends with, and for the
+     trailer compress_pieces adds to the last piece.  */
+  size = header_size + deflateBound (&strm, piece->in_size) + 16;
+  piece->out = malloc (size);
+  if (piece->out == NULL)
+    {
+      deflateEnd (&strm);
+      return false;
+    }
+
+  /* A deflate stream with a 32k window, compressed at the default
+     level.  */
+  if (header_size != 0)
+    {
+      piece->out[0] = 0x78;
+      piece->out[1] = 0x9c;
+    }
+
+  strm.next_in = (Bytef *) piece->in;
+  strm.avail_in = piece->in_size;
+  strm.next_out = (Bytef *) piece->out + header_size;
+  strm.avail_out = size - header_size - 4;
+  x = deflate (&strm, piece->last ? Z_FINISH : Z_SYNC_FLUSH);
+  piece->out_size = (char *) strm.next_out - piece->out;
+  deflateEnd (&strm);
+
+  piece->adler = adler32 (adler32 (0, NULL, 0), (const Bytef *) piece->in,
+			  piece->in_size);
+
+  if (piece->last)
+    return x == Z_STREAM_END;
+  return x == Z_OK && strm.avail_in == 0 && strm.avail_out != 0;
+}
+
+/* Compress a zstd piece into a frame of its own: the contents of a
+   compressed section can be any number of frames.  */
+
+static bool
+compress_piece_zstd (struct compress_piece *piece ATTRIBUTE_UNUSED)
+{
+#if HAVE_ZSTD
+  size_t size = ZSTD_compressBound (piece->in_size);
+
+  piece->out = malloc (size);
+  if (piece->out == NULL)
+    return false;
+  piece->out_size = ZSTD_compress (piece->out, size, piece->in,
+				   piece->in_size, ZSTD_CLEVEL_DEFAULT);
+  return !ZSTD_isError (piece->out_size);
+#else
+  return false;
+#endif
+}
+
+/* The pieces still to be compressed by compress_pieces.  */
+
+struct compress_queue
+{
+#ifdef COMPRESS_THREADS
+  pthread_mutex_t lock;
+#endif
+  bool use_zstd;
+  struct compress_piece *pieces;
+  size_t npieces;
+  size_t next;
+  bool failed;
+};
+
+/* Compress pieces from the queue until there are none left.  */
+
+static void *
+compress_worker (void *arg)
+{
+  struct compress_queue *queue = arg;
+
+  for (;;)
+    {
+      struct compress_piece *piece = NULL;
+      bool ok;
+
+#ifdef COMPRESS_THREADS
+      pthread_mutex_lock (&queue->lock);
+#endif
+      if (queue->next < queue->npieces && !queue->failed)
+	piece = &queue->pieces[queue->next++];
+#ifdef COMPRESS_THREADS
+      pthread_mutex_unlock (&queue->lock);
+#endif
+      if (piece == NULL)
+	break;
+
+      if (queue->use_zstd)
+	ok = compress_piece_zstd (piece);
+      else
+	ok = compress_piece_zlib (piece);
+
+      if (!ok)
+	{
+#ifdef COMPRESS_THREADS
+	  pthread_mutex_lock (&queue->lock);
+#endif
+	  queue->failed = true;
+#ifdef COMPRESS_THREADS
+	  pthread_mutex_unlock (&queue->lock);
+#endif
+	}
+    }
+  return NULL;
+}
+
+/* Compress the NPIECES PIECES of one or more sections, using up to
+   THREADS threads.  The output does not depend on the number of
+   threads.  Returns false on error, leaving the pieces to be freed by
+   the caller.  */
+
+bool
+compress_pieces (bool use_zstd, struct compress_piece *pieces,
+		 size_t npieces, unsigned int threads ATTRIBUTE_UNUSED)
+{
+  struct compress_queue queue;
+  unsigned long adler = 0;
+  size_t i;
+
+  memset (&queue, 0, sizeof (queue));
+  queue.use_zstd = use_zstd;
+  queue.pieces = pieces;
+  queue.npieces = npieces;
+
+#ifdef COMPRESS_THREADS
+  pthread_t *workers = NULL;
+  unsigned int nworkers = 0;
+
+  if (threads > npieces)
+    threads = npieces;
+  if (threads > 1)
+    workers = malloc ((threads - 1) * sizeof (pthread_t));
+  pthread_mutex_init (&queue.lock, NULL);
+  if (workers != NULL)
+    for (; nworkers < threads - 1; nworkers++)
+      if (pthread_create (&workers[nworkers], NULL, compress_worker,
+			  &queue) != 0)
+	break;
+  compress_worker (&queue);
+  for (i = 0; i < nworkers; i++)
+    pthread_join (workers[i], NULL);
+  free (workers);
+  pthread_mutex_destroy (&queue.lock);
+#else
+  compress_worker (&queue);
+#endif
+
+  if (queue.failed)
+    return false;
+
+  /* End each zlib stream with the Adler-32 of all its pieces.  */
+  if (!use_zstd)
+    for (i = 0; i < npieces; i++)
+      {
+	if (pieces[i].dict_size == 0)
+	  adler = pieces[i].adler;
+	else
+	  adler = adler32_combine (adler, pieces[i].adler,
+				   pieces[i].in_size);
+	if (pieces[i].last)
+	  {
+	    unsigned char *trailer;
+
+	    trailer = (unsigned char *) pieces[i].out + pieces[i].out_size;
+	    trailer[0] = adler >> 24;
+	    trailer[1] = adler >> 16;
+	    trailer[2] = adler >> 8;
+	    trailer[3] = adler;
+	    pieces[i].out_size += 4;
+	  }
+      }
+
+  return true;
+}
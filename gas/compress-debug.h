@@ -25,6 +25,8 @@
 
 struct z_stream_s;
 
+#include <stddef.h>
+
 /* Initialize the compression engine.  */
 extern void *compress_init (bool);
 
@@ -36,4 +38,37 @@ extern int compress_data (bool, void *, const char **, int *, char **, int *);
 extern int
 compress_finish (bool, void *, char **, int *, int *);
 
+/* The size of the pieces debug sections are split into, to compress
+   them on several threads.  zlib pieces are primed with the window
+   before them, but zstd pieces are separate frames that start afresh,
+   so they are made larger.  */
+#define COMPRESS_PIECE_SIZE_ZLIB (1 << 20)
+#define COMPRESS_PIECE_SIZE_ZSTD (1 << 22)
+
+/* A piece of a debug section, compressed on its own.  */
+struct compress_piece
+{
+  /* The uncompressed contents, in a buffer holding the whole section.  */
+  const char *in;
+  size_t in_size;
+
+  /* For zlib, the number of bytes before IN to prime the compressor
+     with.  0 for the first piece of a section.  */
+  size_t dict_size;
+
+  /* Whether this is the last piece of its section.  */
+  bool last;
+
+  /* The compressed piece, malloc'd.  */
+  char *out;
+  size_t out_size;
+
+  /* For zlib, the Adler-32 checksum of IN.  */
+  unsigned long adler;
+};
+
+/* Compress pieces of sections, on up to the given number of threads.  */
+extern bool compress_pieces (bool, struct compress_piece *, size_t,
+			     unsigned int);
+
 #endif /* COMPRESS_DEBUG_H */
@@ -167,7 +167,12 @@
 struct line_entry
 {
   struct line_entry *next;
+  /* Where the entry applies.  A label symbol is only created once
+     something needs to refer to the location symbolically; until then
+     LABEL is NULL and FRAG and FRAG_OFS give the location.  */
   symbolS *label;
+  fragS *frag;
+  addressT frag_ofs;
   struct dwarf2_line_info loc;
 };
 
@@ -307,6 +312,29 @@ get_line_subseg (segT seg, subsegT subseg, bool create_p)
   return lss;
 }
 
+/* Return the label for E, which is in section SEG, creating it if
+   necessary.  */
+
+static symbolS *
+line_entry_label (struct line_entry *e, segT seg)
+{
+  if (e->label == NULL)
+    e->label = symbol_temp_new (seg, e->frag, e->frag_ofs);
+  return e->label;
+}
+
+static fragS *
+line_entry_frag (const struct line_entry *e)
+{
+  return e->label ? symbol_get_frag (e->label) : e->frag;
+}
+
+static addressT
+line_entry_frag_ofs (const struct line_entry *e)
+{
+  return e->label ? S_GET_VALUE (e->label) : e->frag_ofs;
+}
+
 /* (Un)reverse the line_entry list starting from H.  */
 
 static struct line_entry *
@@ -323,13 +351,13 @@ reverse_line_entry_list (struct line_entry *h)
   return p;
 }
 
-/* Compute the view for E based on the previous entry P.  If we
-   introduce an (undefined) view symbol for P, and H is given (P must
-   be the tail in this case), introduce view symbols for earlier list
-   entries as well, until one of them is constant.  */
+/* Compute the view for E based on the previous entry P, both in
+   section SEG.  If we introduce an (undefined) view symbol for P, and
+   H is given (P must be the tail in this case), introduce view symbols
+   for earlier list entries as well, until one of them is constant.  */
 
 static void
-set_or_check_view (struct line_entry *e, struct line_entry *p,
+set_or_check_view (segT seg, struct line_entry *e, struct line_entry *p,
 		   struct line_entry *h)
 {
   expressionS viewx;
@@ -351,8 +379,8 @@ set_or_check_view (struct line_entry *e, struct line_entry *p,
     {
       viewx.X_op = O_gt;
       viewx.X_add_number = 0;
-      viewx.X_add_symbol = e->label;
-      viewx.X_op_symbol = p->label;
+      viewx.X_add_symbol = line_entry_label (e, seg);
+      viewx.X_op_symbol = line_entry_label (p, seg);
       resolve_expression (&viewx);
       if (viewx.X_op == O_constant)
 	viewx.X_add_number = !viewx.X_add_number;
@@ -464,7 +492,7 @@ set_or_check_view (struct line_entry *e, struct line_entry *p,
 	     that needs it.  */
 	  if (r == h)
 	    break;
-	  set_or_check_view (r, r->next, NULL);
+	  set_or_check_view (seg, r, r->next, NULL);
 	}
       while (r->next
 	     && r->next->loc.u.view
@@ -495,10 +523,12 @@ set_or_check_view (struct line_entry *e, struct line_entry *p,
     }
 }
 
-/* Record an entry for LOC occurring at LABEL.  */
+/* Record an entry for LOC occurring at LABEL, or if LABEL is NULL at
+   offset OFS in FRAG.  */
 
 static void
-dwarf2_gen_line_info_1 (symbolS *label, struct dwarf2_line_info *loc)
+dwarf2_gen_line_info_1 (symbolS *label, fragS *frag, addressT ofs,
+			struct dwarf2_line_info *loc)
 {
   struct line_subseg *lss;
   struct line_entry *e;
@@ -521,6 +551,8 @@ dwarf2_gen_line_info_1 (symbolS *label, struct dwarf2_line_info *loc)
   e = XNEW (struct line_entry);
   e->next = NULL;
   e->label = label;
+  e->frag = frag;
+  e->frag_ofs = ofs;
   e->loc = *loc;
 
   lss = get_line_subseg (now_seg, now_subseg, true);
@@ -528,7 +560,8 @@ dwarf2_gen_line_info_1 (symbolS *label, struct dwarf2_line_info *loc)
   /* Subseg heads are chained to previous subsegs in
      dwarf2_finish.  */
   if (loc->filenum != -1u && loc->u.view && lss->head)
-    set_or_check_view (e, (struct line_entry *) lss->ptail, lss->head);
+    set_or_check_view (now_seg, e, (struct line_entry *) lss->ptail,
+		       lss->head);
 
   *lss->ptail = e;
   lss->ptail = &e->next;
@@ -543,8 +576,6 @@ static int label_num;
 void
 dwarf2_gen_line_info (addressT ofs, struct dwarf2_line_info *loc)
 {
-  symbolS *sym;
-
   /* Early out for as-yet incomplete location information.  */
   if (loc->line == 0)
     return;
@@ -580,16 +611,18 @@ dwarf2_gen_line_info (addressT ofs, struct dwarf2_line_info *loc)
   if (linkrelax)
     {
       char name[32];
+      symbolS *sym;
 
       /* Use a non-fake name for the line number location,
 	 so that it can be referred to by relocations.  */
       sprintf (name, ".Loc.%u", label_num);
       label_num++;
       sym = symbol_new (name, now_seg, frag_now, ofs);
+      dwarf2_gen_line_info_1 (sym, NULL, 0, loc);
     }
   else
-    sym = symbol_temp_new (now_seg, frag_now, ofs);
-  dwarf2_gen_line_info_1 (sym, loc);
+    /* Most entries never need a symbol; see line_entry_label.  */
+    dwarf2_gen_line_info_1 (NULL, frag_now, ofs, loc);
 }
 
 static const char *
@@ -1096,7 +1129,12 @@ dwarf2_move_insn (int delta)
   now = frag_now_fix ();
   while ((e = *lss->pmove_tail))
     {
-      if (S_GET_VALUE (e->label) == now)
+      if (e->label == NULL)
+	{
+	  if (e->frag_ofs == now)
+	    e->frag_ofs = now + delta;
+	}
+      else if (S_GET_VALUE (e->label) == now)
 	S_SET_VALUE (e->label, now + delta);
       lss->pmove_tail = &e->next;
     }
@@ -1142,7 +1180,7 @@ dwarf2_emit_label (symbolS *label)
 
   loc.flags |= DWARF2_FLAG_BASIC_BLOCK;
 
-  dwarf2_gen_line_info_1 (label, &loc);
+  dwarf2_gen_line_info_1 (label, NULL, 0, &loc);
   dwarf2_consume_line_info ();
 }
 
@@ -1996,7 +2034,8 @@ process_entries (segT seg, struct line_entry *e)
   unsigned flags = DWARF2_LINE_DEFAULT_IS_STMT ? DWARF2_FLAG_IS_STMT : 0;
   fragS *last_frag = NULL, *frag;
   addressT last_frag_ofs = 0, frag_ofs;
-  symbolS *last_lab = NULL, *lab;
+  struct line_entry *last_e = NULL;
+  symbolS *lab;
 
   if (flag_dwarf_sections)
     {
@@ -2081,9 +2120,8 @@ process_entries (segT seg, struct line_entry *e)
 	 the {, and there's no way to identify that case here.  Trust gcc
 	 to optimize appropriately.  */
       line_delta = e->loc.line - line;
-      lab = e->label;
-      frag = symbol_get_frag (lab);
-      frag_ofs = S_GET_VALUE (lab);
+      frag = line_entry_frag (e);
+      frag_ofs = line_entry_frag_ofs (e);
 
       if (last_frag == NULL
 	  || (e->loc.u.view == force_reset_view && force_reset_view
@@ -2099,16 +2137,17 @@ process_entries (segT seg, struct line_entry *e)
 		     && ((offsetT)last_frag_ofs
 			 >= get_frag_fix (last_frag, seg))))))
 	{
-	  out_set_addr (lab);
+	  out_set_addr (line_entry_label (e, seg));
 	  out_inc_line_addr (line_delta, 0);
 	}
       else if (frag == last_frag && ! DWARF2_USE_FIXED_ADVANCE_PC)
 	out_inc_line_addr (line_delta, frag_ofs - last_frag_ofs);
       else
-	relax_inc_line_addr (line_delta, lab, last_lab);
+	relax_inc_line_addr (line_delta, line_entry_label (e, seg),
+			     line_entry_label (last_e, seg));
 
       line = e->loc.line;
-      last_lab = lab;
+      last_e = e;
       last_frag = frag;
       last_frag_ofs = frag_ofs;
 
@@ -2124,7 +2163,7 @@ process_entries (segT seg, struct line_entry *e)
   else
     {
       lab = symbol_temp_new (seg, frag, frag_ofs);
-      relax_inc_line_addr (INT_MAX, lab, last_lab);
+      relax_inc_line_addr (INT_MAX, lab, line_entry_label (last_e, seg));
     }
 }
 
@@ -3192,14 +3231,14 @@ dwarf2_finish (void)
       /* Reset the initial view of the first subsection of the
 	 section.  */
       if (lss->head && lss->head->loc.u.view)
-	set_or_check_view (lss->head, NULL, NULL);
+	set_or_check_view (s->seg, lss->head, NULL, NULL);
 
       while ((lss = lss->next) != NULL)
 	{
 	  /* Link the first view of subsequent subsections to the
 	     previous view.  */
 	  if (lss->head && lss->head->loc.u.view)
-	    set_or_check_view (lss->head,
+	    set_or_check_view (s->seg, lss->head,
 			       !s->head ? NULL : (struct line_entry *)ptail,
 			       s->head ? s->head->head : NULL);
 	  *ptail = lss->head;
@@ -27,6 +27,12 @@
 #include "input-file.h"
 #include "safe-ctype.h"
 
+#if defined (HAVE_MMAP) && defined (HAVE_SYS_MMAN_H) && defined (HAVE_SYS_STAT_H)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define USE_MMAP_INPUT 1
+#endif
+
 /* This variable is non-zero if the file currently being read should be
    preprocessed by app.  It is zero if the file can be read straight in.  */
 int preprocess = 0;
@@ -44,11 +50,21 @@ int preprocess = 0;
 static FILE *f_in;
 static const char *file_name;
 
+/* When the input is a regular file it is mapped into memory, and
+   input_file_get copies straight out of the mapping rather than going
+   through stdio.  MAP_START is NULL when reading through F_IN.  */
+static char *map_start;
+static char *map_pos;
+static char *map_end;
+
 /* Struct for saving the state of this module for file includes.  */
 struct saved_file
   {
     FILE * f_in;
     const char * file_name;
+    char * map_start;
+    char * map_pos;
+    char * map_end;
     int    preprocess;
     char * app_save;
   };
@@ -59,6 +75,7 @@ void
 input_file_begin (void)
 {
   f_in = (FILE *) 0;
+  map_start = map_pos = map_end = NULL;
 }
 
 void
@@ -85,6 +102,9 @@ input_file_push (void)
 
   saved->f_in = f_in;
   saved->file_name = file_name;
+  saved->map_start = map_start;
+  saved->map_pos = map_pos;
+  saved->map_end = map_end;
   saved->preprocess = preprocess;
   if (preprocess)
     saved->app_save = app_push ();
@@ -104,6 +124,9 @@ input_file_pop (char *arg)
 
   f_in = saved->f_in;
   file_name = saved->file_name;
+  map_start = saved->map_start;
+  map_pos = saved->map_pos;
+  map_end = saved->map_end;
   preprocess = saved->preprocess;
   if (preprocess)
     app_pop (saved->app_save);
@@ -111,6 +134,86 @@ input_file_pop (char *arg)
   free (arg);
 }
 
+/* Try to map the whole of F_IN into memory.  Only regular, non-empty
+   named files are mapped; anything else keeps using stdio.  The mapping is
+   private and writable so that input_ungetc can push characters back
+   in place, just like ungetc.  */
+
+static void
+input_file_map (void)
+{
+#ifdef USE_MMAP_INPUT
+  struct stat st;
+  void *addr;
+
+  if (fstat (fileno (f_in), &st) != 0
+      || !S_ISREG (st.st_mode)
+      || st.st_size <= 0
+      || (off_t) (size_t) st.st_size != st.st_size)
+    return;
+
+  addr = mmap (NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+	       fileno (f_in), 0);
+  if (addr == MAP_FAILED)
+    return;
+
+  map_start = map_pos = (char *) addr;
+  map_end = map_start + st.st_size;
+#endif
+}
+
+static void
+input_file_unmap (void)
+{
+#ifdef USE_MMAP_INPUT
+  if (map_start != NULL)
+    munmap (map_start, map_end - map_start);
+#endif
+  map_start = map_pos = map_end = NULL;
+}
+
+/* Character-level accessors used while sniffing for #APP/#NO_APP.
+   These behave like getc, ungetc and fgets on whichever of the
+   mapping or F_IN is in use.  */
+
+static int
+input_getc (void)
+{
+  if (map_start == NULL)
+    return getc (f_in);
+  if (map_pos >= map_end)
+    return EOF;
+  return *(unsigned char *) map_pos++;
+}
+
+static void
+input_ungetc (int c)
+{
+  if (map_start == NULL)
+    ungetc (c, f_in);
+  else
+    {
+      gas_assert (map_pos > map_start);
+      *--map_pos = c;
+    }
+}
+
+static char *
+input_gets (char *buf, int size)
+{
+  char *p = buf;
+
+  if (map_start == NULL)
+    return fgets (buf, size, f_in);
+  if (map_pos >= map_end)
+    return NULL;
+  while (p < buf + size - 1 && map_pos < map_end)
+    if ((*p++ = *map_pos++) == '\n')
+      break;
+  *p = '\0';
+  return buf;
+}
+
 /* Open the specified file, "" means stdin.  Filename must not be null.  */
 
 void
@@ -143,9 +246,12 @@ input_file_open (const char *filename,
       return;
     }
 
-  c = getc (f_in);
+  if (filename[0])
+    input_file_map ();
+
+  c = input_getc ();
 
-  if (ferror (f_in))
+  if (map_start == NULL && ferror (f_in))
     {
       as_bad (_("can't read from %s: %s"),
 	      file_name, xstrerror (errno));
@@ -156,7 +262,7 @@ input_file_open (const char *filename,
     }
 
   /* Check for an empty input file.  */
-  if (feof (f_in))
+  if (map_start == NULL && feof (f_in))
     {
       fclose (f_in);
       f_in = NULL;
@@ -171,34 +277,34 @@ input_file_open (const char *filename,
       /* Begins with comment, may not want to preprocess.  */
       int lead = c;
 
-      c = getc (f_in);
+      c = input_getc ();
       if (c == 'N')
 	{
-	  char *p = fgets (buf, sizeof (buf), f_in);
+	  char *p = input_gets (buf, sizeof (buf));
 	  if (p && startswith (p, "O_APP") && is_end_of_line (p[5]))
 	    preprocess = 0;
 	  if (!p || !strchr (p, '\n'))
-	    ungetc (lead, f_in);
+	    input_ungetc (lead);
 	  else
-	    ungetc ('\n', f_in);
+	    input_ungetc ('\n');
 	}
       else if (c == 'A')
 	{
-	  char *p = fgets (buf, sizeof (buf), f_in);
+	  char *p = input_gets (buf, sizeof (buf));
 	  if (p && startswith (p, "PP") && is_end_of_line (p[2]))
 	    preprocess = 1;
 	  if (!p || !strchr (p, '\n'))
-	    ungetc (lead, f_in);
+	    input_ungetc (lead);
 	  else
-	    ungetc ('\n', f_in);
+	    input_ungetc ('\n');
 	}
       else if (c == '\n')
-	ungetc ('\n', f_in);
+	input_ungetc ('\n');
       else
-	ungetc (lead, f_in);
+	input_ungetc (lead);
     }
   else
-    ungetc (c, f_in);
+    input_ungetc (c);
 }
 
 /* Close input file.  */
@@ -206,6 +312,8 @@ input_file_open (const char *filename,
 void
 input_file_close (void)
 {
+  input_file_unmap ();
+
   /* Don't close a null file pointer.  */
   if (f_in != NULL)
     fclose (f_in);
@@ -220,6 +328,16 @@ input_file_get (char *buf, size_t buflen)
 {
   size_t size;
 
+  if (map_start != NULL)
+    {
+      size = map_end - map_pos;
+      if (size > buflen)
+	size = buflen;
+      memcpy (buf, map_pos, size);
+      map_pos += size;
+      return size;
+    }
+
   if (feof (f_in))
     return 0;
 
@@ -263,6 +381,7 @@ input_file_give_next_buffer (char *where /* Where to place 1st character of new
     return_value = where + size;
   else
     {
+      input_file_unmap ();
       if (fclose (f_in))
 	as_warn (_("can't close %s: %s"), file_name, xstrerror (errno));
 
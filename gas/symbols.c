@@ -1932,99 +1932,151 @@ snapshot_symbol (symbolS **symbolPP, valueT *valueP, segT *segP, fragS **fragPP)
   return 1;
 }
 
+/* Both dollar labels and fb labels are numbered, and there can be a
+   great many of them in compiler output.  Their instance counts are
+   kept in a small open addressing hash table keyed by label number.
+   An entry with a zero instance count is empty, since any label we
+   have seen has at least one instance.  */
+
+struct local_label_ent
+{
+  unsigned int label;
+  unsigned int instance;
+  /* For dollar labels, the value of dollar_label_generation when the
+     label was last defined.  */
+  unsigned int generation;
+};
+
+struct local_label_table
+{
+  struct local_label_ent *ents;
+  size_t count;
+  size_t size;
+};
+
+#define LOCAL_LABEL_TABLE_INIT 64
+
+static size_t
+local_label_hash (unsigned int label, size_t size)
+{
+  /* Multiplicative hashing spreads consecutive label numbers, which
+     is what compilers tend to generate.  SIZE is a power of two.  */
+  return (label * 2654435761u) & (size - 1);
+}
+
+/* Return the entry for LABEL in TABLE, or NULL if it is not there.  */
+
+static struct local_label_ent *
+local_label_find (const struct local_label_table *table, unsigned int label)
+{
+  size_t i;
+
+  if (table->count == 0)
+    return NULL;
+
+  for (i = local_label_hash (label, table->size);
+       table->ents[i].instance != 0;
+       i = (i + 1) & (table->size - 1))
+    if (table->ents[i].label == label)
+      return &table->ents[i];
+
+  return NULL;
+}
+
+/* Return the entry for LABEL in TABLE, creating it if it is not there.
+   A new entry has an instance count of zero, which marks it empty, so
+   the caller must bump the count straight away.  */
+
+static struct local_label_ent *
+local_label_insert (struct local_label_table *table, unsigned int label)
+{
+  struct local_label_ent *ent;
+  size_t i;
+
+  ent = local_label_find (table, label);
+  if (ent != NULL)
+    return ent;
+
+  /* Keep the table at most half full.  */
+  if (2 * (table->count + 1) > table->size)
+    {
+      struct local_label_ent *old = table->ents;
+      size_t old_size = table->size;
+
+      table->size = old_size ? 2 * old_size : LOCAL_LABEL_TABLE_INIT;
+      table->ents = XCNEWVEC (struct local_label_ent, table->size);
+      for (i = 0; i < old_size; i++)
+	if (old[i].instance != 0)
+	  {
+	    size_t j = local_label_hash (old[i].label, table->size);
+
+	    while (table->ents[j].instance != 0)
+	      j = (j + 1) & (table->size - 1);
+	    table->ents[j] = old[i];
+	  }
+      free (old);
+    }
+
+  i = local_label_hash (label, table->size);
+  while (table->ents[i].instance != 0)
+    i = (i + 1) & (table->size - 1);
+  ent = &table->ents[i];
+  ent->label = label;
+  table->count++;
+  return ent;
+}
+
+static void
+local_label_table_free (struct local_label_table *table)
+{
+  free (table->ents);
+  table->ents = NULL;
+  table->count = 0;
+  table->size = 0;
+}
+
 /* Dollar labels look like a number followed by a dollar sign.  Eg, "42$".
    They are *really* local.  That is, they go out of scope whenever we see a
    label that isn't local.  Also, like fb labels, there can be multiple
    instances of a dollar label.  Therefor, we name encode each instance with
-   the instance number, keep a list of defined symbols separate from the real
-   symbol table, and we treat these buggers as a sparse array.  */
+   the instance number, and keep the defined labels separate from the real
+   symbol table.  Going out of scope just bumps dollar_label_generation,
+   rather than touching every label.  */
 
-typedef unsigned int dollar_ent;
-static dollar_ent *dollar_labels;
-static dollar_ent *dollar_label_instances;
-static char *dollar_label_defines;
-static size_t dollar_label_count;
-static size_t dollar_label_max;
+static struct local_label_table dollar_labels;
+static unsigned int dollar_label_generation = 1;
 
 int
 dollar_label_defined (unsigned int label)
 {
-  dollar_ent *i;
-
-  know ((dollar_labels != NULL) || (dollar_label_count == 0));
-
-  for (i = dollar_labels; i < dollar_labels + dollar_label_count; ++i)
-    if (*i == label)
-      return dollar_label_defines[i - dollar_labels];
+  struct local_label_ent *ent = local_label_find (&dollar_labels, label);
 
-  /* If we get here, label isn't defined.  */
-  return 0;
+  return ent != NULL && ent->generation == dollar_label_generation;
 }
 
 static unsigned int
 dollar_label_instance (unsigned int label)
 {
-  dollar_ent *i;
-
-  know ((dollar_labels != NULL) || (dollar_label_count == 0));
+  struct local_label_ent *ent = local_label_find (&dollar_labels, label);
 
-  for (i = dollar_labels; i < dollar_labels + dollar_label_count; ++i)
-    if (*i == label)
-      return (dollar_label_instances[i - dollar_labels]);
-
-  /* If we get here, we haven't seen the label before.
-     Therefore its instance count is zero.  */
-  return 0;
+  /* If we haven't seen the label before, its instance count is zero.  */
+  return ent != NULL ? ent->instance : 0;
 }
 
 void
 dollar_label_clear (void)
 {
-  if (dollar_label_count)
-    memset (dollar_label_defines, '\0', dollar_label_count);
+  if (dollar_labels.count)
+    ++dollar_label_generation;
 }
 
-#define DOLLAR_LABEL_BUMP_BY 10
-
 void
 define_dollar_label (unsigned int label)
 {
-  dollar_ent *i;
-
-  for (i = dollar_labels; i < dollar_labels + dollar_label_count; ++i)
-    if (*i == label)
-      {
-	++dollar_label_instances[i - dollar_labels];
-	dollar_label_defines[i - dollar_labels] = 1;
-	return;
-      }
+  struct local_label_ent *ent = local_label_insert (&dollar_labels, label);
 
-  /* If we get to here, we don't have label listed yet.  */
-
-  if (dollar_labels == NULL)
-    {
-      dollar_labels = XNEWVEC (dollar_ent, DOLLAR_LABEL_BUMP_BY);
-      dollar_label_instances = XNEWVEC (dollar_ent, DOLLAR_LABEL_BUMP_BY);
-      dollar_label_defines = XNEWVEC (char, DOLLAR_LABEL_BUMP_BY);
-      dollar_label_max = DOLLAR_LABEL_BUMP_BY;
-      dollar_label_count = 0;
-    }
-  else if (dollar_label_count == dollar_label_max)
-    {
-      dollar_label_max += DOLLAR_LABEL_BUMP_BY;
-      dollar_labels = XRESIZEVEC (dollar_ent, dollar_labels,
-				  dollar_label_max);
-      dollar_label_instances = XRESIZEVEC (dollar_ent,
-					   dollar_label_instances,
-					   dollar_label_max);
-      dollar_label_defines = XRESIZEVEC (char, dollar_label_defines,
-					 dollar_label_max);
-    }				/* if we needed to grow  */
-
-  dollar_labels[dollar_label_count] = label;
-  dollar_label_instances[dollar_label_count] = 1;
-  dollar_label_defines[dollar_label_count] = 1;
-  ++dollar_label_count;
+  ++ent->instance;
+  ent->generation = dollar_label_generation;
 }
 
 /* Caller must copy returned name: we re-use the area for the next name.
@@ -2076,13 +2128,7 @@ dollar_label_name (unsigned int n, unsigned int augend)
 
 typedef unsigned int fb_ent;
 static fb_ent fb_low_counter[FB_LABEL_SPECIAL];
-static fb_ent *fb_labels;
-static fb_ent *fb_label_instances;
-static size_t fb_label_count;
-static size_t fb_label_max;
-
-/* This must be more than FB_LABEL_SPECIAL.  */
-#define FB_LABEL_BUMP_BY (FB_LABEL_SPECIAL + 6)
+static struct local_label_table fb_labels;
 
 static void
 fb_label_init (void)
@@ -2095,71 +2141,28 @@ fb_label_init (void)
 void
 fb_label_instance_inc (unsigned int label)
 {
-  fb_ent *i;
-
   if (label < FB_LABEL_SPECIAL)
     {
       ++fb_low_counter[label];
       return;
     }
 
-  if (fb_labels != NULL)
-    {
-      for (i = fb_labels + FB_LABEL_SPECIAL;
-	   i < fb_labels + fb_label_count; ++i)
-	{
-	  if (*i == label)
-	    {
-	      ++fb_label_instances[i - fb_labels];
-	      return;
-	    }			/* if we find it  */
-	}			/* for each existing label  */
-    }
-
-  /* If we get to here, we don't have label listed yet.  */
-
-  if (fb_labels == NULL)
-    {
-      fb_labels = XNEWVEC (fb_ent, FB_LABEL_BUMP_BY);
-      fb_label_instances = XNEWVEC (fb_ent, FB_LABEL_BUMP_BY);
-      fb_label_max = FB_LABEL_BUMP_BY;
-      fb_label_count = FB_LABEL_SPECIAL;
-
-    }
-  else if (fb_label_count == fb_label_max)
-    {
-      fb_label_max += FB_LABEL_BUMP_BY;
-      fb_labels = XRESIZEVEC (fb_ent, fb_labels, fb_label_max);
-      fb_label_instances = XRESIZEVEC (fb_ent, fb_label_instances,
-				       fb_label_max);
-    }				/* if we needed to grow  */
-
-  fb_labels[fb_label_count] = label;
-  fb_label_instances[fb_label_count] = 1;
-  ++fb_label_count;
+  ++local_label_insert (&fb_labels, label)->instance;
 }
 
 static unsigned int
 fb_label_instance (unsigned int label)
 {
-  fb_ent *i;
+  struct local_label_ent *ent;
 
   if (label < FB_LABEL_SPECIAL)
     return (fb_low_counter[label]);
 
-  if (fb_labels != NULL)
-    {
-      for (i = fb_labels + FB_LABEL_SPECIAL;
-	   i < fb_labels + fb_label_count; ++i)
-	{
-	  if (*i == label)
-	    return (fb_label_instances[i - fb_labels]);
-	}
-    }
+  ent = local_label_find (&fb_labels, label);
 
-  /* We didn't find the label, so this must be a reference to the
+  /* If we didn't find the label, this must be a reference to the
      first instance.  */
-  return 0;
+  return ent != NULL ? ent->instance : 0;
 }
 
 /* Caller must copy returned name: we re-use the area for the next name.
@@ -3182,6 +3185,8 @@ void
 symbol_end (void)
 {
   htab_delete (sy_hash);
+  local_label_table_free (&dollar_labels);
+  local_label_table_free (&fb_labels);
 }
 
 void
@@ -1479,22 +1479,68 @@ compress_frag (bool use_zstd, void *ctx, const char *contents, int in_size,
   return total_out_size;
 }
 
-static void
-compress_debug (bfd *abfd, asection *sec, void *xxx ATTRIBUTE_UNUSED)
+/* Whether SEC is a debug section with contents worth compressing.  */
+
+static bool
+compress_debug_p (asection *sec)
 {
-  segment_info_type *seginfo = seg_info (sec);
-  bfd_size_type uncompressed_size = sec->size;
   flagword flags = bfd_section_flags (sec);
 
-  if (seginfo == NULL
-      || uncompressed_size < 32
+  if (seg_info (sec) == NULL
+      || sec->size < 32
       || (flags & SEC_HAS_CONTENTS) == 0)
-    return;
+    return false;
 
   const char *section_name = bfd_section_name (sec);
-  if (!startswith (section_name, ".debug_")
-      && !startswith (section_name, ".gnu.debuglto_.debug_")
-      && !startswith (section_name, ".gnu.linkonce.wi."))
+  return (startswith (section_name, ".debug_")
+	  || startswith (section_name, ".gnu.debuglto_.debug_")
+	  || startswith (section_name, ".gnu.linkonce.wi."));
+}
+
+/* The size of the header of compressed sections in ABFD.  */
+
+static unsigned int
+compress_header_size (bfd *abfd)
+{
+  if ((abfd->flags & BFD_COMPRESS_GABI) == 0)
+    return 12;
+  return bfd_get_compression_header_size (abfd, NULL);
+}
+
+/* Replace the contents of SEC with the COMPRESSED_SIZE bytes in the
+   frags from FIRST to LAST, which start with room for the compression
+   header.  */
+
+static void
+compress_debug_replace (bfd *abfd, asection *sec, fragS *first, fragS *last,
+			bfd_size_type compressed_size)
+{
+  segment_info_type *seginfo = seg_info (sec);
+  const char *section_name = bfd_section_name (sec);
+
+  /* Replace the uncompressed frag list with the compressed frag list.  */
+  seginfo->frchainP->frch_root = first;
+  seginfo->frchainP->frch_last = last;
+
+  /* Update the section size and its name.  */
+  bfd_update_compression_header (abfd, (bfd_byte *) first->fr_literal, sec);
+  bool x = bfd_set_section_size (sec, compressed_size);
+  gas_assert (x);
+  if ((abfd->flags & BFD_COMPRESS_GABI) == 0
+      && section_name[1] == 'd')
+    {
+      char *compressed_name = bfd_debug_name_to_zdebug (abfd, section_name);
+      bfd_rename_section (sec, compressed_name);
+    }
+}
+
+static void
+compress_debug (bfd *abfd, asection *sec, void *xxx ATTRIBUTE_UNUSED)
+{
+  segment_info_type *seginfo = seg_info (sec);
+  bfd_size_type uncompressed_size = sec->size;
+
+  if (!compress_debug_p (sec))
     return;
 
   bool use_zstd = abfd->flags & BFD_COMPRESS_ZSTD;
@@ -1502,11 +1548,7 @@ compress_debug (bfd *abfd, asection *sec, void *xxx ATTRIBUTE_UNUSED)
   if (ctx == NULL)
     return;
 
-  unsigned int header_size;
-  if ((abfd->flags & BFD_COMPRESS_GABI) == 0)
-    header_size = 12;
-  else
-    header_size = bfd_get_compression_header_size (stdoutput, NULL);
+  unsigned int header_size = compress_header_size (abfd);
 
   /* Create a new frag to contain the compression header.  */
   struct obstack *ob = &seginfo->frchainP->frch_obstack;
@@ -1514,7 +1556,6 @@ compress_debug (bfd *abfd, asection *sec, void *xxx ATTRIBUTE_UNUSED)
   fragS *last_newf = first_newf;
   last_newf->fr_type = rs_fill;
   last_newf->fr_fix = header_size;
-  char *header = last_newf->fr_literal;
   bfd_size_type compressed_size = header_size;
 
   /* Stream the frags through the compression engine, adding new frags
@@ -1599,20 +1640,123 @@ compress_debug (bfd *abfd, asection *sec, void *xxx ATTRIBUTE_UNUSED)
   if (compressed_size >= uncompressed_size)
     return;
 
-  /* Replace the uncompressed frag list with the compressed frag list.  */
-  seginfo->frchainP->frch_root = first_newf;
-  seginfo->frchainP->frch_last = last_newf;
+  compress_debug_replace (abfd, sec, first_newf, last_newf, compressed_size);
+}
 
-  /* Update the section size and its name.  */
-  bfd_update_compression_header (abfd, (bfd_byte *) header, sec);
-  bool x = bfd_set_section_size (sec, compressed_size);
-  gas_assert (x);
-  if ((abfd->flags & BFD_COMPRESS_GABI) == 0
-      && section_name[1] == 'd')
+/* Copy the contents of SEC, which must all be in fill frags, into a
+   new buffer.  */
+
+static char *
+compress_debug_contents (asection *sec)
+{
+  segment_info_type *seginfo = seg_info (sec);
+  char *contents = XNEWVEC (char, sec->size);
+  char *p = contents;
+
+  for (fragS *f = seginfo->frchainP->frch_root; f; f = f->fr_next)
     {
-      char *compressed_name = bfd_debug_name_to_zdebug (abfd, section_name);
-      bfd_rename_section (sec, compressed_name);
+      gas_assert (f->fr_type == rs_fill);
+      memcpy (p, f->fr_literal, f->fr_fix);
+      p += f->fr_fix;
+      for (offsetT count = f->fr_offset; f->fr_var && count > 0; count--)
+	{
+	  memcpy (p, f->fr_literal + f->fr_fix, f->fr_var);
+	  p += f->fr_var;
+	}
+    }
+  gas_assert ((bfd_size_type) (p - contents) == sec->size);
+
+  return contents;
+}
+
+/* Compress all the debug sections at once, split into pieces that are
+   compressed on THREADS threads.  Each section is compressed into one
+   zlib stream or a series of zstd frames.  */
+
+static void
+compress_debug_pieces (bfd *abfd, unsigned int threads)
+{
+  bool use_zstd = abfd->flags & BFD_COMPRESS_ZSTD;
+  size_t piece_size = (use_zstd ? COMPRESS_PIECE_SIZE_ZSTD
+		       : COMPRESS_PIECE_SIZE_ZLIB);
+  unsigned int header_size = compress_header_size (abfd);
+  unsigned int nsecs = 0;
+  size_t npieces = 0;
+  asection *sec;
+
+  for (sec = abfd->sections; sec; sec = sec->next)
+    if (compress_debug_p (sec))
+      {
+	nsecs++;
+	npieces += (sec->size + piece_size - 1) / piece_size;
+      }
+  if (nsecs == 0)
+    return;
+
+  asection **secs = XNEWVEC (asection *, nsecs);
+  char **contents = XNEWVEC (char *, nsecs);
+  struct compress_piece *pieces = XCNEWVEC (struct compress_piece, npieces);
+  struct compress_piece *piece = pieces;
+  unsigned int i = 0;
+
+  for (sec = abfd->sections; sec; sec = sec->next)
+    if (compress_debug_p (sec))
+      {
+	secs[i] = sec;
+	contents[i] = compress_debug_contents (sec);
+	for (bfd_size_type offset = 0; offset < sec->size; offset += piece_size)
+	  {
+	    piece->in = contents[i] + offset;
+	    piece->in_size = sec->size - offset;
+	    if (piece->in_size > piece_size)
+	      piece->in_size = piece_size;
+	    if (!use_zstd)
+	      piece->dict_size = offset < 32768 ? offset : 32768;
+	    piece->last = offset + piece->in_size == sec->size;
+	    piece++;
+	  }
+	i++;
+      }
+
+  if (compress_pieces (use_zstd, pieces, npieces, threads))
+    {
+      piece = pieces;
+      for (i = 0; i < nsecs; i++)
+	{
+	  struct compress_piece *first_piece = piece;
+	  bfd_size_type compressed_size = header_size;
+
+	  sec = secs[i];
+	  do
+	    compressed_size += piece->out_size;
+	  while (!piece++->last);
+
+	  /* PR binutils/18087: If compression didn't make the section
+	     smaller, just keep it uncompressed.  */
+	  if (compressed_size >= sec->size)
+	    continue;
+
+	  struct obstack *ob = &seg_info (sec)->frchainP->frch_obstack;
+	  fragS *f = frag_alloc (ob, compressed_size);
+	  f->fr_type = rs_fill;
+	  f->fr_fix = compressed_size;
+	  char *p = f->fr_literal + header_size;
+	  for (struct compress_piece *q = first_piece; q < piece; q++)
+	    {
+	      memcpy (p, q->out, q->out_size);
+	      p += q->out_size;
+	    }
+	  compress_debug_replace (abfd, sec, f, f, compressed_size);
+	}
     }
+
+  for (piece = pieces; piece < pieces + npieces; piece++)
+    free (piece->out);
+  free (pieces);
+  for (i = 0; i < nsecs; i++)
+    free (contents[i]);
+  free (contents);
+  free (secs);
 }
 
 #ifndef md_generate_nops
@@ -2548,7 +2692,12 @@ write_object_file (void)
 	flags = BFD_COMPRESS | BFD_COMPRESS_GABI | BFD_COMPRESS_ZSTD;
       stdoutput->flags |= flags & bfd_applicable_file_flags (stdoutput);
       if ((stdoutput->flags & BFD_COMPRESS) != 0)
-	bfd_map_over_sections (stdoutput, compress_debug, (char *) 0);
+	{
+	  if (flag_compress_debug_threads > 0)
+	    compress_debug_pieces (stdoutput, flag_compress_debug_threads);
+	  else
+	    bfd_map_over_sections (stdoutput, compress_debug, (char *) 0);
+	}
     }
 
   bfd_map_over_sections (stdoutput, write_contents, (char *) 0);
@@ -25,6 +25,7 @@
 #include "target.h"
 #include "record.h"
 #include "symtab.h"
+#include "objfiles.h"
 #include "disasm.h"
 #include "source.h"
 #include "filenames.h"
@@ -544,11 +545,14 @@ ftrace_new_gap (struct btrace_thread_info *btinfo, int errcode,
 
 /* Update the current function segment at the end of the trace in BTINFO with
    respect to the instruction at PC.  This may create new function segments.
+   SECTION, if given, is the section containing PC, as find_pc_section
+   would return it.
    Return the chronologically latest function segment, never NULL.  */
 
 static struct btrace_function *
 ftrace_update_function (struct btrace_thread_info *btinfo,
-			std::optional<CORE_ADDR> pc)
+			std::optional<CORE_ADDR> pc,
+			std::optional<obj_section *> section = {})
 {
   struct minimal_symbol *mfun = nullptr;
   struct symbol *fun = nullptr;
@@ -559,8 +563,10 @@ ftrace_update_function (struct btrace_thread_info *btinfo,
   if (pc.has_value ())
     {
       fun = find_pc_function (*pc);
-      bound_minimal_symbol bmfun = lookup_minimal_symbol_by_pc (*pc);
-      mfun = bmfun.minsym;
+      if (!section.has_value ())
+	mfun = lookup_minimal_symbol_by_pc (*pc).minsym;
+      else if (*section != nullptr)
+	mfun = lookup_minimal_symbol_by_pc_section (*pc, *section).minsym;
 
       if (fun == nullptr && mfun == nullptr)
 	DEBUG_FTRACE ("no symbol at %s", core_addr_to_string_nz (*pc));
@@ -1095,6 +1101,14 @@ btrace_compute_ftrace_bts (struct thread_info *tp,
   else
     level = -btinfo->level;
 
+  /* Look up the sections of all blocks at once.  The instructions of a
+     block are almost always in the section of its first instruction.  */
+  std::vector<CORE_ADDR> begins (blk);
+  std::vector<obj_section *> sections (blk);
+  for (unsigned int i = 0; i < blk; i++)
+    begins[i] = btrace->blocks->at (i).begin;
+  find_pc_sections (begins, sections);
+
   while (blk != 0)
     {
       CORE_ADDR pc;
@@ -1104,6 +1118,14 @@ btrace_compute_ftrace_bts (struct thread_info *tp,
       const btrace_block &block = btrace->blocks->at (blk);
       pc = block.begin;
 
+      obj_section *section = sections[blk];
+      CORE_ADDR section_start = 0, section_end = 0;
+      if (section != nullptr)
+	{
+	  section_start = section->addr ();
+	  section_end = section->endaddr ();
+	}
+
       for (;;)
 	{
 	  struct btrace_function *bfun;
@@ -1123,8 +1145,14 @@ btrace_compute_ftrace_bts (struct thread_info *tp,
 	      break;
 	    }
 
+	  std::optional<obj_section *> pc_section;
+	  if (pc == block.begin
+	      || (section_start <= pc && pc < section_end))
+	    pc_section = section;
+
 	  bfun = ftrace_update_function (btinfo,
-					 std::make_optional<CORE_ADDR> (pc));
+					 std::make_optional<CORE_ADDR> (pc),
+					 pc_section);
 
 	  /* Maintain the function level offset.
 	     For all but the last block, we do it here.  */
@@ -1191,7 +1191,12 @@ gdb_print_insn (struct gdbarch *gdbarch, CORE_ADDR memaddr,
 int
 gdb_insn_length (struct gdbarch *gdbarch, CORE_ADDR addr)
 {
-  return gdb_print_insn (gdbarch, addr, &null_stream, NULL);
+  gdb_disassembler di (gdbarch, &null_stream);
+
+  /* Only the length is wanted, so let the disassembler skip formatting
+     the instruction if it can.  */
+  di.disasm_info ()->flags |= DISASSEMBLE_NO_TEXT;
+  return di.print_insn (addr, nullptr);
 }
 
 /* See disasm.h.  */
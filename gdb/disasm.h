@@ -189,7 +189,11 @@ struct gdb_non_printing_disassembler : public gdb_disassemble_info
 			    nullptr /* print_address_func */,
 			    null_fprintf_func,
 			    null_fprintf_styled_func)
-  { /* Nothing.  */ }
+  {
+    /* Nothing is printed, so the disassembler need not format the
+       instruction text.  */
+    m_di.flags |= DISASSEMBLE_NO_TEXT;
+  }
 
 private:
 
@@ -34,6 +34,13 @@
 #include "gdbarch.h"
 #include "objfiles.h"
 #include "extract-store-integer.h"
+#include "gdbsupport/byte-vector.h"
+#include "gdbsupport/unordered_map.h"
+#if GDB_SELF_TEST
+#include "gdbsupport/scope-exit.h"
+#include "gdbsupport/selftest.h"
+#include "selftest-arch.h"
+#endif
 
 /* This holds gdbarch-specific types used by the DWARF expression
    evaluator.  See comments in execute_stack_op.  */
@@ -1508,6 +1515,459 @@ dwarf_block_to_sp_offset (struct gdbarch *gdbarch, const gdb_byte *buf,
   return 1;
 }
 
+/* Compute the frame base of the current function, as an address, for
+   DW_OP_fbreg.  */
+
+CORE_ADDR
+dwarf_expr_context::frame_base_address ()
+{
+  const gdb_byte *datastart;
+  size_t datalen;
+  CORE_ADDR result;
+
+  /* Rather than create a whole new context, we simply
+     backup the current stack locally and install a new empty stack,
+     then reset it afterwards, effectively erasing whatever the
+     recursive call put there.  */
+  std::vector<dwarf_stack_value> saved_stack = std::move (this->m_stack);
+  this->m_stack.clear ();
+
+  /* FIXME: cagney/2003-03-26: This code should be using
+     get_frame_base_address(), and then implement a dwarf2
+     specific this_base method.  */
+  this->get_frame_base (&datastart, &datalen);
+  eval (datastart, datalen);
+  if (this->m_location == DWARF_VALUE_MEMORY)
+    result = fetch_address (0);
+  else if (this->m_location == DWARF_VALUE_REGISTER)
+    result = read_addr_from_reg (this->m_frame, value_as_long (fetch (0)));
+  else
+    error (_("Not implemented: computing frame "
+	     "base using explicit value operator"));
+
+  /* Restore the content of the original stack.  */
+  this->m_stack = std::move (saved_stack);
+
+  this->m_location = DWARF_VALUE_MEMORY;
+  return result;
+}
+
+/* Read SIZE bytes at ADDR for the DW_OP_deref family, and return them
+   as a value of TYPE.  */
+
+value *
+dwarf_expr_context::deref (CORE_ADDR addr, int size, struct type *type)
+{
+  bfd_endian byte_order
+    = gdbarch_byte_order (this->m_per_objfile->objfile->arch ());
+  gdb_byte *buf = (gdb_byte *) alloca (size);
+
+  this->read_mem (buf, addr, size);
+
+  /* If the size of the object read from memory is different
+     from the type length, we need to zero-extend it.  */
+  if (type->length () != size)
+    {
+      ULONGEST datum = extract_unsigned_integer (buf, size, byte_order);
+
+      buf = (gdb_byte *) alloca (type->length ());
+      store_unsigned_integer (buf, type->length (), byte_order, datum);
+    }
+
+  return value_from_contents_and_address (type, buf, addr);
+}
+
+/* The operations of a compiled DWARF expression.  Each one does the
+   same thing as the DW_OP_* operation, or operations, it was made
+   from, with its operands already decoded.  */
+
+enum dwarf_insn_kind : uint8_t
+{
+  /* Push a constant; DW_OP_lit*, DW_OP_const*.  */
+  DWARF_INSN_CONST,
+  /* Push an address relative to the objfile's text section; DW_OP_addr.  */
+  DWARF_INSN_ADDR,
+  /* The value is in a register; DW_OP_reg*, DW_OP_regx.  */
+  DWARF_INSN_REG,
+  /* Push a register plus an offset; DW_OP_breg*, DW_OP_bregx.  */
+  DWARF_INSN_BREG,
+  /* Push the frame base plus an offset; DW_OP_fbreg.  */
+  DWARF_INSN_FBREG,
+  /* Push the CFA; DW_OP_call_frame_cfa.  */
+  DWARF_INSN_CFA,
+  /* Replace the top of the stack with the memory it points to;
+     DW_OP_deref, DW_OP_deref_size.  */
+  DWARF_INSN_DEREF,
+  /* Add a constant to the top of the stack; DW_OP_plus_uconst.  */
+  DWARF_INSN_PLUS_UCONST,
+  /* The value is the top of the stack; DW_OP_stack_value.  */
+  DWARF_INSN_STACK_VALUE,
+};
+
+/* One operation of a compiled DWARF expression.  */
+
+struct dwarf_insn
+{
+  dwarf_insn_kind kind;
+
+  /* The DW_OP_* this was made from, for error messages.  */
+  dwarf_location_atom op;
+
+  /* The size of the read done by DWARF_INSN_DEREF.  */
+  uint8_t size;
+
+  /* The constant, address or DWARF register number.  */
+  ULONGEST value;
+
+  /* The offset of DWARF_INSN_BREG and DWARF_INSN_FBREG.  */
+  int64_t offset;
+};
+
+/* A DWARF expression compiled by dwarf_compile_expr.  */
+
+struct dwarf_compiled_expr
+{
+  /* A copy of the expression, so that a cache hit can be checked
+     against the bytes actually being evaluated.  */
+  gdb::byte_vector bytes;
+
+  /* The address size the operands were decoded with.  */
+  int addr_size;
+
+  /* The compiled operations.  Empty if the expression uses an
+     operation that is not compiled, in which case it is always
+     interpreted.  */
+  std::vector<dwarf_insn> insns;
+};
+
+/* Compile the DWARF expression between OP_PTR and OP_END, with
+   addresses of ADDR_SIZE bytes in BYTE_ORDER, into INSNS.  Only the
+   operations seen in the bulk of location expressions and frame bases
+   are handled.  Return false if the expression uses anything else, or
+   is malformed in any way, so that the interpreter can deal with it
+   and report any error just as it always did.  */
+
+static bool
+dwarf_compile_expr (const gdb_byte *op_ptr, const gdb_byte *op_end,
+		    int addr_size, bfd_endian byte_order,
+		    std::vector<dwarf_insn> &insns)
+{
+  while (op_ptr < op_end)
+    {
+      dwarf_location_atom op = (dwarf_location_atom) *op_ptr++;
+      dwarf_insn insn {};
+      uint64_t uoffset;
+      int64_t offset;
+      int size = 0;
+      bool is_signed = false;
+
+      insn.op = op;
+      if (op >= DW_OP_lit0 && op <= DW_OP_lit31)
+	{
+	  insn.kind = DWARF_INSN_CONST;
+	  insn.value = op - DW_OP_lit0;
+	  insns.push_back (insn);
+	  continue;
+	}
+      else if (op >= DW_OP_reg0 && op <= DW_OP_reg31)
+	{
+	  /* Pieces are left to the interpreter.  */
+	  if (op_ptr != op_end)
+	    return false;
+	  insn.kind = DWARF_INSN_REG;
+	  insn.value = op - DW_OP_reg0;
+	  insns.push_back (insn);
+	  continue;
+	}
+      else if (op >= DW_OP_breg0 && op <= DW_OP_breg31)
+	{
+	  op_ptr = gdb_read_sleb128 (op_ptr, op_end, &insn.offset);
+	  if (op_ptr == nullptr)
+	    return false;
+	  insn.kind = DWARF_INSN_BREG;
+	  insn.value = op - DW_OP_breg0;
+	  insns.push_back (insn);
+	  continue;
+	}
+
+      switch (op)
+	{
+	case DW_OP_addr:
+	  if (op_end - op_ptr < addr_size)
+	    return false;
+	  insn.kind = DWARF_INSN_ADDR;
+	  insn.value = extract_unsigned_integer (op_ptr, addr_size,
+						 byte_order);
+	  op_ptr += addr_size;
+	  /* The DW_OP_GNU_push_tls_address special case of the
+	     interpreter is left to the interpreter.  */
+	  if (op_ptr < op_end && *op_ptr == DW_OP_GNU_push_tls_address)
+	    return false;
+	  break;
+
+	case DW_OP_const1s:
+	case DW_OP_const2s:
+	case DW_OP_const4s:
+	case DW_OP_const8s:
+	  is_signed = true;
+	  [[fallthrough]];
+	case DW_OP_const1u:
+	case DW_OP_const2u:
+	case DW_OP_const4u:
+	case DW_OP_const8u:
+	  if (op == DW_OP_const1u || op == DW_OP_const1s)
+	    size = 1;
+	  else if (op == DW_OP_const2u || op == DW_OP_const2s)
+	    size = 2;
+	  else if (op == DW_OP_const4u || op == DW_OP_const4s)
+	    size = 4;
+	  else
+	    size = 8;
+	  if (op_end - op_ptr < size)
+	    return false;
+	  insn.kind = DWARF_INSN_CONST;
+	  if (is_signed)
+	    insn.value = extract_signed_integer (op_ptr, size, byte_order);
+	  else
+	    insn.value = extract_unsigned_integer (op_ptr, size, byte_order);
+	  op_ptr += size;
+	  break;
+
+	case DW_OP_constu:
+	  op_ptr = gdb_read_uleb128 (op_ptr, op_end, &uoffset);
+	  if (op_ptr == nullptr)
+	    return false;
+	  insn.kind = DWARF_INSN_CONST;
+	  insn.value = uoffset;
+	  break;
+
+	case DW_OP_consts:
+	  op_ptr = gdb_read_sleb128 (op_ptr, op_end, &offset);
+	  if (op_ptr == nullptr)
+	    return false;
+	  insn.kind = DWARF_INSN_CONST;
+	  insn.value = offset;
+	  break;
+
+	case DW_OP_regx:
+	  op_ptr = gdb_read_uleb128 (op_ptr, op_end, &uoffset);
+	  if (op_ptr == nullptr || op_ptr != op_end)
+	    return false;
+	  insn.kind = DWARF_INSN_REG;
+	  insn.value = uoffset;
+	  break;
+
+	case DW_OP_bregx:
+	  op_ptr = gdb_read_uleb128 (op_ptr, op_end, &uoffset);
+	  if (op_ptr == nullptr)
+	    return false;
+	  op_ptr = gdb_read_sleb128 (op_ptr, op_end, &insn.offset);
+	  if (op_ptr == nullptr)
+	    return false;
+	  insn.kind = DWARF_INSN_BREG;
+	  insn.value = uoffset;
+	  break;
+
+	case DW_OP_fbreg:
+	  op_ptr = gdb_read_sleb128 (op_ptr, op_end, &insn.offset);
+	  if (op_ptr == nullptr)
+	    return false;
+	  insn.kind = DWARF_INSN_FBREG;
+	  break;
+
+	case DW_OP_call_frame_cfa:
+	  insn.kind = DWARF_INSN_CFA;
+	  break;
+
+	case DW_OP_deref:
+	  insn.kind = DWARF_INSN_DEREF;
+	  insn.size = addr_size;
+	  break;
+
+	case DW_OP_deref_size:
+	  if (op_ptr >= op_end)
+	    return false;
+	  insn.kind = DWARF_INSN_DEREF;
+	  insn.size = *op_ptr++;
+	  break;
+
+	case DW_OP_plus_uconst:
+	  op_ptr = gdb_read_uleb128 (op_ptr, op_end, &uoffset);
+	  if (op_ptr == nullptr)
+	    return false;
+	  insn.kind = DWARF_INSN_PLUS_UCONST;
+	  insn.value = uoffset;
+	  break;
+
+	case DW_OP_stack_value:
+	  if (op_ptr != op_end)
+	    return false;
+	  insn.kind = DWARF_INSN_STACK_VALUE;
+	  break;
+
+	case DW_OP_nop:
+	  continue;
+
+	default:
+	  return false;
+	}
+
+      insns.push_back (insn);
+    }
+
+  return !insns.empty ();
+}
+
+/* Whether compiled DWARF expressions are cached and used.  */
+
+static bool dwarf_expr_cache_enabled = true;
+
+/* Cap on the number of expressions cached for one objfile.  The
+   cache is emptied when it is reached.  */
+
+#define DWARF_EXPR_CACHE_MAX 65536
+
+/* The compiled DWARF expressions of an objfile, by the address of
+   their first byte.  The entries are shared with the evaluations
+   running them, since an evaluation can start others that replace or
+   drop entries.  */
+
+struct dwarf_expr_cache
+{
+  gdb::unordered_map<const gdb_byte *,
+		     std::shared_ptr<const dwarf_compiled_expr>> exprs;
+};
+
+static const registry<objfile>::key<dwarf_expr_cache> dwarf_expr_cache_key;
+
+/* Return the compiled form of the expression between OP_PTR and
+   OP_END, compiling and caching it the first time it is seen.  Return
+   NULL if the expression has to be interpreted.  */
+
+std::shared_ptr<const dwarf_compiled_expr>
+dwarf_expr_context::lookup_compiled (const gdb_byte *op_ptr,
+				     const gdb_byte *op_end)
+{
+  if (!dwarf_expr_cache_enabled || op_ptr >= op_end)
+    return nullptr;
+
+  objfile *objf = this->m_per_objfile->objfile;
+  dwarf_expr_cache *cache = dwarf_expr_cache_key.get (objf);
+  if (cache == nullptr)
+    cache = dwarf_expr_cache_key.emplace (objf);
+
+  size_t len = op_end - op_ptr;
+  auto it = cache->exprs.find (op_ptr);
+  if (it != cache->exprs.end ())
+    {
+      const dwarf_compiled_expr *expr = it->second.get ();
+
+      /* Expressions not in the objfile's sections, for instance ones
+	 built by GDB itself, can reuse an address.  Those are compiled
+	 again below, replacing the old entry.  */
+      if (expr->addr_size == this->m_addr_size
+	  && expr->bytes.size () == len
+	  && memcmp (expr->bytes.data (), op_ptr, len) == 0)
+	{
+	  if (expr->insns.empty ())
+	    return nullptr;
+	  return it->second;
+	}
+    }
+  else if (cache->exprs.size () >= DWARF_EXPR_CACHE_MAX)
+    cache->exprs.clear ();
+
+  auto expr = std::make_shared<dwarf_compiled_expr> ();
+  expr->bytes.assign (op_ptr, op_end);
+  expr->addr_size = this->m_addr_size;
+  if (!dwarf_compile_expr (op_ptr, op_end, this->m_addr_size,
+			   gdbarch_byte_order (objf->arch ()), expr->insns))
+    expr->insns.clear ();
+
+  cache->exprs[op_ptr] = expr;
+  if (expr->insns.empty ())
+    return nullptr;
+  return expr;
+}
+
+/* Evaluate the compiled expression EXPR.  This must have the same
+   effect as interpreting the expression it was compiled from.  */
+
+void
+dwarf_expr_context::execute_compiled (const dwarf_compiled_expr &expr)
+{
+  type *address_type = this->address_type ();
+
+  for (const dwarf_insn &insn : expr.insns)
+    {
+      CORE_ADDR result;
+
+      switch (insn.kind)
+	{
+	case DWARF_INSN_CONST:
+	  push (value_from_ulongest (address_type, insn.value), false);
+	  break;
+
+	case DWARF_INSN_ADDR:
+	  result = (insn.value
+		    + this->m_per_objfile->objfile->text_section_offset ());
+	  push (value_from_ulongest (address_type, result), false);
+	  break;
+
+	case DWARF_INSN_REG:
+	  push (value_from_ulongest (address_type, insn.value), false);
+	  this->m_location = DWARF_VALUE_REGISTER;
+	  break;
+
+	case DWARF_INSN_BREG:
+	  ensure_have_frame (this->m_frame, (insn.op == DW_OP_bregx
+					     ? "DW_OP_bregx" : "DW_OP_breg"));
+	  result = read_addr_from_reg (this->m_frame, insn.value);
+	  result += insn.offset;
+	  push (value_from_ulongest (address_type, result), false);
+	  break;
+
+	case DWARF_INSN_FBREG:
+	  result = frame_base_address () + insn.offset;
+	  push (value_from_ulongest (address_type, result), true);
+	  break;
+
+	case DWARF_INSN_CFA:
+	  ensure_have_frame (this->m_frame, "DW_OP_call_frame_cfa");
+	  result = dwarf2_frame_cfa (this->m_frame);
+	  push (value_from_ulongest (address_type, result), true);
+	  break;
+
+	case DWARF_INSN_DEREF:
+	  {
+	    CORE_ADDR addr = fetch_address (0);
+
+	    pop ();
+	    push (deref (addr, insn.size, address_type), false);
+	  }
+	  break;
+
+	case DWARF_INSN_PLUS_UCONST:
+	  {
+	    value *val = fetch (0);
+
+	    pop ();
+	    dwarf_require_integral (val->type ());
+	    result = value_as_long (val) + insn.value;
+	    push (value_from_ulongest (address_type, result), false);
+	  }
+	  break;
+
+	case DWARF_INSN_STACK_VALUE:
+	  this->m_location = DWARF_VALUE_STACK;
+	  break;
+
+	default:
+	  gdb_assert_not_reached ("invalid compiled DWARF operation");
+	}
+    }
+}
+
 /* The engine for the expression evaluator.  Using the context in this
    object, evaluate the expression between OP_PTR and OP_END.  */
 
@@ -1534,6 +1994,16 @@ dwarf_expr_context::execute_stack_op (const gdb_byte *op_ptr,
 	   this->m_recursion_depth);
   this->m_recursion_depth++;
 
+  /* Expressions are compiled the first time they are seen, if they
+     can be, and later evaluations just run the compiled form.  */
+  std::shared_ptr<const dwarf_compiled_expr> compiled
+    = lookup_compiled (op_ptr, op_end);
+  if (compiled != nullptr)
+    {
+      execute_compiled (*compiled);
+      op_ptr = op_end;
+    }
+
   while (op_ptr < op_end)
     {
       dwarf_location_atom op = (dwarf_location_atom) *op_ptr++;
@@ -1826,39 +2296,11 @@ dwarf_expr_context::execute_stack_op (const gdb_byte *op_ptr,
 	  break;
 	case DW_OP_fbreg:
 	  {
-	    const gdb_byte *datastart;
-	    size_t datalen;
-
 	    op_ptr = safe_read_sleb128 (op_ptr, op_end, &offset);
 
-	    /* Rather than create a whole new context, we simply
-	       backup the current stack locally and install a new empty stack,
-	       then reset it afterwards, effectively erasing whatever the
-	       recursive call put there.  */
-	    std::vector<dwarf_stack_value> saved_stack = std::move (this->m_stack);
-	    this->m_stack.clear ();
-
-	    /* FIXME: cagney/2003-03-26: This code should be using
-	       get_frame_base_address(), and then implement a dwarf2
-	       specific this_base method.  */
-	    this->get_frame_base (&datastart, &datalen);
-	    eval (datastart, datalen);
-	    if (this->m_location == DWARF_VALUE_MEMORY)
-	      result = fetch_address (0);
-	    else if (this->m_location == DWARF_VALUE_REGISTER)
-	      result
-		= read_addr_from_reg (this->m_frame, value_as_long (fetch (0)));
-	    else
-	      error (_("Not implemented: computing frame "
-		       "base using explicit value operator"));
-	    result = result + offset;
+	    result = frame_base_address () + offset;
 	    result_val = value_from_ulongest (address_type, result);
 	    in_stack_memory = true;
-
-	    /* Restore the content of the original stack.  */
-	    this->m_stack = std::move (saved_stack);
-
-	    this->m_location = DWARF_VALUE_MEMORY;
 	  }
 	  break;
 
@@ -1917,7 +2359,6 @@ dwarf_expr_context::execute_stack_op (const gdb_byte *op_ptr,
 	case DW_OP_GNU_deref_type:
 	  {
 	    int addr_size = (op == DW_OP_deref ? this->m_addr_size : *op_ptr++);
-	    gdb_byte *buf = (gdb_byte *) alloca (addr_size);
 	    CORE_ADDR addr = fetch_address (0);
 	    struct type *type;
 
@@ -1932,21 +2373,7 @@ dwarf_expr_context::execute_stack_op (const gdb_byte *op_ptr,
 	    else
 	      type = address_type;
 
-	    this->read_mem (buf, addr, addr_size);
-
-	    /* If the size of the object read from memory is different
-	       from the type length, we need to zero-extend it.  */
-	    if (type->length () != addr_size)
-	      {
-		ULONGEST datum =
-		  extract_unsigned_integer (buf, addr_size, byte_order);
-
-		buf = (gdb_byte *) alloca (type->length ());
-		store_unsigned_integer (buf, type->length (),
-					byte_order, datum);
-	      }
-
-	    result_val = value_from_contents_and_address (type, buf, addr);
+	    result_val = deref (addr, addr_size, type);
 	    break;
 	  }
 
@@ -2417,3 +2844,147 @@ dwarf_expr_context::execute_stack_op (const gdb_byte *op_ptr,
   this->m_recursion_depth--;
   gdb_assert (this->m_recursion_depth >= 0);
 }
+
+/* Implement "maint show dwarf expression-cache".  */
+
+static void
+show_dwarf_expr_cache_enabled (struct ui_file *file, int from_tty,
+			       struct cmd_list_element *c, const char *value)
+{
+  gdb_printf (file,
+	      _("Whether DWARF expressions are compiled and "
+		"cached is %s.\n"),
+	      value);
+}
+
+#if GDB_SELF_TEST
+
+namespace selftests {
+
+/* Evaluate the DWARF expression EXPR, LEN bytes long, as a location in
+   PER_OBJFILE with no frame, and describe the result or error as a
+   string.  */
+
+static std::string
+eval_dwarf_expr (dwarf2_per_objfile *per_objfile, const gdb_byte *expr,
+		 size_t len)
+{
+  try
+    {
+      dwarf_expr_context ctx (per_objfile, 4);
+      value *val = ctx.evaluate (expr, len, true, nullptr, nullptr);
+
+      if (val->lval () == lval_memory)
+	return string_printf ("memory %s",
+			      paddress (per_objfile->objfile->arch (),
+					val->address ()));
+      return string_printf ("value %s", plongest (value_as_long (val)));
+    }
+  catch (const gdb_exception_error &ex)
+    {
+      return string_printf ("error %s", ex.what ());
+    }
+}
+
+/* Check that compiled DWARF expressions evaluate to the same thing as
+   the interpreter, both when first compiled and when found in the
+   cache.  */
+
+static void
+dwarf_expr_cache_test (struct gdbarch *gdbarch)
+{
+  static const struct
+  {
+    /* Whether dwarf_compile_expr should handle the expression.  */
+    bool compiled;
+    size_t len;
+    gdb_byte expr[8];
+  } tests[] =
+    {
+      { true, 3, { DW_OP_lit5, DW_OP_plus_uconst, 3 } },
+      { true, 4, { DW_OP_lit5, DW_OP_plus_uconst, 3, DW_OP_stack_value } },
+      { true, 4, { DW_OP_const2s, 0xfe, 0xff, DW_OP_stack_value } },
+      { true, 5, { DW_OP_addr, 0x10, 0x20, 0x30, 0x40 } },
+      { true, 6, { DW_OP_constu, 0x80, 0x01, DW_OP_consts, 0x7f,
+		   DW_OP_stack_value } },
+      { true, 3, { DW_OP_nop, DW_OP_lit1, DW_OP_nop } },
+      { true, 2, { DW_OP_breg7, 0x10 } },
+      { true, 1, { DW_OP_call_frame_cfa } },
+      { true, 2, { DW_OP_plus_uconst, 1 } },
+      { true, 1, { DW_OP_reg3 } },
+      { false, 2, { DW_OP_stack_value, DW_OP_lit1 } },
+      { false, 3, { DW_OP_lit1, DW_OP_lit2, DW_OP_plus } },
+      { false, 2, { DW_OP_reg3, DW_OP_lit0 } },
+      { false, 2, { DW_OP_const4u, 0x10 } },
+    };
+
+  objfile *objf = objfile::make (nullptr, current_program_space,
+				 "<dwarf_expr_cache test>", OBJF_NOT_FILENAME);
+  SCOPE_EXIT { objf->unlink (); };
+  objf->section_offsets.push_back (0x1000);
+  objf->sect_index_text = 0;
+  objf->per_bfd->gdbarch = gdbarch;
+
+  dwarf2_per_objfile per_objfile (objf, nullptr);
+  scoped_restore restore_enabled
+    = make_scoped_restore (&dwarf_expr_cache_enabled);
+
+  for (const auto &test : tests)
+    {
+      std::vector<dwarf_insn> insns;
+
+      SELF_CHECK (dwarf_compile_expr (test.expr, test.expr + test.len, 4,
+				      gdbarch_byte_order (gdbarch), insns)
+		  == test.compiled);
+
+      /* Register locations cannot be fetched without a frame.  */
+      if (test.expr[0] == DW_OP_reg3)
+	continue;
+
+      dwarf_expr_cache_enabled = false;
+      std::string expected = eval_dwarf_expr (&per_objfile, test.expr,
+					      test.len);
+      dwarf_expr_cache_enabled = true;
+      SELF_CHECK (eval_dwarf_expr (&per_objfile, test.expr, test.len)
+		  == expected);
+      SELF_CHECK (eval_dwarf_expr (&per_objfile, test.expr, test.len)
+		  == expected);
+    }
+
+  /* A different expression at a cached address replaces the entry.  */
+  gdb_byte buf[3] = { DW_OP_lit5, DW_OP_plus_uconst, 3 };
+  eval_dwarf_expr (&per_objfile, buf, 3);
+  buf[0] = DW_OP_lit7;
+  dwarf_expr_cache_enabled = false;
+  std::string expected = eval_dwarf_expr (&per_objfile, buf, 3);
+  dwarf_expr_cache_enabled = true;
+  SELF_CHECK (eval_dwarf_expr (&per_objfile, buf, 3) == expected);
+  const dwarf_compiled_expr *entry
+    = dwarf_expr_cache_key.get (objf)->exprs.at (buf).get ();
+  SELF_CHECK (entry->bytes[0] == DW_OP_lit7 && !entry->insns.empty ());
+}
+
+} /* namespace selftests */
+#endif /* GDB_SELF_TEST */
+
+void _initialize_dwarf2expr ();
+void
+_initialize_dwarf2expr ()
+{
+  add_setshow_boolean_cmd ("expression-cache", class_maintenance,
+			   &dwarf_expr_cache_enabled, _("\
+Set whether DWARF expressions are compiled and cached."), _("\
+Show whether DWARF expressions are compiled and cached."), _("\
+When enabled, the common DWARF location expressions are decoded once,\n\
+the first time they are evaluated, and later evaluations run the\n\
+decoded form instead of interpreting the expression again."),
+			   NULL,
+			   show_dwarf_expr_cache_enabled,
+			   &set_dwarf_cmdlist,
+			   &show_dwarf_cmdlist);
+
+#if GDB_SELF_TEST
+  selftests::register_test_foreach_arch ("dwarf_expr_cache",
+					 selftests::dwarf_expr_cache_test);
+#endif
+}
@@ -27,6 +27,7 @@
 #include "dwarf2.h"
 
 struct dwarf2_per_objfile;
+struct dwarf_compiled_expr;
 
 /* The location of a value.  */
 enum dwarf_value_location
@@ -214,6 +215,11 @@ struct dwarf_expr_context
   bool stack_empty_p () const;
   void add_piece (ULONGEST size, ULONGEST offset, enum dwarf_location_atom op);
   void execute_stack_op (const gdb_byte *op_ptr, const gdb_byte *op_end);
+  std::shared_ptr<const dwarf_compiled_expr> lookup_compiled
+    (const gdb_byte *op_ptr, const gdb_byte *op_end);
+  void execute_compiled (const dwarf_compiled_expr &expr);
+  CORE_ADDR frame_base_address ();
+  value *deref (CORE_ADDR addr, int size, struct type *type);
   void pop ();
   struct value *fetch (int n);
   CORE_ADDR fetch_address (int n);
@@ -168,6 +168,13 @@ struct extension_language_ops
      const struct value_print_options *options,
      const struct language_defn *language);
 
+  /* Say whether apply_val_pretty_printer would find a pretty-printer
+     for VAL, without printing anything.  Returns EXT_LANG_RC_OK if a
+     pretty-printer was found, EXT_LANG_RC_NOP if none was, and
+     EXT_LANG_RC_ERROR if an error was encountered looking for one.  */
+  enum ext_lang_rc (*val_pretty_printer_p)
+    (const struct extension_language_defn *, struct value *val);
+
   /* GDB access to the "frame filter" feature.
      FRAME is the source frame to start frame-filter invocation.  FLAGS is an
      integer holding the flags for printing.  The following elements of
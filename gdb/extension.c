@@ -494,6 +494,26 @@ apply_ext_lang_val_pretty_printer (struct value *val,
   return 0;
 }
 
+/* Return true if apply_ext_lang_val_pretty_printer might print VAL,
+   that is, if an extension language has a pretty-printer for VAL, fails
+   looking for one, or cannot say.  Nothing is printed.  */
+
+bool
+ext_lang_val_has_pretty_printer (struct value *val)
+{
+  for (const struct extension_language_defn *extlang : extension_languages)
+    {
+      if (extlang->ops == nullptr
+	  || extlang->ops->apply_val_pretty_printer == nullptr)
+	continue;
+      if (extlang->ops->val_pretty_printer_p == nullptr
+	  || extlang->ops->val_pretty_printer_p (extlang, val) != EXT_LANG_RC_NOP)
+	return true;
+    }
+
+  return false;
+}
+
 /* GDB access to the "frame filter" feature.
    FRAME is the source frame to start frame-filter invocation.  FLAGS is an
    integer holding the flags for printing.  The following elements of
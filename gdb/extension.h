@@ -299,6 +299,8 @@ extern int apply_ext_lang_val_pretty_printer
    const struct value_print_options *options,
    const struct language_defn *language);
 
+extern bool ext_lang_val_has_pretty_printer (struct value *val);
+
 extern enum ext_lang_bt_status apply_ext_lang_frame_filter
   (const frame_info_ptr &frame, frame_filter_flags flags,
    enum ext_lang_frame_args args_type,
@@ -22,12 +22,59 @@
 #include "gdbsupport/gdb_proc_service.h"
 
 struct thread_info;
+struct ps_read_cache;
 
 /* GDB specific structure that identifies the target process.  */
 struct ps_prochandle
 {
   /* The LWP we use for memory reads.  */
   thread_info *thread;
+
+  /* If non-NULL, memory reads are served from this cache.  See
+     scoped_ps_read_cache.  */
+  ps_read_cache *read_cache;
+};
+
+/* Counters describing the memory reads made through a
+   scoped_ps_read_cache.  */
+
+struct ps_read_stats
+{
+  /* Number of ps_pdread calls.  */
+  unsigned long reads;
+
+  /* How many of those were served entirely from the cache.  */
+  unsigned long hits;
+
+  /* Number of reads actually sent to the target.  */
+  unsigned long target_reads;
+};
+
+/* libthread_db reads the fields of each thread descriptor with a
+   separate ps_pdread call, each of which is a separate target memory
+   access.  While an object of this type is alive, reads made through
+   PH are instead served from page-sized chunks of memory, each read
+   from the target in one go.  Writes through PH invalidate the
+   cache.
+
+   The cache assumes the memory does not change under its feet, so
+   only use this while the threads of the process are stopped.  */
+
+class scoped_ps_read_cache
+{
+public:
+  explicit scoped_ps_read_cache (ps_prochandle *ph);
+  ~scoped_ps_read_cache ();
+
+  DISABLE_COPY_AND_ASSIGN (scoped_ps_read_cache);
+
+  /* Return the counters accumulated so far.  */
+  const ps_read_stats &stats () const;
+
+private:
+  ps_prochandle *m_ph;
+  ps_read_cache *m_saved_cache;
+  std::unique_ptr<ps_read_cache> m_cache;
 };
 
 #endif /* GDB_GDB_PROC_SERVICE_H */
@@ -633,6 +633,9 @@ extern enum ext_lang_rc gdbscm_apply_val_pretty_printer
    const struct value_print_options *options,
    const struct language_defn *language);
 
+extern enum ext_lang_rc gdbscm_val_pretty_printer_p
+  (const struct extension_language_defn *, struct value *val);
+
 extern int gdbscm_breakpoint_has_cond (const struct extension_language_defn *,
 				       struct breakpoint *b);
 
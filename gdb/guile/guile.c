@@ -122,6 +122,7 @@ static const struct extension_language_ops guile_extension_ops =
   NULL, /* gdbscm_free_type_printers, */
 
   gdbscm_apply_val_pretty_printer,
+  gdbscm_val_pretty_printer_p,
 
   NULL, /* gdbscm_apply_frame_filter, */
   NULL, /* gdbscm_load_ptwrite_filter, */
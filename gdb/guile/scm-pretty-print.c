@@ -1032,6 +1032,28 @@ gdbscm_apply_val_pretty_printer (const struct extension_language_defn *extlang,
     ppscm_print_exception_unless_memory_error (exception, stream);
   return result;
 }
+
+/* This is the extension_language_ops.val_pretty_printer_p "method".
+   Errors are not printed here: the caller is expected to go on and
+   print VALUE, which reports them.  */
+
+enum ext_lang_rc
+gdbscm_val_pretty_printer_p (const struct extension_language_defn *extlang,
+			     struct value *value)
+{
+  if (!gdb_scheme_initialized)
+    return EXT_LANG_RC_NOP;
+
+  SCM val_obj = vlscm_scm_from_value_no_release (value);
+  if (gdbscm_is_exception (val_obj))
+    return EXT_LANG_RC_ERROR;
+
+  SCM printer = ppscm_find_pretty_printer (val_obj);
+  if (gdbscm_is_exception (printer))
+    return EXT_LANG_RC_ERROR;
+
+  return gdbscm_is_false (printer) ? EXT_LANG_RC_NOP : EXT_LANG_RC_OK;
+}
 
 /* Initialize the Scheme pretty-printer code.  */
 
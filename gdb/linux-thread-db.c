@@ -46,6 +46,7 @@
 #include <ctype.h>
 #include "nat/linux-namespaces.h"
 #include <algorithm>
+#include <chrono>
 #include "gdbsupport/pathstuff.h"
 #include "valprint.h"
 #include "cli/cli-style.h"
@@ -201,6 +202,14 @@ struct thread_db_info
   td_thr_get_info_ftype *td_thr_get_info_p;
   td_thr_tls_get_addr_ftype *td_thr_tls_get_addr_p;
   td_thr_tlsbase_ftype *td_thr_tlsbase_p;
+
+  /* Statistics about the last bulk thread discovery, shown by
+     "maintenance info libthread-db".  DISCOVERY_METHOD is NULL if
+     there has not been any yet.  */
+  const char *discovery_method;
+  unsigned long discovery_threads;
+  long discovery_usecs;
+  ps_read_stats discovery_reads;
 };
 
 /* List of known processes using thread_db, and the required
@@ -922,9 +931,27 @@ try_thread_db_load_1 (struct thread_db_info *info)
 
       linux_stop_and_wait_all_lwps ();
 
-      for (const lwp_info *lp : all_lwps ())
-	if (lp->ptid.pid () == pid)
-	  thread_from_lwp (curr_thread, lp->ptid);
+      {
+	/* Everything is stopped, so batch the many small reads
+	   libthread_db makes for each thread descriptor.  */
+	auto start = std::chrono::steady_clock::now ();
+	scoped_ps_read_cache read_cache (&info->proc_handle);
+	unsigned long count = 0;
+
+	for (const lwp_info *lp : all_lwps ())
+	  if (lp->ptid.pid () == pid)
+	    {
+	      thread_from_lwp (curr_thread, lp->ptid);
+	      count++;
+	    }
+
+	info->discovery_method = "LWP list";
+	info->discovery_threads = count;
+	info->discovery_reads = read_cache.stats ();
+	info->discovery_usecs
+	  = std::chrono::duration_cast<std::chrono::microseconds>
+	      (std::chrono::steady_clock::now () - start).count ();
+      }
 
       linux_unstop_all_lwps ();
     }
@@ -1452,6 +1479,7 @@ thread_db_target::follow_exec (inferior *follow_inf, ptid_t ptid,
 struct callback_data
 {
   struct thread_db_info *info;
+  int threads;
   int new_threads;
 };
 
@@ -1464,6 +1492,8 @@ find_new_threads_callback (const td_thrhandle_t *th_p, void *data)
   struct callback_data *cb_data = (struct callback_data *) data;
   struct thread_db_info *info = cb_data->info;
 
+  cb_data->threads++;
+
   err = info->td_thr_get_info_p (th_p, &ti);
   if (err != TD_OK)
     error (_("find_new_threads_callback: cannot get thread info: %s"),
@@ -1529,11 +1559,20 @@ find_new_threads_once (struct thread_db_info *info, int iteration,
   td_err_e err = TD_ERR;
 
   data.info = info;
+  data.threads = 0;
   data.new_threads = 0;
 
   /* See comment in thread_db_update_thread_list.  */
   gdb_assert (info->td_ta_thr_iter_p != NULL);
 
+  /* Batch the reads of the thread descriptors, unless other threads
+     may be running and changing them.  The cache only lives for this
+     walk, so that later iterations see threads created meanwhile.  */
+  std::optional<scoped_ps_read_cache> read_cache;
+  inferior *inf = info->proc_handle.thread->inf;
+  if (!inf->has_execution () || !target_is_non_stop_p ())
+    read_cache.emplace (&info->proc_handle);
+
   try
     {
       /* Iterate over all user-space threads to discover new threads.  */
@@ -1561,6 +1600,18 @@ find_new_threads_once (struct thread_db_info *info, int iteration,
 		  data.new_threads, iteration);
     }
 
+  /* Each pass sees every thread again; report the largest count, not
+     the sum over the passes.  */
+  info->discovery_threads = std::max (info->discovery_threads,
+				      (unsigned long) data.threads);
+  if (read_cache.has_value ())
+    {
+      const ps_read_stats &stats = read_cache->stats ();
+      info->discovery_reads.reads += stats.reads;
+      info->discovery_reads.hits += stats.hits;
+      info->discovery_reads.target_reads += stats.target_reads;
+    }
+
   if (errp != NULL)
     *errp = err;
 
@@ -1584,6 +1635,11 @@ thread_db_find_new_threads_2 (thread_info *stopped, bool until_no_new)
   /* Access an lwp we know is stopped.  */
   info->proc_handle.thread = stopped;
 
+  auto start = std::chrono::steady_clock::now ();
+  info->discovery_method = "td_ta_thr_iter";
+  info->discovery_threads = 0;
+  info->discovery_reads = {};
+
   if (until_no_new)
     {
       /* Require 4 successive iterations which do not find any new threads.
@@ -1600,6 +1656,10 @@ thread_db_find_new_threads_2 (thread_info *stopped, bool until_no_new)
   else
     find_new_threads_once (info, 0, &err);
 
+  info->discovery_usecs
+    = std::chrono::duration_cast<std::chrono::microseconds>
+	(std::chrono::steady_clock::now () - start).count ();
+
   if (err != TD_OK)
     error (_("Cannot find new threads: %s"), thread_db_err_str (err));
 }
@@ -1984,6 +2044,39 @@ maintenance_check_libthread_db (const char *args, int from_tty)
   check_thread_db (info, true);
 }
 
+/* Implement 'maintenance info libthread-db'.  */
+
+static void
+maintenance_info_libthread_db (const char *args, int from_tty)
+{
+  bool found = false;
+
+  for (thread_db_info *info = thread_db_list; info != nullptr;
+       info = info->next)
+    {
+      found = true;
+      gdb_printf (_("Process %d:\n"), info->pid);
+      if (info->discovery_method == nullptr)
+	{
+	  gdb_printf (_("  No bulk thread discovery done.\n"));
+	  continue;
+	}
+
+      const ps_read_stats &reads = info->discovery_reads;
+      gdb_printf (_("  Last thread discovery: %s, %lu threads"
+		    " in %ld.%06ld seconds\n"),
+		  info->discovery_method, info->discovery_threads,
+		  info->discovery_usecs / 1000000,
+		  info->discovery_usecs % 1000000);
+      gdb_printf (_("  libthread_db reads: %lu, served from cache: %lu,"
+		    " target reads: %lu\n"),
+		  reads.reads, reads.hits, reads.target_reads);
+    }
+
+  if (!found)
+    gdb_printf (_("No libthread_db loaded.\n"));
+}
+
 void _initialize_thread_db ();
 void
 _initialize_thread_db ()
@@ -2038,6 +2131,12 @@ Usage: info auto-load libthread-db"),
 Run integrity checks on the current inferior's libthread_db."),
 	   &maintenancechecklist);
 
+  add_cmd ("libthread-db", class_maintenance,
+	   maintenance_info_libthread_db, _("\
+Show statistics about libthread_db thread discovery.\n\
+Usage: maintenance info libthread-db"),
+	   &maintenanceinfolist);
+
   add_setshow_boolean_cmd ("check-libthread-db",
 			   class_maintenance,
 			   &check_thread_db_on_load, _("\
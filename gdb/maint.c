@@ -40,6 +40,11 @@
 #include "gdbsupport/selftest.h"
 #include "inferior.h"
 #include "gdbsupport/thread-pool.h"
+#include "gdbsupport/event-loop.h"
+#include "gdbsupport/filestuff.h"
+#include "gdbsupport/scope-exit.h"
+#include "ui.h"
+#include <chrono>
 
 #include "cli/cli-decode.h"
 #include "cli/cli-utils.h"
@@ -1220,6 +1225,100 @@ Selftests have been disabled for this build.\n"));
 #endif
 }
 
+#ifndef _WIN32
+
+/* A pipe registered with the event loop by "maintenance
+   test-event-loop".  */
+
+struct test_event_loop_pipe
+{
+  int fds[2];
+
+  /* Counter of the events dispatched by all the pipes.  */
+  int *dispatched;
+};
+
+/* File handler for "maintenance test-event-loop": consume the byte
+   written to the pipe and count the event.  */
+
+static void
+test_event_loop_handler (int error, gdb_client_data client_data)
+{
+  test_event_loop_pipe *p = (test_event_loop_pipe *) client_data;
+  char c;
+
+  if (read (p->fds[0], &c, 1) == 1)
+    ++*p->dispatched;
+}
+
+/* The "maintenance test-event-loop" command.  */
+
+static void
+maintenance_test_event_loop (const char *args, int from_tty)
+{
+  if (args == nullptr || *args == '\0')
+    error_no_arg (_("number of file handlers"));
+
+  int num_handlers = get_number (&args);
+  int num_events = 1000;
+  if (*args != '\0')
+    num_events = get_number (&args);
+  if (num_handlers <= 0 || num_events <= 0 || *args != '\0')
+    error (_("Arguments must be positive numbers."));
+
+  std::vector<test_event_loop_pipe> pipes (num_handlers);
+  size_t num_opened = 0;
+  int dispatched = 0;
+
+  /* Keep the user's input from being processed by the nested event
+     loop below.  */
+  current_ui->unregister_file_handler ();
+
+  SCOPE_EXIT
+    {
+      for (size_t i = 0; i < num_opened; i++)
+	{
+	  delete_file_handler (pipes[i].fds[0]);
+	  close (pipes[i].fds[0]);
+	  close (pipes[i].fds[1]);
+	}
+      current_ui->register_file_handler ();
+    };
+
+  for (test_event_loop_pipe &p : pipes)
+    {
+      if (gdb_pipe_cloexec (p.fds) != 0)
+	perror_with_name (_("Could not create pipe"));
+      num_opened++;
+
+      p.dispatched = &dispatched;
+      add_file_handler (p.fds[0], test_event_loop_handler, &p,
+			"test-event-loop");
+    }
+
+  using namespace std::chrono;
+  steady_clock::time_point start = steady_clock::now ();
+
+  for (int i = 0; i < num_events; i++)
+    {
+      /* Spread the events over all the handlers.  */
+      test_event_loop_pipe &p = pipes[(size_t) i * 7919 % num_handlers];
+      if (write (p.fds[1], "x", 1) != 1)
+	perror_with_name (_("Could not write to pipe"));
+
+      while (dispatched <= i)
+	gdb_do_one_event ();
+    }
+
+  duration<double> elapsed = steady_clock::now () - start;
+  gdb_printf (_("Dispatched %d events to %d file handlers using %s "
+		"in %.6f seconds (%.3f microseconds per event).\n"),
+	      num_events, num_handlers, event_loop_backend_name (),
+	      elapsed.count (), elapsed.count () * 1e6 / num_events);
+}
+
+#endif /* _WIN32 */
+
 
 void _initialize_maint_cmds ();
 void
@@ -1398,6 +1497,17 @@ If nonzero, will cause the execution space for each command to be\n\
 displayed, following the command's output."),
 	   &maintenancelist);
 
+#ifndef _WIN32
+  add_cmd ("test-event-loop", class_maintenance, maintenance_test_event_loop,
+	   _("\
+Measure the dispatch latency of the event loop.\n\
+Usage: maintenance test-event-loop HANDLERS [EVENTS]\n\
+Register HANDLERS pipes with the event loop, make EVENTS of them\n\
+readable one at a time (1000 by default), and report how long the\n\
+event loop took to dispatch each of them."),
+	   &maintenancelist);
+#endif
+
   cmd = add_cmd ("type", class_maintenance, maintenance_print_type, _("\
 Print a type chain for a given symbol.\n\
 For each node in a type chain, print the raw data for each member of\n\
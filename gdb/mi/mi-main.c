@@ -89,8 +89,9 @@ static void mi_execute_async_cli_command (const char *cli_command,
 					  const char *const *argv, int argc);
 static bool register_changed_p (int regnum, readonly_detached_regcache *,
 			       readonly_detached_regcache *);
-static void output_register (const frame_info_ptr &, int regnum, int format,
-			     int skip_unavailable);
+static void output_registers (const frame_info_ptr &,
+			      gdb::array_view<const int> regnums, int format,
+			      int skip_unavailable);
 
 /* Controls whether the frontend wants MI in async mode.  */
 static bool mi_async = false;
@@ -1059,7 +1060,7 @@ mi_cmd_data_list_register_values (const char *command, const char *const *argv,
   gdbarch = get_frame_arch (frame);
   numregs = gdbarch_num_cooked_regs (gdbarch);
 
-  ui_out_emit_list list_emitter (uiout, "register-values");
+  std::vector<int> regnums;
 
   if (argc - oind == 1)
     {
@@ -1071,7 +1072,7 @@ mi_cmd_data_list_register_values (const char *command, const char *const *argv,
 	  if (*(gdbarch_register_name (gdbarch, regnum)) == '\0')
 	    continue;
 
-	  output_register (frame, regnum, format, skip_unavailable);
+	  regnums.push_back (regnum);
 	}
     }
 
@@ -1083,43 +1084,54 @@ mi_cmd_data_list_register_values (const char *command, const char *const *argv,
       if (regnum >= 0
 	  && regnum < numregs
 	  && *gdbarch_register_name (gdbarch, regnum) != '\000')
-	output_register (frame, regnum, format, skip_unavailable);
+	regnums.push_back (regnum);
       else
 	error (_("bad register number"));
     }
+
+  ui_out_emit_list list_emitter (uiout, "register-values");
+  output_registers (frame, regnums, format, skip_unavailable);
 }
 
-/* Output one register REGNUM's contents in the desired FORMAT.  If
-   SKIP_UNAVAILABLE is true, skip the register if it is
-   unavailable.  */
+/* Output the contents of the registers REGNUMS of FRAME in the desired
+   FORMAT.  If SKIP_UNAVAILABLE is true, skip the registers that are
+   unavailable.  The frame lookup, print options and output buffer are
+   set up once and shared by all the registers, which matters for
+   frontends that refresh large register sets on every stop.  */
 
 static void
-output_register (const frame_info_ptr &frame, int regnum, int format,
-		 int skip_unavailable)
+output_registers (const frame_info_ptr &frame,
+		  gdb::array_view<const int> regnums, int format,
+		  int skip_unavailable)
 {
   struct ui_out *uiout = current_uiout;
-  value *val
-    = value_of_register (regnum, get_next_frame_sentinel_okay (frame));
+  frame_info_ptr next_frame = get_next_frame_sentinel_okay (frame);
   struct value_print_options opts;
 
-  if (skip_unavailable && !val->entirely_available ())
-    return;
-
-  ui_out_emit_tuple tuple_emitter (uiout, NULL);
-  uiout->field_signed ("number", regnum);
-
   if (format == 'N')
     format = 0;
 
   if (format == 'r')
     format = 'z';
 
-  string_file stb;
-
   get_formatted_print_options (&opts, format);
   opts.deref_ref = true;
-  common_val_print (val, &stb, 0, &opts, current_language);
-  uiout->field_stream ("value", stb);
+
+  string_file stb;
+
+  for (int regnum : regnums)
+    {
+      value *val = value_of_register (regnum, next_frame);
+
+      if (skip_unavailable && !val->entirely_available ())
+	continue;
+
+      ui_out_emit_tuple tuple_emitter (uiout, NULL);
+      uiout->field_signed ("number", regnum);
+
+      common_val_print (val, &stb, 0, &opts, current_language);
+      uiout->field_stream ("value", stb);
+    }
 }
 
 /* Write given values into registers. The registers and values are
@@ -2661,13 +2673,16 @@ mi_cmd_trace_frame_collected (const char *command, const char *const *argv,
     gdbarch = get_frame_arch (frame);
     numregs = gdbarch_num_cooked_regs (gdbarch);
 
+    std::vector<int> regnums;
     for (regnum = 0; regnum < numregs; regnum++)
       {
 	if (*(gdbarch_register_name (gdbarch, regnum)) == '\0')
 	  continue;
 
-	output_register (frame, regnum, registers_format, 1);
+	regnums.push_back (regnum);
       }
+
+    output_registers (frame, regnums, registers_format, 1);
   }
 
   /* Trace state variables.  */
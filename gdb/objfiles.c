@@ -48,6 +48,8 @@
 #include "gdb_bfd.h"
 #include "btrace.h"
 #include "gdbsupport/pathstuff.h"
+#include "gdbsupport/buildargv.h"
+#include "cli/cli-cmds.h"
 
 #include <algorithm>
 
@@ -56,17 +58,46 @@
 
 struct objfile_pspace_info
 {
-  objfile_pspace_info () = default;
-  ~objfile_pspace_info ();
-
-  struct obj_section **sections = nullptr;
-  int num_sections = 0;
-
-  /* Nonzero if object files have been added since the section map
-     was last updated.  */
-  int new_objfiles_available = 0;
-
-  /* Nonzero if the section map MUST be updated before use.  */
+  /* The section map searched by find_pc_section: sorted by address,
+     with overlapping and separate debuginfo sections filtered out.  */
+  std::vector<obj_section *> sections;
+
+  /* The start and end addresses of SECTIONS, in the same order.  They
+     are what lookups search, without having to compute the addresses
+     of the sections each time.  */
+  std::vector<CORE_ADDR> section_starts;
+  std::vector<CORE_ADDR> section_ends;
+
+  /* Index in SECTIONS of the section found by the last lookup, or -1.
+     Consecutive lookups very often hit the same section.  */
+  int last_hit = -1;
+
+  /* Lookup statistics, shown by "maintenance info section-map".  */
+  unsigned long lookups = 0;
+  unsigned long last_hit_lookups = 0;
+  unsigned long batch_lookups = 0;
+  unsigned long batch_addresses = 0;
+  unsigned long full_updates = 0;
+  unsigned long incremental_updates = 0;
+
+  /* Every section eligible for the map (see insert_section_p) of the
+     objfiles known at the last update, sorted with sort_cmp but not yet
+     filtered.  Keeping this lets objfiles be added and removed without
+     collecting and sorting the sections of all the others again.  */
+  std::vector<obj_section *> candidates;
+
+  /* Object files added since the section map was last updated.  */
+  std::vector<objfile *> new_objfiles;
+
+  /* The section tables [START, END) of object files which were removed
+     since the section map was last updated, and whose sections are
+     still in CANDIDATES.  Only the addresses are compared, the
+     sections themselves are gone.  */
+  std::vector<std::pair<const obj_section *, const obj_section *>>
+    removed_ranges;
+
+  /* Nonzero if the section map MUST be rebuilt from scratch before
+     use.  */
   int section_map_dirty = 0;
 
   /* Nonzero if section map updates should be inhibited if possible.  */
@@ -77,11 +108,6 @@ struct objfile_pspace_info
 static const registry<program_space>::key<objfile_pspace_info>
   objfiles_pspace_data;
 
-objfile_pspace_info::~objfile_pspace_info ()
-{
-  xfree (sections);
-}
-
 /* Get the current svr4 data.  If none is found yet, add it now.  This
    function always returns a valid object.  */
 
@@ -395,8 +421,8 @@ objfile::make (gdb_bfd_ref_ptr bfd_, program_space *pspace, const char *name_,
 
   pspace->add_objfile (std::unique_ptr<objfile> (result), parent);
 
-  /* Rebuild section map next time we need it.  */
-  get_objfile_pspace_data (pspace)->new_objfiles_available = 1;
+  /* Add its sections to the section map next time we need it.  */
+  get_objfile_pspace_data (pspace)->new_objfiles.push_back (result);
 
   return result;
 }
@@ -504,10 +530,18 @@ objfile::~objfile ()
      and if so, call clear_current_source_symtab_and_line.  */
   clear_current_source_symtab_and_line (this);
 
-  /* Rebuild section map next time we need it.  */
+  /* Drop our sections from the section map next time we need it.  If
+     the map is going to be rebuilt anyway, there is nothing to do.  */
   auto info = objfiles_pspace_data.get (pspace ());
-  if (info != nullptr)
-    info->section_map_dirty = 1;
+  if (info != nullptr && !info->section_map_dirty)
+    {
+      auto it = std::find (info->new_objfiles.begin (),
+			   info->new_objfiles.end (), this);
+      if (it != info->new_objfiles.end ())
+	info->new_objfiles.erase (it);
+      else if (sections_start != sections_end)
+	info->removed_ranges.emplace_back (sections_start, sections_end);
+    }
 }
 
 
@@ -975,73 +1009,156 @@ filter_overlapping_sections (struct obj_section **map, int map_size)
 }
 
 
-/* Update PMAP, PMAP_SIZE with sections from all objfiles, excluding any
-   TLS, overlay and overlapping sections.  */
+/* Append to SECTIONS the sections of OBJFILE that belong in the
+   section map.  */
 
 static void
-update_section_map (struct program_space *pspace,
-		    struct obj_section ***pmap, int *pmap_size)
+collect_map_sections (objfile *objfile, std::vector<obj_section *> &sections)
+{
+  for (obj_section *s : objfile->sections ())
+    if (insert_section_p (objfile->obfd.get (), s->the_bfd_section))
+      sections.push_back (s);
+}
+
+/* Return true if the section map of PSPACE_INFO has to be updated
+   before it can be searched.  */
+
+static bool
+section_map_needs_update (const objfile_pspace_info *pspace_info)
+{
+  /* The map may still point to sections of removed objfiles, so those
+     have to be dropped even while updates are inhibited.  */
+  return (pspace_info->section_map_dirty
+	  || !pspace_info->removed_ranges.empty ()
+	  || (!pspace_info->new_objfiles.empty ()
+	      && !pspace_info->inhibit_updates));
+}
+
+/* Update the section map of PSPACE, excluding any TLS, overlay and
+   overlapping sections.  If only objfiles were added or removed since
+   the last update, the sorted candidate sections are patched: removed
+   sections are dropped and the sorted sections of the new objfiles are
+   merged in.  Otherwise, the sections of all objfiles are collected
+   and sorted again.  */
+
+static void
+update_section_map (struct program_space *pspace)
 {
   struct objfile_pspace_info *pspace_info;
-  int alloc_size, map_size, i;
-  struct obj_section **map;
 
   pspace_info = get_objfile_pspace_data (pspace);
-  gdb_assert (pspace_info->section_map_dirty != 0
-	      || pspace_info->new_objfiles_available != 0);
-
-  map = *pmap;
-  xfree (map);
+  gdb_assert (section_map_needs_update (pspace_info));
 
-  alloc_size = 0;
-  for (objfile *objfile : pspace->objfiles ())
-    for (obj_section *s : objfile->sections ())
-      if (insert_section_p (objfile->obfd.get (), s->the_bfd_section))
-	alloc_size += 1;
+  std::vector<obj_section *> &candidates = pspace_info->candidates;
 
-  /* This happens on detach/attach (e.g. in gdb.base/attach.exp).  */
-  if (alloc_size == 0)
+  if (pspace_info->section_map_dirty)
     {
-      *pmap = NULL;
-      *pmap_size = 0;
-      return;
+      pspace_info->full_updates++;
+      candidates.clear ();
+      for (objfile *objfile : pspace->objfiles ())
+	collect_map_sections (objfile, candidates);
+      std::sort (candidates.begin (), candidates.end (), sort_cmp);
     }
+  else
+    {
+      pspace_info->incremental_updates++;
 
-  map = XNEWVEC (struct obj_section *, alloc_size);
+      if (!pspace_info->removed_ranges.empty ())
+	{
+	  /* The removed objfiles were all alive at the same time as the
+	     remaining ones, so their section tables cannot overlap those
+	     of any section left in CANDIDATES.  */
+	  auto &ranges = pspace_info->removed_ranges;
+	  std::sort (ranges.begin (), ranges.end ());
 
-  i = 0;
-  for (objfile *objfile : pspace->objfiles ())
-    for (obj_section *s : objfile->sections ())
-      if (insert_section_p (objfile->obfd.get (), s->the_bfd_section))
-	map[i++] = s;
+	  auto removed_p = [&] (const obj_section *s)
+	    {
+	      auto it = std::upper_bound (ranges.begin (), ranges.end (), s,
+					  [] (const obj_section *sect,
+					      const auto &range)
+					  { return sect < range.first; });
+	      return it != ranges.begin () && s < (it - 1)->second;
+	    };
+
+	  candidates.erase (std::remove_if (candidates.begin (),
+					    candidates.end (), removed_p),
+			    candidates.end ());
+	}
 
-  std::sort (map, map + alloc_size, sort_cmp);
-  map_size = filter_debuginfo_sections(map, alloc_size);
-  map_size = filter_overlapping_sections(map, map_size);
+      if (!pspace_info->new_objfiles.empty ())
+	{
+	  std::vector<obj_section *> added;
+	  for (objfile *objfile : pspace_info->new_objfiles)
+	    collect_map_sections (objfile, added);
+	  std::sort (added.begin (), added.end (), sort_cmp);
+
+	  std::vector<obj_section *> merged;
+	  merged.reserve (candidates.size () + added.size ());
+	  std::merge (candidates.begin (), candidates.end (),
+		      added.begin (), added.end (),
+		      std::back_inserter (merged), sort_cmp);
+	  candidates = std::move (merged);
+	}
+    }
 
-  if (map_size < alloc_size)
-    /* Some sections were eliminated.  Trim excess space.  */
-    map = XRESIZEVEC (struct obj_section *, map, map_size);
-  else
-    gdb_assert (alloc_size == map_size);
+  pspace_info->new_objfiles.clear ();
+  pspace_info->removed_ranges.clear ();
+  pspace_info->section_map_dirty = 0;
+  pspace_info->last_hit = -1;
+
+  std::vector<obj_section *> &map = pspace_info->sections;
+  map = candidates;
+
+  /* This happens on detach/attach (e.g. in gdb.base/attach.exp).  */
+  if (!map.empty ())
+    {
+      int map_size = filter_debuginfo_sections (map.data (), map.size ());
+      map_size = filter_overlapping_sections (map.data (), map_size);
+      map.resize (map_size);
+    }
 
-  *pmap = map;
-  *pmap_size = map_size;
+  pspace_info->section_starts.resize (map.size ());
+  pspace_info->section_ends.resize (map.size ());
+  for (size_t i = 0; i < map.size (); i++)
+    {
+      pspace_info->section_starts[i] = map[i]->addr ();
+      pspace_info->section_ends[i] = map[i]->endaddr ();
+    }
 }
 
-/* Bsearch comparison function.  */
+/* Return the index in the section map of PSPACE_INFO of the section
+   containing PC, or -1 if there is none.  Only search the sections
+   from index FROM onwards.  */
 
 static int
-bsearch_cmp (const void *key, const void *elt)
+find_section_map_index (const objfile_pspace_info *pspace_info,
+			CORE_ADDR pc, size_t from = 0)
 {
-  const CORE_ADDR pc = *(CORE_ADDR *) key;
-  const struct obj_section *section = *(const struct obj_section **) elt;
+  const std::vector<CORE_ADDR> &starts = pspace_info->section_starts;
 
-  if (pc < section->addr ())
+  /* The sections do not overlap, so PC can only be in the last one
+     starting at or below it.  */
+  auto it = std::upper_bound (starts.begin () + from, starts.end (), pc);
+  if (it == starts.begin () + from)
     return -1;
-  if (pc < section->endaddr ())
-    return 0;
-  return 1;
+
+  int idx = it - starts.begin () - 1;
+  if (pc < pspace_info->section_ends[idx])
+    return idx;
+  return -1;
+}
+
+/* Return the section map of the current program space, updating it
+   first if needed.  */
+
+static objfile_pspace_info *
+get_section_map ()
+{
+  objfile_pspace_info *pspace_info
+    = get_objfile_pspace_data (current_program_space);
+  if (section_map_needs_update (pspace_info))
+    update_section_map (current_program_space);
+  return pspace_info;
 }
 
 /* Returns a section whose range includes PC or NULL if none found.   */
@@ -1049,47 +1166,70 @@ bsearch_cmp (const void *key, const void *elt)
 struct obj_section *
 find_pc_section (CORE_ADDR pc)
 {
-  struct objfile_pspace_info *pspace_info;
-  struct obj_section *s, **sp;
+  struct obj_section *s;
 
   /* Check for mapped overlay section first.  */
   s = find_pc_mapped_section (pc);
   if (s)
     return s;
 
-  pspace_info = get_objfile_pspace_data (current_program_space);
-  if (pspace_info->section_map_dirty
-      || (pspace_info->new_objfiles_available
-	  && !pspace_info->inhibit_updates))
-    {
-      update_section_map (current_program_space,
-			  &pspace_info->sections,
-			  &pspace_info->num_sections);
-
-      /* Don't need updates to section map until objfiles are added,
-	 removed or relocated.  */
-      pspace_info->new_objfiles_available = 0;
-      pspace_info->section_map_dirty = 0;
-    }
+  objfile_pspace_info *pspace_info = get_section_map ();
+  pspace_info->lookups++;
 
-  /* The C standard (ISO/IEC 9899:TC2) requires the BASE argument to
-     bsearch be non-NULL.  */
-  if (pspace_info->sections == NULL)
+  int idx = pspace_info->last_hit;
+  if (idx >= 0
+      && pspace_info->section_starts[idx] <= pc
+      && pc < pspace_info->section_ends[idx])
     {
-      gdb_assert (pspace_info->num_sections == 0);
-      return NULL;
+      pspace_info->last_hit_lookups++;
+      return pspace_info->sections[idx];
     }
 
-  sp = (struct obj_section **) bsearch (&pc,
-					pspace_info->sections,
-					pspace_info->num_sections,
-					sizeof (*pspace_info->sections),
-					bsearch_cmp);
-  if (sp != NULL)
-    return *sp;
-  return NULL;
+  idx = find_section_map_index (pspace_info, pc);
+  if (idx < 0)
+    return NULL;
+
+  pspace_info->last_hit = idx;
+  return pspace_info->sections[idx];
 }
 
+/* See objfiles.h.  */
+
+void
+find_pc_sections (gdb::array_view<const CORE_ADDR> pcs,
+		  gdb::array_view<obj_section *> sections)
+{
+  gdb_assert (pcs.size () == sections.size ());
+
+  objfile_pspace_info *pspace_info = get_section_map ();
+  pspace_info->batch_lookups++;
+  pspace_info->batch_addresses += pcs.size ();
+
+  /* Visit the addresses in increasing order, so that the search for
+     each one can start where the previous one ended.  */
+  std::vector<size_t> order (pcs.size ());
+  for (size_t i = 0; i < order.size (); i++)
+    order[i] = i;
+  std::sort (order.begin (), order.end (),
+	     [&] (size_t a, size_t b) { return pcs[a] < pcs[b]; });
+
+  size_t from = 0;
+  for (size_t i : order)
+    {
+      CORE_ADDR pc = pcs[i];
+
+      sections[i] = find_pc_mapped_section (pc);
+      if (sections[i] != nullptr)
+	continue;
+
+      int idx = find_section_map_index (pspace_info, pc, from);
+      if (idx >= 0)
+	{
+	  sections[i] = pspace_info->sections[idx];
+	  from = idx;
+	}
+    }
+}
 
 /* Return non-zero if PC is in a section called NAME.  */
 
@@ -1238,3 +1378,60 @@ objfile_int_type (struct objfile *of, int size_in_bytes, bool unsigned_p)
 
   gdb_assert_not_reached ("unable to find suitable integer type");
 }
+
+/* Implement "maintenance info section-map".  */
+
+static void
+maintenance_info_section_map (const char *args, int from_tty)
+{
+  objfile_pspace_info *pspace_info = get_section_map ();
+
+  gdb_printf (_("Section map of program space %d: %zu sections\n"),
+	      current_program_space->num, pspace_info->sections.size ());
+  gdb_printf (_("Updates: %lu full, %lu incremental\n"),
+	      pspace_info->full_updates, pspace_info->incremental_updates);
+
+  unsigned long lookups = pspace_info->lookups;
+  unsigned long hits = pspace_info->last_hit_lookups;
+  gdb_printf (_("Lookups: %lu, last-hit cache hits: %lu (%lu%%)\n"),
+	      lookups, hits, lookups == 0 ? 0 : hits * 100 / lookups);
+  gdb_printf (_("Batch lookups: %lu, addresses: %lu\n"),
+	      pspace_info->batch_lookups, pspace_info->batch_addresses);
+
+  if (args == nullptr || *args == '\0')
+    return;
+
+  /* Resolve all the given addresses in one go.  */
+  gdb_argv argv (args);
+  std::vector<CORE_ADDR> pcs;
+  for (const char *arg : argv)
+    pcs.push_back (parse_and_eval_address (arg));
+
+  std::vector<obj_section *> sections (pcs.size ());
+  find_pc_sections (pcs, sections);
+
+  gdbarch *gdbarch = get_current_arch ();
+  for (size_t i = 0; i < pcs.size (); i++)
+    {
+      obj_section *osect = sections[i];
+      if (osect == nullptr)
+	gdb_printf (_("%s is not in any section\n"),
+		    paddress (gdbarch, pcs[i]));
+      else
+	gdb_printf (_("%s is in %s of %s\n"), paddress (gdbarch, pcs[i]),
+		    bfd_section_name (osect->the_bfd_section),
+		    objfile_name (osect->objfile));
+    }
+}
+
+void _initialize_objfiles ();
+void
+_initialize_objfiles ()
+{
+  add_cmd ("section-map", class_maintenance, maintenance_info_section_map,
+	   _("\
+Show statistics about the section map used to find the section of an\n\
+address, and optionally look up the section of each ADDRESS.\n\
+Usage: maintenance info section-map [ADDRESS]..."),
+	   &maintenanceinfolist);
+}
@@ -33,6 +33,7 @@
 #include "quick-symbol.h"
 #include <forward_list>
 #include "gdbsupport/unordered_map.h"
+#include "gdbsupport/array-view.h"
 
 struct htab;
 struct objfile_data;
@@ -991,6 +992,14 @@ extern bool have_minimal_symbols (program_space *pspace);
 
 extern struct obj_section *find_pc_section (CORE_ADDR pc);
 
+/* Look up the section of each address in PCS, as find_pc_section
+   does, and store it at the same index in SECTIONS, which must be as
+   large as PCS.  This is cheaper than calling find_pc_section for each
+   address when resolving many addresses at once.  */
+
+extern void find_pc_sections (gdb::array_view<const CORE_ADDR> pcs,
+			      gdb::array_view<obj_section *> sections);
+
 /* Return true if PC is in a section called NAME.  */
 extern bool pc_in_section (CORE_ADDR, const char *);
 
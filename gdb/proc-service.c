@@ -27,6 +27,7 @@
 #include "objfiles.h"
 
 #include "gdb_proc_service.h"
+#include "gdbsupport/unordered_map.h"
 
 #include <sys/procfs.h>
 
@@ -60,6 +61,104 @@ core_addr_to_ps_addr (CORE_ADDR addr)
     return (psaddr_t) (uintptr_t) addr;
 }
 
+/* The size, and alignment, of the chunks of memory read by a
+   ps_read_cache.  */
+#define PS_READ_CACHE_CHUNK_SIZE 4096
+
+/* The maximum number of chunks a ps_read_cache holds.  When full, the
+   cache is simply emptied: libthread_db reads one thread descriptor
+   at a time, so only the most recent chunks are worth keeping.  */
+#define PS_READ_CACHE_MAX_CHUNKS 256
+
+/* See scoped_ps_read_cache.  */
+
+struct ps_read_cache
+{
+  /* The chunks read so far, indexed by address.  */
+  gdb::unordered_map<CORE_ADDR, std::unique_ptr<gdb_byte[]>> chunks;
+
+  ps_read_stats stats {};
+};
+
+/* Read LEN bytes at ADDR into BUF, going through CACHE.  Returns 0 on
+   success, like target_read_memory.  */
+
+static int
+ps_cached_read_memory (ps_read_cache *cache, CORE_ADDR addr,
+		       gdb_byte *buf, size_t len)
+{
+  bool hit = true;
+
+  cache->stats.reads++;
+
+  while (len > 0)
+    {
+      CORE_ADDR chunk_addr
+	= addr & ~(CORE_ADDR) (PS_READ_CACHE_CHUNK_SIZE - 1);
+      size_t offset = addr - chunk_addr;
+      size_t n = std::min (len, (size_t) PS_READ_CACHE_CHUNK_SIZE - offset);
+
+      auto it = cache->chunks.find (chunk_addr);
+      if (it == cache->chunks.end ())
+	{
+	  hit = false;
+
+	  if (cache->chunks.size () >= PS_READ_CACHE_MAX_CHUNKS)
+	    cache->chunks.clear ();
+
+	  std::unique_ptr<gdb_byte[]> chunk
+	    (new gdb_byte[PS_READ_CACHE_CHUNK_SIZE]);
+
+	  cache->stats.target_reads++;
+	  if (target_read_memory (chunk_addr, chunk.get (),
+				  PS_READ_CACHE_CHUNK_SIZE) != 0)
+	    {
+	      /* Part of the chunk is not readable.  Read what was asked
+		 for directly instead.  */
+	      cache->stats.target_reads++;
+	      return target_read_memory (addr, buf, len);
+	    }
+
+	  it = cache->chunks.emplace (chunk_addr, std::move (chunk)).first;
+	}
+
+      memcpy (buf, it->second.get () + offset, n);
+      addr += n;
+      buf += n;
+      len -= n;
+    }
+
+  if (hit)
+    cache->stats.hits++;
+
+  return 0;
+}
+
+/* See gdb_proc_service.h.  */
+
+scoped_ps_read_cache::scoped_ps_read_cache (ps_prochandle *ph)
+  : m_ph (ph),
+    m_saved_cache (ph->read_cache),
+    m_cache (new ps_read_cache)
+{
+  m_ph->read_cache = m_cache.get ();
+}
+
+/* See gdb_proc_service.h.  */
+
+scoped_ps_read_cache::~scoped_ps_read_cache ()
+{
+  m_ph->read_cache = m_saved_cache;
+}
+
+/* See gdb_proc_service.h.  */
+
+const ps_read_stats &
+scoped_ps_read_cache::stats () const
+{
+  return m_cache->stats;
+}
+
 /* Transfer LEN bytes of memory between BUF and address ADDR in the
    process specified by PH.  If WRITE, transfer them to the process,
    else transfer them from the process.  Returns PS_OK for success,
@@ -77,7 +176,13 @@ ps_xfer_memory (const struct ps_prochandle *ph, psaddr_t addr,
 
   int ret;
   if (write)
-    ret = target_write_memory (core_addr, buf, len);
+    {
+      if (ph->read_cache != nullptr)
+	ph->read_cache->chunks.clear ();
+      ret = target_write_memory (core_addr, buf, len);
+    }
+  else if (ph->read_cache != nullptr)
+    ret = ps_cached_read_memory (ph->read_cache, core_addr, buf, len);
   else
     ret = target_read_memory (core_addr, buf, len);
   return (ret == 0 ? PS_OK : PS_ERR);
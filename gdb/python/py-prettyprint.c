@@ -627,6 +627,36 @@ gdbpy_apply_val_pretty_printer (const struct extension_language_defn *extlang,
   return EXT_LANG_RC_OK;
 }
 
+/* This is the extension_language_ops.val_pretty_printer_p "method".
+   Errors are not printed here: the caller is expected to go on and
+   print VALUE, which reports them.  */
+
+enum ext_lang_rc
+gdbpy_val_pretty_printer_p (const struct extension_language_defn *extlang,
+			    struct value *value)
+{
+  if (!gdb_python_initialized)
+    return EXT_LANG_RC_NOP;
+
+  gdbpy_enter enter_py (value->type ()->arch (), current_language);
+
+  gdbpy_ref<> val_obj (value_to_value_object (value));
+  if (val_obj == NULL)
+    {
+      PyErr_Clear ();
+      return EXT_LANG_RC_ERROR;
+    }
+
+  gdbpy_ref<> printer (find_pretty_printer (val_obj.get ()));
+  if (printer == NULL)
+    {
+      PyErr_Clear ();
+      return EXT_LANG_RC_ERROR;
+    }
+
+  return printer == Py_None ? EXT_LANG_RC_NOP : EXT_LANG_RC_OK;
+}
+
 
 /* Apply a pretty-printer for the varobj code.  PRINTER_OBJ is the
    print object.  It must have a 'to_string' method (but this is
@@ -464,6 +464,8 @@ extern enum ext_lang_rc gdbpy_apply_val_pretty_printer
    struct ui_file *stream, int recurse,
    const struct value_print_options *options,
    const struct language_defn *language);
+extern enum ext_lang_rc gdbpy_val_pretty_printer_p
+  (const struct extension_language_defn *, struct value *value);
 extern void gdbpy_load_ptwrite_filter
   (const struct extension_language_defn *extlang,
    struct btrace_thread_info *btinfo);
@@ -161,6 +161,7 @@ static const struct extension_language_ops python_extension_ops =
   gdbpy_free_type_printers,
 
   gdbpy_apply_val_pretty_printer,
+  gdbpy_val_pretty_printer_p,
 
   gdbpy_apply_frame_filter,
 
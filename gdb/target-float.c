@@ -21,6 +21,10 @@
 #include "floatformat.h"
 #include "target-float.h"
 #include "gdbarch.h"
+#if GDB_SELF_TEST
+#include "gdbsupport/selftest.h"
+#include "inferior.h"
+#endif
 
 /* Target floating-point operations.
 
@@ -111,6 +115,26 @@ floatformat_precision (const struct floatformat *fmt)
   return prec;
 }
 
+/* Return the number of decimal digits needed to print any value of the
+   floating point format FMT without losing precision.  This value is
+   computed as
+
+	ceil(1 + p * log10(b)),
+
+   where p is the precision of the floating-point format in bits, and
+   b is the base (which is always 2 for the formats we support).  */
+static int
+floatformat_decimal_dig (const struct floatformat *fmt)
+{
+  const double log10_2 = .30102999566398119521;
+  double d_decimal_dig = 1 + floatformat_precision (fmt) * log10_2;
+  int decimal_dig = d_decimal_dig;
+  if (decimal_dig < d_decimal_dig)
+    decimal_dig++;
+
+  return decimal_dig;
+}
+
 /* Normalize the byte order of FROM into TO.  If no normalization is
    needed then FMT->byteorder is returned and TO is not changed;
    otherwise the format of the normalized form in TO is returned.  */
@@ -489,19 +513,8 @@ floatformat_printf_format (const struct floatformat *fmt,
     {
       /* If no format was specified, print the number using a format string
 	 where the precision is set to the DECIMAL_DIG value for the given
-	 floating-point format.  This value is computed as
-
-		ceil(1 + p * log10(b)),
-
-	 where p is the precision of the floating-point format in bits, and
-	 b is the base (which is always 2 for the formats we support).  */
-      const double log10_2 = .30102999566398119521;
-      double d_decimal_dig = 1 + floatformat_precision (fmt) * log10_2;
-      int decimal_dig = d_decimal_dig;
-      if (decimal_dig < d_decimal_dig)
-	decimal_dig++;
-
-      host_format = string_printf ("%%.%d", decimal_dig);
+	 floating-point format.  */
+      host_format = string_printf ("%%.%d", floatformat_decimal_dig (fmt));
       conversion = 'g';
     }
   else
@@ -2330,11 +2343,83 @@ target_float_is_zero (const gdb_byte *addr, const struct type *type)
   gdb_assert_not_reached ("unexpected type code");
 }
 
-/* Convert the byte-stream ADDR, interpreted as floating-point type TYPE,
-   to a string, optionally using the print format FORMAT.  */
-std::string
-target_float_to_string (const gdb_byte *addr, const struct type *type,
-			const char *format)
+/* Try to convert the byte-stream ADDR, interpreted as a value of the
+   binary floating-point format FMT, to a string using a host double
+   directly.  This handles the IEEE interchange formats up to binary64,
+   including half precision and bfloat16 which would otherwise go through
+   MPFR.  All their values are exactly representable as a host double, so
+   the result is the same as the one of the generic code.  Return false
+   if FMT is not such a format or if the value is a NaN, which is left to
+   the caller so that the payload gets printed.  */
+
+static bool
+floatformat_native_to_string (const struct floatformat *fmt,
+			      const gdb_byte *addr, std::string *result)
+{
+  if (fmt->split_half != nullptr
+      || fmt->intbit != floatformat_intbit_no
+      || (fmt->byteorder != floatformat_little
+	  && fmt->byteorder != floatformat_big)
+      || fmt->totalsize > 64
+      || fmt->totalsize % FLOATFORMAT_CHAR_BIT != 0
+      || fmt->man_len > 52
+      || fmt->exp_len < 2
+      || fmt->exp_len > 11
+      || fmt->exp_nan != (1u << fmt->exp_len) - 1
+      || fmt->exp_bias != (1 << (fmt->exp_len - 1)) - 1)
+    return false;
+
+  /* Assemble the bits, most significant first, which is the order in
+     which floatformat numbers its fields.  */
+  size_t len = fmt->totalsize / FLOATFORMAT_CHAR_BIT;
+  uint64_t bits = 0;
+  for (size_t i = 0; i < len; i++)
+    {
+      size_t idx = fmt->byteorder == floatformat_big ? i : len - 1 - i;
+      bits = (bits << 8) | addr[idx];
+    }
+
+  auto field = [&] (unsigned int start, unsigned int flen) -> uint64_t
+    {
+      return (bits >> (fmt->totalsize - start - flen))
+	      & ((uint64_t (1) << flen) - 1);
+    };
+
+  bool negative = field (fmt->sign_start, 1) != 0;
+  uint64_t exponent = field (fmt->exp_start, fmt->exp_len);
+  uint64_t mantissa = field (fmt->man_start, fmt->man_len);
+  int man_len = fmt->man_len;
+
+  if (exponent == fmt->exp_nan)
+    {
+      if (mantissa != 0)
+	return false;
+
+      *result = negative ? "-inf" : "inf";
+      return true;
+    }
+
+  double val;
+  if (exponent == 0)
+    val = ldexp ((double) mantissa, 1 - fmt->exp_bias - man_len);
+  else
+    val = ldexp ((double) (mantissa | (uint64_t (1) << man_len)),
+		 (int) exponent - fmt->exp_bias - man_len);
+  if (negative)
+    val = -val;
+
+  char buf[64];
+  int n = xsnprintf (buf, sizeof (buf), "%.*g",
+		     floatformat_decimal_dig (fmt), val);
+  result->assign (buf, n);
+  return true;
+}
+
+/* Implementation of target_float_to_string, without the fast path of
+   floatformat_native_to_string.  */
+static std::string
+generic_float_to_string (const gdb_byte *addr, const struct type *type,
+			 const char *format)
 {
   /* Unless we need to adhere to a specific format, provide special
      output for special cases of binary floating-point numbers.  */
@@ -2365,6 +2450,23 @@ target_float_to_string (const gdb_byte *addr, const struct type *type,
   return ops->to_string (addr, type, format);
 }
 
+/* Convert the byte-stream ADDR, interpreted as floating-point type TYPE,
+   to a string, optionally using the print format FORMAT.  */
+std::string
+target_float_to_string (const gdb_byte *addr, const struct type *type,
+			const char *format)
+{
+  /* Common IEEE formats are handled without going through the generic
+     machinery; this matters when printing large vector registers.  */
+  std::string result;
+  if (format == nullptr && type->code () == TYPE_CODE_FLT
+      && floatformat_native_to_string (floatformat_from_type (type), addr,
+				       &result))
+    return result;
+
+  return generic_float_to_string (addr, type, format);
+}
+
 /* Parse string STRING into a target floating-number of type TYPE and
    store it as byte-stream ADDR.  Return whether parsing succeeded.  */
 bool
@@ -2492,3 +2594,111 @@ target_float_compare (const gdb_byte *x, const struct type *type_x,
   return ops->compare (x, type_x, y, type_y);
 }
 
+
+#if GDB_SELF_TEST
+namespace selftests {
+
+/* Check that floatformat_native_to_string agrees with the generic
+   conversion for the value stored in BUF of the floating-point type
+   TYPE.  */
+
+static void
+check_native_to_string (const struct type *type, const gdb_byte *buf)
+{
+  const struct floatformat *fmt = floatformat_from_type (type);
+  std::string native;
+  bool handled = floatformat_native_to_string (fmt, buf, &native);
+
+  if (floatformat_classify (fmt, buf) == float_nan)
+    {
+      SELF_CHECK (!handled);
+      return;
+    }
+
+  SELF_CHECK (handled);
+  SELF_CHECK (native == generic_float_to_string (buf, type, nullptr));
+}
+
+/* Return a floating-point type of format FMTS[ORDER].  */
+
+static struct type *
+native_to_string_type (const struct floatformat **fmts, int order)
+{
+  type_allocator alloc (current_inferior ()->arch ());
+  return init_float_type (alloc, fmts[order]->totalsize, "test_float", fmts,
+			  order == 0 ? BFD_ENDIAN_BIG : BFD_ENDIAN_LITTLE);
+}
+
+static void
+native_to_string_test ()
+{
+  /* Every half precision and bfloat16 value, in both byte orders.  */
+  for (const struct floatformat **fmts
+	 : { floatformats_ieee_half, floatformats_bfloat16 })
+    for (int order = 0; order < 2; order++)
+      {
+	struct type *type = native_to_string_type (fmts, order);
+	for (unsigned int v = 0; v < 0x10000; v++)
+	  {
+	    gdb_byte buf[2];
+	    if (order == 0)
+	      {
+		buf[0] = v >> 8;
+		buf[1] = v & 0xff;
+	      }
+	    else
+	      {
+		buf[0] = v & 0xff;
+		buf[1] = v >> 8;
+	      }
+	    check_native_to_string (type, buf);
+	  }
+      }
+
+  /* A spread of single and double precision values, including zeros,
+     denormals, infinities and NaNs.  */
+  for (const struct floatformat **fmts
+	 : { floatformats_ieee_single, floatformats_ieee_double })
+    for (int order = 0; order < 2; order++)
+      {
+	struct type *type = native_to_string_type (fmts, order);
+	size_t len = type->length ();
+	uint64_t seed = 0x9e3779b97f4a7c15;
+	for (int i = 0; i < 4096; i++)
+	  {
+	    gdb_byte buf[8];
+	    seed = seed * 6364136223846793005 + 1442695040888963407;
+	    for (size_t j = 0; j < len; j++)
+	      buf[j] = seed >> (8 * j);
+	    /* Force some special exponents.  */
+	    if (i % 4 == 1)
+	      memset (buf, 0, len - 1);
+	    else if (i % 4 == 2)
+	      buf[order == 0 ? 0 : len - 1] |= 0x7f;
+	    check_native_to_string (type, buf);
+	  }
+      }
+
+  /* Formats the fast path does not handle.  */
+  gdb_byte buf[16] = { 0 };
+  std::string str;
+  SELF_CHECK (!floatformat_native_to_string (&floatformat_i387_ext, buf,
+					     &str));
+  SELF_CHECK (!floatformat_native_to_string (&floatformat_ibm_long_double_big,
+					     buf, &str));
+  SELF_CHECK (!floatformat_native_to_string (&floatformat_ieee_quad_little,
+					     buf, &str));
+}
+
+} /* namespace selftests */
+#endif /* GDB_SELF_TEST */
+
+void _initialize_target_float ();
+void
+_initialize_target_float ()
+{
+#if GDB_SELF_TEST
+  selftests::register_test ("floatformat_native_to_string",
+			    selftests::native_to_string_test);
+#endif
+}
@@ -0,0 +1,42 @@
+# Copyright (C) 2025 Free Software Foundation, Inc.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# This test case is to test how the latency of GDB's event loop scales
+# with the number of registered file handlers.
+
+from perftest import perftest
+
+
+class EventLoop(perftest.TestCaseWithBasicMeasurements):
+    def __init__(self, handlers, events):
+        super(EventLoop, self).__init__("event-loop")
+        self.handlers = handlers
+        self.events = events
+
+    def _run(self, handlers):
+        gdb.execute(
+            "maintenance test-event-loop %d %d" % (handlers, self.events),
+            False,
+            True,
+        )
+
+    def warm_up(self):
+        self._run(1)
+
+    def execute_test(self):
+        for i in range(1, 5):
+            handlers = max(1, i * self.handlers // 4)
+            func = lambda: self._run(handlers)
+            self.measure.measure(func, handlers)
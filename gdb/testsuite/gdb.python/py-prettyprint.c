@@ -289,6 +289,7 @@ int an_int = -1;
 int_type an_int_type = 1;
 int_type2 an_int_type2 = 2;
 int_type3 an_int_type3 = 3;
+int_type an_int_type_array[3] = { 4, 5, 5 };
 
 int
 main ()
@@ -51,6 +51,7 @@
 #include "stack.h"
 #include "interps.h"
 #include "record-full.h"
+#include "gdbsupport/unordered_map.h"
 
 /* See gdbthread.h.  */
 
@@ -1642,6 +1643,16 @@ Call COMMAND for all threads in ascending order.\n\
 The default is descending order."),
 };
 
+/* Option definition of "thread apply all"'s "-group" option.  */
+
+static const gdb::option::flag_option_def<> group_option_def = {
+  "group",
+  N_("\
+Print the output of COMMAND once for each group of threads for which\n\
+it is identical, along with the IDs of the threads in the group.\n\
+The output is printed once COMMAND has been applied to all threads."),
+};
+
 /* The qcs command line flags for the "thread apply" commands.  Keep
    this in sync with the "frame apply" commands.  */
 
@@ -1666,14 +1677,15 @@ static const gdb::option::option_def thr_qcs_flags_option_defs[] = {
 };
 
 /* Create an option_def_group for the "thread apply all" options, with
-   ASCENDING and FLAGS as context.  */
+   ASCENDING, GROUP and FLAGS as context.  */
 
-static inline std::array<gdb::option::option_def_group, 2>
-make_thread_apply_all_options_def_group (bool *ascending,
+static inline std::array<gdb::option::option_def_group, 3>
+make_thread_apply_all_options_def_group (bool *ascending, bool *group,
 					 qcs_flags *flags)
 {
   return {{
     { {ascending_option_def.def ()}, ascending},
+    { {group_option_def.def ()}, group},
     { {thr_qcs_flags_option_defs}, flags },
   }};
 }
@@ -1687,6 +1699,133 @@ make_thread_apply_options_def_group (qcs_flags *flags)
   return {{thr_qcs_flags_option_defs}, flags};
 }
 
+/* Return a compact description of the IDs of THREADS, such as
+   "1-3, 5, 2.1-4", sorted in ascending order.  */
+
+static std::string
+thread_id_ranges_str (std::vector<thread_info *> threads)
+{
+  std::sort (threads.begin (), threads.end (),
+	     [] (const thread_info *a, const thread_info *b)
+	     {
+	       if (a->inf->num != b->inf->num)
+		 return a->inf->num < b->inf->num;
+	       return a->per_inf_num < b->per_inf_num;
+	     });
+
+  std::string result;
+  for (size_t i = 0; i < threads.size (); )
+    {
+      size_t j = i + 1;
+      while (j < threads.size ()
+	     && threads[j]->inf == threads[i]->inf
+	     && threads[j]->per_inf_num == threads[j - 1]->per_inf_num + 1)
+	j++;
+
+      if (!result.empty ())
+	result += ", ";
+      result += print_thread_id (threads[i]);
+      if (j - i > 1)
+	string_appendf (result, "-%d", threads[j - 1]->per_inf_num);
+      i = j;
+    }
+
+  return result;
+}
+
+/* Implementation of "thread apply all -group".  Apply CMD to each of
+   THREADS in turn, like thread_try_catch_cmd does, but collect the
+   output of each thread instead of printing it.  Then print each
+   distinct output once, preceded by the threads that produced it.
+   Groups are printed in the order their first thread was visited.  */
+
+static void
+thread_apply_all_grouped (const std::vector<thread_info_ref> &threads,
+			  const char *cmd, int from_tty,
+			  const qcs_flags &flags)
+{
+  struct output_group
+  {
+    /* The header of the first thread in the group.  */
+    std::string header;
+
+    std::vector<thread_info *> threads;
+  };
+
+  /* GROUP_INDEX maps each distinct output to its index in GROUPS.  */
+  std::vector<output_group> groups;
+  gdb::unordered_map<std::string, size_t> group_index;
+
+  auto print_groups = [&] ()
+    {
+      /* Inserting into GROUP_INDEX may move its keys, so only look
+	 them up once all outputs are in.  */
+      std::vector<const std::string *> outputs (groups.size ());
+      for (const auto &[output, index] : group_index)
+	outputs[index] = &output;
+
+      for (size_t i = 0; i < groups.size (); i++)
+	{
+	  const output_group &group = groups[i];
+	  if (!flags.quiet)
+	    {
+	      if (group.threads.size () == 1)
+		gdb_printf ("%s", group.header.c_str ());
+	      else
+		gdb_printf (_("\nThreads %s (%zu threads):\n"),
+			    thread_id_ranges_str (group.threads).c_str (),
+			    group.threads.size ());
+	    }
+	  gdb_printf ("%s", outputs[i]->c_str ());
+	}
+    };
+
+  for (const thread_info_ref &thr : threads)
+    {
+      if (!switch_to_thread_if_alive (thr.get ()))
+	continue;
+
+      /* See thread_try_catch_cmd.  */
+      std::string thr_header
+	= string_printf (_("\nThread %s (%s):\n"),
+			 print_thread_id (thr.get ()),
+			 thread_target_id_str (thr.get ()).c_str ());
+
+      std::string cmd_result;
+      try
+	{
+	  execute_command_to_string
+	    (cmd_result, cmd, from_tty, gdb_stdout->term_out ());
+	}
+      catch (const gdb_exception_error &ex)
+	{
+	  if (flags.silent)
+	    continue;
+	  if (!flags.cont)
+	    {
+	      /* Print what was collected so far, so the error shows up
+		 in the same place it would without -group.  */
+	      print_groups ();
+	      if (!flags.quiet)
+		gdb_printf ("%s", thr_header.c_str ());
+	      throw;
+	    }
+	  cmd_result = string_printf ("%s\n", ex.what ());
+	}
+
+      if (flags.silent && cmd_result.empty ())
+	continue;
+
+      auto inserted = group_index.emplace (std::move (cmd_result),
+					   groups.size ());
+      if (inserted.second)
+	groups.push_back ({std::move (thr_header), {}});
+      groups[inserted.first->second].threads.push_back (thr.get ());
+    }
+
+  print_groups ();
+}
+
 /* Apply a GDB command to a list of threads.  List syntax is a whitespace
    separated list of numbers, or ranges, or the keyword `all'.  Ranges consist
    of two numbers separated by a hyphen.  Examples:
@@ -1699,9 +1838,11 @@ static void
 thread_apply_all_command (const char *cmd, int from_tty)
 {
   bool ascending = false;
+  bool group_output = false;
   qcs_flags flags;
 
   auto group = make_thread_apply_all_options_def_group (&ascending,
+							&group_output,
 							&flags);
   gdb::option::process_options
     (&cmd, gdb::option::PROCESS_OPTIONS_UNKNOWN_IS_OPERAND, group);
@@ -1735,9 +1876,12 @@ thread_apply_all_command (const char *cmd, int from_tty)
 
       scoped_restore_current_thread restore_thread;
 
-      for (thread_info_ref &thr : thr_list_cpy)
-	if (switch_to_thread_if_alive (thr.get ()))
-	  thread_try_catch_cmd (thr.get (), {}, cmd, from_tty, flags);
+      if (group_output)
+	thread_apply_all_grouped (thr_list_cpy, cmd, from_tty, flags);
+      else
+	for (thread_info_ref &thr : thr_list_cpy)
+	  if (switch_to_thread_if_alive (thr.get ()))
+	    thread_try_catch_cmd (thr.get (), {}, cmd, from_tty, flags);
     }
 }
 
@@ -1808,6 +1952,7 @@ thread_apply_all_command_completer (cmd_list_element *ignore,
 				    const char *text, const char *word)
 {
   const auto group = make_thread_apply_all_options_def_group (nullptr,
+							      nullptr,
 							      nullptr);
   if (gdb::option::complete_options
       (tracker, &text, gdb::option::PROCESS_OPTIONS_UNKNOWN_IS_OPERAND, group))
@@ -2347,7 +2492,7 @@ THREAD_APPLY_OPTION_HELP),
   set_cmd_completer_handle_brkchars (c, thread_apply_command_completer);
 
   const auto thread_apply_all_opts
-    = make_thread_apply_all_options_def_group (nullptr, nullptr);
+    = make_thread_apply_all_options_def_group (nullptr, nullptr, nullptr);
 
   static std::string thread_apply_all_help = gdb::option::build_help (_("\
 Apply a command to all threads.\n\
@@ -32,6 +32,7 @@
 #include "xml-tdesc.h"
 #include "target-descriptions.h"
 #include "gdbsupport/pathstuff.h"
+#include "gdbsupport/unordered_map.h"
 #include <algorithm>
 
 #ifndef O_LARGEFILE
@@ -423,6 +424,40 @@ static int cur_data_size;
 int trace_regblock_size;
 static std::string trace_tdesc;
 
+/* An entry of the traceframe index.  */
+
+struct tfile_frame_entry
+{
+  /* Offset in the file of the traceframe's data, past its header.  */
+  off_t data_offset;
+
+  /* Size of the traceframe's data.  */
+  unsigned int data_size;
+
+  /* Number of the tracepoint that collected the traceframe.  */
+  short tpnum;
+};
+
+/* The traceframes of the file, indexed by traceframe number.  This is
+   built the first time a traceframe is looked for, so that each tfind
+   does not have to walk the file from its start.  */
+static std::vector<tfile_frame_entry> tfile_frames;
+
+/* For each tracepoint number, the numbers of the traceframes it
+   collected, in increasing order.  The address of a traceframe only
+   depends on its tracepoint, so this also serves lookups by
+   address.  */
+static gdb::unordered_map<short, std::vector<int>> tfile_frames_by_tp;
+
+/* Whether TFILE_FRAMES has been built.  */
+static bool tfile_index_built;
+
+/* If the traceframes could not all be read, the error message raised
+   when reading past the last complete one.  It is reported when a
+   lookup fails, as that is when the old sequential scan would have hit
+   it.  */
+static std::string tfile_index_error;
+
 static void tfile_append_tdesc_line (const char *line);
 static void tfile_interp_line (const char *line,
 			       struct uploaded_tp **utpp,
@@ -622,6 +657,10 @@ tfile_target::close ()
   trace_fd = -1;
   trace_filename.reset ();
   trace_tdesc.clear ();
+  tfile_frames.clear ();
+  tfile_frames_by_tp.clear ();
+  tfile_index_built = false;
+  tfile_index_error.clear ();
 
   trace_reset_local_state ();
 }
@@ -639,54 +678,80 @@ tfile_target::get_tracepoint_status (tracepoint *tp, struct uploaded_tp *utp)
      trace files, so nothing to do here.  */
 }
 
-/* Given the position of a traceframe in the file, figure out what
-   address the frame was collected at.  This would normally be the
-   value of a collected PC register, but if not available, we
-   improvise.  */
+/* Figure out what address the traceframes collected by tracepoint
+   TPNUM were collected at.  This would normally be the value of a
+   collected PC register, but if not available, we improvise.  */
 
 static CORE_ADDR
-tfile_get_traceframe_address (off_t tframe_offset)
+tfile_get_traceframe_address (short tpnum)
 {
   CORE_ADDR addr = 0;
-  short tpnum;
   struct tracepoint *tp;
-  off_t saved_offset = cur_offset;
 
   /* FIXME dig pc out of collected registers.  */
 
   /* Fall back to using tracepoint address.  */
-  lseek (trace_fd, tframe_offset, SEEK_SET);
-  tfile_read ((gdb_byte *) &tpnum, 2);
-  tpnum = (short) extract_signed_integer ((gdb_byte *) &tpnum, 2,
-					  gdbarch_byte_order
-					    (current_inferior ()->arch ()));
-
   tp = get_tracepoint_by_number_on_target (tpnum);
   /* FIXME this is a poor heuristic if multiple locations.  */
   if (tp != nullptr && tp->has_locations ())
     addr = tp->first_loc ().address;
 
-  /* Restore our seek position.  */
-  cur_offset = saved_offset;
-  lseek (trace_fd, cur_offset, SEEK_SET);
   return addr;
 }
 
-/* Given a type of search and some parameters, scan the collection of
-   traceframes in the file looking for a match.  When found, return
-   both the traceframe and tracepoint number, otherwise -1 for
-   each.  */
+/* Build TFILE_FRAMES and TFILE_FRAMES_BY_TP, if not done yet, by
+   walking the headers of all the traceframes in the file.  */
+
+static void
+tfile_build_index ()
+{
+  if (tfile_index_built)
+    return;
+
+  bfd_endian byte_order = gdbarch_byte_order (current_inferior ()->arch ());
+  off_t offset = trace_frames_offset;
+
+  tfile_index_built = true;
+
+  try
+    {
+      while (1)
+	{
+	  gdb_byte header[6];
+
+	  lseek (trace_fd, offset, SEEK_SET);
+	  tfile_read (header, 2);
+	  short tpnum = (short) extract_signed_integer (header, 2, byte_order);
+	  if (tpnum == 0)
+	    break;
+
+	  tfile_read (header + 2, 4);
+	  unsigned int data_size
+	    = (unsigned int) extract_unsigned_integer (header + 2, 4,
+						       byte_order);
+	  offset += 6;
+
+	  tfile_frames_by_tp[tpnum].push_back (tfile_frames.size ());
+	  tfile_frames.push_back ({offset, data_size, tpnum});
+
+	  offset += data_size;
+	}
+    }
+  catch (const gdb_exception_error &ex)
+    {
+      tfile_index_error = ex.what ();
+    }
+}
+
+/* Given a type of search and some parameters, look up the traceframes
+   in the file for a match.  When found, return both the traceframe
+   and tracepoint number, otherwise -1 for each.  */
 
 int
 tfile_target::trace_find (enum trace_find_type type, int num,
 			  CORE_ADDR addr1, CORE_ADDR addr2, int *tpp)
 {
-  short tpnum;
-  int tfnum = 0, found = 0;
-  unsigned int data_size;
-  struct tracepoint *tp;
-  off_t offset, tframe_offset;
-  CORE_ADDR tfaddr;
+  int found = -1;
 
   if (num == -1)
     {
@@ -695,79 +760,85 @@ tfile_target::trace_find (enum trace_find_type type, int num,
       return -1;
     }
 
-  lseek (trace_fd, trace_frames_offset, SEEK_SET);
-  offset = trace_frames_offset;
-  while (1)
+  tfile_build_index ();
+
+  if (type == tfind_number)
     {
-      tframe_offset = offset;
-      tfile_read ((gdb_byte *) &tpnum, 2);
-      tpnum = (short) extract_signed_integer ((gdb_byte *) &tpnum, 2,
-					      gdbarch_byte_order
-						(current_inferior ()->arch ()));
-      offset += 2;
-      if (tpnum == 0)
-	break;
-      tfile_read ((gdb_byte *) &data_size, 4);
-      data_size = (unsigned int) extract_unsigned_integer
-				   ((gdb_byte *) &data_size, 4,
-				    gdbarch_byte_order
-				      (current_inferior ()->arch ()));
-      offset += 4;
-
-      if (type == tfind_number)
+      /* Looking for a specific trace frame.  */
+      if (num >= 0 && num < tfile_frames.size ())
+	found = num;
+    }
+  else
+    {
+      /* Start from the _next_ trace frame.  */
+      int current = get_traceframe_number ();
+
+      /* Return the first traceframe after CURRENT in FRAMES, or -1.  */
+      auto first_after = [=] (const std::vector<int> &frames)
 	{
-	  /* Looking for a specific trace frame.  */
-	  if (tfnum == num)
-	    found = 1;
-	}
-      else
+	  auto it = std::upper_bound (frames.begin (), frames.end (),
+				      current);
+	  return it == frames.end () ? -1 : *it;
+	};
+
+      switch (type)
 	{
-	  /* Start from the _next_ trace frame.  */
-	  if (tfnum > get_traceframe_number ())
+	case tfind_tp:
+	  {
+	    struct tracepoint *tp = get_tracepoint (num);
+	    if (tp != nullptr)
+	      {
+		auto it = tfile_frames_by_tp.find (tp->number_on_target);
+		if (it != tfile_frames_by_tp.end ())
+		  found = first_after (it->second);
+	      }
+	  }
+	  break;
+	case tfind_pc:
+	case tfind_range:
+	case tfind_outside:
+	  for (const auto &[tpnum, frames] : tfile_frames_by_tp)
 	    {
-	      switch (type)
+	      CORE_ADDR tfaddr = tfile_get_traceframe_address (tpnum);
+	      bool match;
+
+	      if (type == tfind_pc)
+		match = tfaddr == addr1;
+	      else if (type == tfind_range)
+		match = addr1 <= tfaddr && tfaddr <= addr2;
+	      else
+		match = !(addr1 <= tfaddr && tfaddr <= addr2);
+
+	      if (match)
 		{
-		case tfind_pc:
-		  tfaddr = tfile_get_traceframe_address (tframe_offset);
-		  if (tfaddr == addr1)
-		    found = 1;
-		  break;
-		case tfind_tp:
-		  tp = get_tracepoint (num);
-		  if (tp && tpnum == tp->number_on_target)
-		    found = 1;
-		  break;
-		case tfind_range:
-		  tfaddr = tfile_get_traceframe_address (tframe_offset);
-		  if (addr1 <= tfaddr && tfaddr <= addr2)
-		    found = 1;
-		  break;
-		case tfind_outside:
-		  tfaddr = tfile_get_traceframe_address (tframe_offset);
-		  if (!(addr1 <= tfaddr && tfaddr <= addr2))
-		    found = 1;
-		  break;
-		default:
-		  internal_error (_("unknown tfind type"));
+		  int tfnum = first_after (frames);
+		  if (tfnum != -1 && (found == -1 || tfnum < found))
+		    found = tfnum;
 		}
 	    }
+	  break;
+	default:
+	  internal_error (_("unknown tfind type"));
 	}
+    }
 
-      if (found)
-	{
-	  if (tpp)
-	    *tpp = tpnum;
-	  cur_offset = offset;
-	  cur_data_size = data_size;
+  if (found != -1)
+    {
+      const tfile_frame_entry &entry = tfile_frames[found];
 
-	  return tfnum;
-	}
-      /* Skip past the traceframe's data.  */
-      lseek (trace_fd, data_size, SEEK_CUR);
-      offset += data_size;
-      /* Update our own count of traceframes.  */
-      ++tfnum;
+      if (tpp)
+	*tpp = entry.tpnum;
+      cur_offset = entry.data_offset;
+      cur_data_size = entry.data_size;
+      lseek (trace_fd, cur_offset, SEEK_SET);
+
+      return found;
     }
+
+  /* A truncated file may have held what we were looking for.  */
+  if (!tfile_index_error.empty ())
+    error ("%s", tfile_index_error.c_str ());
+
   /* Did not find what we were looking for.  */
   if (tpp)
     *tpp = -1;
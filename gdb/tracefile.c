@@ -70,7 +70,10 @@ trace_save (const char *filename, struct trace_file_writer *writer,
   struct uploaded_tsv *uploaded_tsvs = NULL, *utsv;
 
   ULONGEST offset = 0;
-#define MAX_TRACE_UPLOAD 2000
+  /* Ask for blocks large enough that a remote stub fills a whole
+     reply packet per round trip; targets with smaller limits simply
+     return less.  */
+#define MAX_TRACE_UPLOAD 16384
   gdb::byte_vector buf (std::max (MAX_TRACE_UPLOAD, trace_regblock_size));
   bfd_endian byte_order = gdbarch_byte_order (current_inferior ()->arch ());
 
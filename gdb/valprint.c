@@ -2004,6 +2004,43 @@ maybe_print_array_index (struct type *index_type, LONGEST index,
   current_language->print_array_index (index_type, index, stream, options);
 }
 
+/* Print the C or C++ integer, character or float of type ELTTYPE at
+   VALADDR, as c_value_print_inner would print a value of it.  */
+
+static void
+print_element_from_contents (const gdb_byte *valaddr, struct type *elttype,
+			     const struct value_print_options *options,
+			     struct ui_file *stream)
+{
+  struct type *type = check_typedef (elttype);
+
+  if (type->code () == TYPE_CODE_FLT)
+    {
+      if (options->format)
+	print_scalar_formatted (valaddr, type, options, 0, stream);
+      else
+	print_floating (valaddr, type, stream);
+    }
+  else if (options->format || options->output_format)
+    {
+      struct value_print_options opts = *options;
+
+      opts.format = (options->format ? options->format
+		     : options->output_format);
+      print_scalar_formatted (valaddr, type, &opts, 0, stream);
+    }
+  else
+    {
+      print_scalar_formatted (valaddr, type, options, 0, stream);
+      if (c_textual_element_type (elttype, options->format))
+	{
+	  gdb_puts (" ", stream);
+	  current_language->printchar (unpack_long (type, valaddr), elttype,
+				       stream);
+	}
+    }
+}
+
 /* See valprint.h.  */
 
 void
@@ -2051,6 +2088,45 @@ value_print_array_elements (struct value *val, struct ui_file *stream,
       len = 0;
     }
 
+  /* If all of the array is in VAL's buffer, available and not
+     optimized out, an element equals another exactly when their bytes
+     do, so repeats are found by comparing the buffer directly rather
+     than making a value for each element looked at.  */
+  struct type *real_elttype = check_typedef (elttype);
+  ULONGEST eltlen = real_elttype->length ();
+  LONGEST offset = val->embedded_offset ();
+  const gdb_byte *contents = nullptr;
+  if (len > 0
+      && eltlen > 0
+      && bit_stride == TARGET_CHAR_BIT * eltlen
+      && type->length () == len * eltlen
+      && offset + type->length () <= INT_MAX / TARGET_CHAR_BIT
+      && val->entirely_available ()
+      && !val->bits_any_optimized_out (TARGET_CHAR_BIT * offset,
+				       TARGET_CHAR_BIT * type->length ()))
+    contents = val->contents_for_printing ().data () + offset;
+
+  /* C and C++ integers, characters and floats are formatted straight
+     from the buffer as well, unless a pretty-printer claims them.
+     Pretty-printers are looked up by type, so the first element
+     stands for all of them.  */
+  bool format_from_contents
+    = (contents != nullptr
+       && (real_elttype->code () == TYPE_CODE_INT
+	   || real_elttype->code () == TYPE_CODE_CHAR
+	   || real_elttype->code () == TYPE_CODE_FLT)
+       && options->format != 's'
+       && options->output_format != 's'
+       && (current_language->la_language == language_c
+	   || current_language->la_language == language_cplus));
+  if (format_from_contents && !options->raw && i < len)
+    {
+      scoped_value_mark free_values;
+      struct value *first
+	= val->from_component_bitsize (elttype, bit_stride * i, bit_stride);
+      format_from_contents = !ext_lang_val_has_pretty_printer (first);
+    }
+
   annotate_array_section_begin (i, elttype);
 
   for (; i < len && things_printed < options->print_max; i++)
@@ -2076,15 +2152,26 @@ value_print_array_elements (struct value *val, struct ui_file *stream,
       maybe_print_array_index (index_type, i + low_bound,
 			       stream, options);
 
-      struct value *element = val->from_component_bitsize (elttype,
-							   bit_stride * i,
-							   bit_stride);
+      struct value *element = nullptr;
       rep1 = i + 1;
       reps = 1;
       /* Only check for reps if repeat_count_threshold is not set to
 	 UINT_MAX (unlimited).  */
-      if (options->repeat_count_threshold < UINT_MAX)
+      if (options->repeat_count_threshold < UINT_MAX && contents != nullptr)
+	{
+	  const gdb_byte *elt = contents + i * eltlen;
+
+	  while (rep1 < len
+		 && memcmp (elt, contents + rep1 * eltlen, eltlen) == 0)
+	    {
+	      ++reps;
+	      ++rep1;
+	    }
+	}
+      else if (options->repeat_count_threshold < UINT_MAX)
 	{
+	  element = val->from_component_bitsize (elttype, bit_stride * i,
+						 bit_stride);
 	  bool unavailable = element->entirely_unavailable ();
 	  bool available = element->entirely_available ();
 
@@ -2110,8 +2197,20 @@ value_print_array_elements (struct value *val, struct ui_file *stream,
 	    }
 	}
 
-      common_val_print (element, stream, recurse + 1, options,
-			current_language);
+      if (format_from_contents)
+	{
+	  QUIT;
+	  print_element_from_contents (contents + i * eltlen, elttype,
+				       options, stream);
+	}
+      else
+	{
+	  if (element == nullptr)
+	    element = val->from_component_bitsize (elttype, bit_stride * i,
+						   bit_stride);
+	  common_val_print (element, stream, recurse + 1, options,
+			    current_language);
+	}
 
       if (reps > options->repeat_count_threshold)
 	{
@@ -1635,25 +1635,36 @@ amd64_emit_sub (void)
 static void
 amd64_emit_mul (void)
 {
-  emit_error = 1;
+  EMIT_ASM (amd64_mul,
+	    "imul (%rsp),%rax\n\t"
+	    "lea 0x8(%rsp),%rsp");
 }
 
 static void
 amd64_emit_lsh (void)
 {
-  emit_error = 1;
+  EMIT_ASM (amd64_lsh,
+	    "mov %rax,%rcx\n\t"
+	    "pop %rax\n\t"
+	    "shl %cl,%rax");
 }
 
 static void
 amd64_emit_rsh_signed (void)
 {
-  emit_error = 1;
+  EMIT_ASM (amd64_rsh_signed,
+	    "mov %rax,%rcx\n\t"
+	    "pop %rax\n\t"
+	    "sar %cl,%rax");
 }
 
 static void
 amd64_emit_rsh_unsigned (void)
 {
-  emit_error = 1;
+  EMIT_ASM (amd64_rsh_unsigned,
+	    "mov %rax,%rcx\n\t"
+	    "pop %rax\n\t"
+	    "shr %cl,%rax");
 }
 
 static void
@@ -1197,6 +1197,9 @@ struct fast_tracepoint_ctx : public tracepoint_hit_ctx
 
     if (!this->m_regcache.has_value ())
       {
+	/* This is only done when the registers are actually needed, so
+	   that hits whose compiled condition is false stay cheap.  */
+	memset (this->regspace, 0, ipa_tdesc->registers_size);
 	this->m_regcache.emplace (ipa_tdesc, this->regspace);
 	supply_fast_tracepoint_registers (&this->m_regcache.value (),
 					  this->regs);
@@ -5369,8 +5372,6 @@ gdb_collect (struct tracepoint *tpoint, unsigned char *regs)
       return;
     }
 
-  memset (ctx.regspace, 0, ipa_tdesc->registers_size);
-
   for (ctx.tpoint = tpoint;
        ctx.tpoint != NULL && ctx.tpoint->address == tpoint->address;
        ctx.tpoint = ctx.tpoint->next)
@@ -49,6 +49,7 @@ AC_CHECK_HEADERS([ \
   poll.h \
   proc_service.h \
   signal.h \
+  sys/epoll.h \
   sys/poll.h \
   sys/resource.h \
   sys/select.h \
@@ -29,11 +29,19 @@
 #endif
 #endif
 
+/* On Linux, the poll variant uses epoll when possible, so that the
+   cost of waiting does not grow with the number of file handlers.  */
+#if defined (HAVE_POLL) && defined (HAVE_SYS_EPOLL_H)
+#include <sys/epoll.h>
+#define USE_EPOLL 1
+#endif
+
 #include <sys/types.h>
 #include "gdbsupport/gdb_sys_time.h"
 #include "gdbsupport/gdb_select.h"
 #include <optional>
 #include "gdbsupport/scope-exit.h"
+#include "gdbsupport/unordered_map.h"
 
 /* See event-loop.h.  */
 
@@ -77,6 +85,9 @@ struct file_handler
 
   /* Next registered file descriptor.  */
   struct file_handler *next_file;
+
+  /* Previous registered file descriptor.  */
+  struct file_handler *prev_file;
 };
 
 #ifdef HAVE_POLL
@@ -86,6 +97,25 @@ struct file_handler
 static bool use_poll = true;
 #endif
 
+#ifdef USE_EPOLL
+/* Do we use epoll on top of the poll variant?  This is cleared, and
+   we go back to plain poll, if the epoll instance can't be created or
+   if a file descriptor that can't be used with epoll (e.g. a regular
+   file) is added.  */
+static bool use_epoll = true;
+
+/* The epoll instance, or -1 if not created yet.  */
+static int epoll_fd = -1;
+
+/* The poll and epoll event bits are the same on Linux, which lets the
+   epoll variant share the mask handling of the poll variant.  */
+static_assert (EPOLLIN == POLLIN, "EPOLLIN and POLLIN differ");
+static_assert (EPOLLPRI == POLLPRI, "EPOLLPRI and POLLPRI differ");
+static_assert (EPOLLOUT == POLLOUT, "EPOLLOUT and POLLOUT differ");
+static_assert (EPOLLERR == POLLERR, "EPOLLERR and POLLERR differ");
+static_assert (EPOLLHUP == POLLHUP, "EPOLLHUP and POLLHUP differ");
+#endif
+
 #ifdef USE_WIN32API
 #include <windows.h>
 #include <io.h>
@@ -104,6 +134,9 @@ static struct
     /* Ptr to head of file handler list.  */
     file_handler *first_file_handler;
 
+    /* The file handlers, indexed by file descriptor.  */
+    gdb::unordered_map<int, file_handler *> file_handlers_by_fd;
+
     /* Next file handler to handle, for the select variant.  To level
        the fairness across event sources, we serve file handlers in a
        round-robin-like fashion.  The number and order of the polled
@@ -133,7 +166,7 @@ static struct
     /* What file descriptors were found ready by select.  */
     fd_set ready_masks[3];
 
-    /* Number of file descriptors to monitor (for poll).  */
+    /* Number of file descriptors to monitor (for poll and epoll).  */
     /* Number of valid bits (highest fd value + 1) (for select).  */
     int num_fds;
 
@@ -174,6 +207,9 @@ static void create_file_handler (int fd, int mask, handler_func *proc,
 static int gdb_wait_for_event (int);
 static int update_wait_timeout (void);
 static int poll_timers (void);
+#ifdef USE_EPOLL
+static void stop_using_epoll ();
+#endif
 
 /* Process one high level event.  If nothing is ready at this time,
    wait at most MSTIMEOUT milliseconds for something to happen (via
@@ -284,6 +320,10 @@ add_file_handler (int fd, handler_func *proc, gdb_client_data client_data,
       if (poll (&fds, 1, 0) == 1 && (fds.revents & POLLNVAL))
 	use_poll = false;
     }
+#ifdef USE_EPOLL
+  if (!use_poll && use_epoll)
+    stop_using_epoll ();
+#endif
   if (use_poll)
     {
       create_file_handler (fd, POLLIN, proc, client_data, std::move (name),
@@ -295,6 +335,88 @@ add_file_handler (int fd, handler_func *proc, gdb_client_data client_data,
 			 proc, client_data, std::move (name), is_ui);
 }
 
+/* Return the file handler registered for FD, or NULL if there is
+   none.  */
+
+static file_handler *
+find_file_handler (int fd)
+{
+  auto it = gdb_notifier.file_handlers_by_fd.find (fd);
+  if (it == gdb_notifier.file_handlers_by_fd.end ())
+    return nullptr;
+  return it->second;
+}
+
+#ifdef USE_EPOLL
+
+/* Start watching FILE_PTR's file descriptor with epoll, creating the
+   epoll instance if needed.  Return false if epoll can't be used for
+   it, in which case the caller should fall back to poll.  */
+
+static bool
+epoll_add_file_handler (file_handler *file_ptr)
+{
+  if (epoll_fd == -1)
+    {
+      epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+      if (epoll_fd == -1)
+	return false;
+    }
+
+  struct epoll_event event;
+  memset (&event, 0, sizeof (event));
+  event.events = file_ptr->mask;
+  event.data.fd = file_ptr->fd;
+  return epoll_ctl (epoll_fd, EPOLL_CTL_ADD, file_ptr->fd, &event) == 0;
+}
+
+/* Stop using epoll, and set up the poll descriptors for all the
+   currently registered file handlers instead.  */
+
+static void
+stop_using_epoll ()
+{
+  use_epoll = false;
+
+  if (epoll_fd != -1)
+    {
+      close (epoll_fd);
+      epoll_fd = -1;
+    }
+
+  event_loop_debug_printf ("falling back from epoll to poll");
+
+  gdb_notifier.poll_fds.clear ();
+  for (file_handler *file_ptr = gdb_notifier.first_file_handler;
+       file_ptr != NULL;
+       file_ptr = file_ptr->next_file)
+    {
+      struct pollfd new_fd;
+      new_fd.fd = file_ptr->fd;
+      new_fd.events = file_ptr->mask;
+      new_fd.revents = 0;
+      gdb_notifier.poll_fds.push_back (new_fd);
+    }
+}
+
+#endif /* USE_EPOLL */
+
+/* See event-loop.h.  */
+
+const char *
+event_loop_backend_name ()
+{
+#ifdef USE_EPOLL
+  if (use_poll && use_epoll)
+    return "epoll";
+#endif
+#ifdef HAVE_POLL
+  if (use_poll)
+    return "poll";
+#endif
+  return "select";
+}
+
 /* Helper for add_file_handler.
 
    For the poll case, MASK is a combination (OR) of POLLIN,
@@ -315,12 +437,7 @@ create_file_handler (int fd, int mask, handler_func * proc,
 
   /* Do we already have a file handler for this file?  (We may be
      changing its associated procedure).  */
-  for (file_ptr = gdb_notifier.first_file_handler; file_ptr != NULL;
-       file_ptr = file_ptr->next_file)
-    {
-      if (file_ptr->fd == fd)
-	break;
-    }
+  file_ptr = find_file_handler (fd);
 
   /* It is a new file descriptor.  Add it to the list.  Otherwise, just
      change the data associated with it.  */
@@ -328,10 +445,28 @@ create_file_handler (int fd, int mask, handler_func * proc,
     {
       file_ptr = new file_handler;
       file_ptr->fd = fd;
+      file_ptr->mask = mask;
       file_ptr->ready_mask = 0;
       file_ptr->next_file = gdb_notifier.first_file_handler;
+      file_ptr->prev_file = NULL;
+      if (gdb_notifier.first_file_handler != NULL)
+	gdb_notifier.first_file_handler->prev_file = file_ptr;
       gdb_notifier.first_file_handler = file_ptr;
+      gdb_notifier.file_handlers_by_fd[fd] = file_ptr;
+
+#ifdef USE_EPOLL
+      if (use_poll && use_epoll)
+	{
+	  gdb_notifier.num_fds++;
 
+	  /* If epoll can't watch this descriptor, go back to poll.  The
+	     poll descriptors are rebuilt from the handler list, which
+	     already includes this one.  */
+	  if (!epoll_add_file_handler (file_ptr))
+	    stop_using_epoll ();
+	}
+      else
+#endif /* USE_EPOLL */
 #ifdef HAVE_POLL
       if (use_poll)
 	{
@@ -402,21 +537,31 @@ get_next_file_handler_to_handle_and_advance (void)
 void
 delete_file_handler (int fd)
 {
-  file_handler *file_ptr, *prev_ptr = NULL;
+  file_handler *file_ptr;
   int i;
+#ifdef USE_EPOLL
+  bool epoll_del_failed = false;
+#endif
 
   /* Find the entry for the given file.  */
-
-  for (file_ptr = gdb_notifier.first_file_handler; file_ptr != NULL;
-       file_ptr = file_ptr->next_file)
-    {
-      if (file_ptr->fd == fd)
-	break;
-    }
+  file_ptr = find_file_handler (fd);
 
   if (file_ptr == NULL)
     return;
 
+#ifdef USE_EPOLL
+  if (use_poll && use_epoll)
+    {
+      /* This fails if FD was already closed.  The registration then
+	 stays in the epoll set for as long as the file is open
+	 elsewhere, and could report events for a later descriptor with
+	 the same number, so stop using the epoll set below.  */
+      if (epoll_ctl (epoll_fd, EPOLL_CTL_DEL, fd, NULL) != 0)
+	epoll_del_failed = true;
+      gdb_notifier.num_fds--;
+    }
+  else
+#endif /* USE_EPOLL */
 #ifdef HAVE_POLL
   if (use_poll)
     {
@@ -475,15 +620,18 @@ delete_file_handler (int fd)
   if (file_ptr == gdb_notifier.first_file_handler)
     gdb_notifier.first_file_handler = file_ptr->next_file;
   else
-    {
-      for (prev_ptr = gdb_notifier.first_file_handler;
-	   prev_ptr->next_file != file_ptr;
-	   prev_ptr = prev_ptr->next_file)
-	;
-      prev_ptr->next_file = file_ptr->next_file;
-    }
+    file_ptr->prev_file->next_file = file_ptr->next_file;
+  if (file_ptr->next_file != NULL)
+    file_ptr->next_file->prev_file = file_ptr->prev_file;
+  gdb_notifier.file_handlers_by_fd.erase (fd);
 
   delete file_ptr;
+
+#ifdef USE_EPOLL
+  /* Only now, so that the poll descriptors are set up without FD.  */
+  if (epoll_del_failed)
+    stop_using_epoll ();
+#endif
 }
 
 /* Handle the given event by calling the procedure associated to the
@@ -574,6 +722,50 @@ gdb_wait_for_event (int block)
   if (block)
     update_wait_timeout ();
 
+#ifdef USE_EPOLL
+  if (use_poll && use_epoll)
+    {
+      int timeout;
+      struct epoll_event event;
+
+      if (block)
+	timeout = gdb_notifier.timeout_valid ? gdb_notifier.poll_timeout : -1;
+      else
+	timeout = 0;
+
+      /* Ask for a single event.  The descriptors are level-triggered,
+	 so the kernel moves a reported descriptor that is still ready
+	 to the back of its ready list, which gives the same
+	 round-robin fairness as the poll variant below without
+	 scanning all the registered descriptors.  */
+      num_found = epoll_wait (epoll_fd, &event, 1, timeout);
+
+      /* Don't print anything if we get out of epoll_wait because of
+	 a signal.  */
+      if (num_found == -1 && errno != EINTR)
+	perror_with_name (("epoll_wait"));
+
+      if (num_found <= 0)
+	return 0;
+
+      file_ptr = find_file_handler (event.data.fd);
+      if (file_ptr == NULL)
+	{
+	  /* A descriptor that was closed without deleting its handler
+	     first, but that is still open elsewhere (e.g. a dup or a
+	     forked child).  Stop watching it.  If that fails, which it
+	     does once the number is closed, the registration can't be
+	     removed any more; drop the whole epoll set.  */
+	  if (epoll_ctl (epoll_fd, EPOLL_CTL_DEL, event.data.fd, NULL) != 0)
+	    stop_using_epoll ();
+	  return 0;
+	}
+
+      handle_file_event (file_ptr, event.events);
+      return 1;
+    }
+#endif /* USE_EPOLL */
+
 #ifdef HAVE_POLL
   if (use_poll)
     {
@@ -659,13 +851,7 @@ gdb_wait_for_event (int block)
 	    break;
 	}
 
-      for (file_ptr = gdb_notifier.first_file_handler;
-	   file_ptr != NULL;
-	   file_ptr = file_ptr->next_file)
-	{
-	  if (file_ptr->fd == gdb_notifier.poll_fds[i].fd)
-	    break;
-	}
+      file_ptr = find_file_handler (gdb_notifier.poll_fds[i].fd);
       gdb_assert (file_ptr != NULL);
 
       mask = gdb_notifier.poll_fds[i].revents;
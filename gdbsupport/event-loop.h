@@ -92,6 +92,11 @@ extern void add_file_handler (int fd, handler_func *proc,
 			      gdb_client_data client_data,
 			      std::string &&name, bool is_ui = false);
 
+/* Return the name of the mechanism used to wait for events on the
+   registered file descriptors: "epoll", "poll" or "select".  */
+
+extern const char *event_loop_backend_name ();
+
 extern int create_timer (int milliseconds, 
 			 timer_handler_func *proc, 
 			 gdb_client_data client_data);
@@ -28,6 +28,7 @@
  */
 #include "gprof.h"
 #include "libiberty.h"
+#include "hashtab.h"
 #include "search_list.h"
 #include "source.h"
 #include "symtab.h"
@@ -52,6 +53,37 @@ unsigned int num_cycles;
 Arc **arcs;
 unsigned int numarcs;
 
+/* Arcs between two symbols of SYMTAB, hashed on their parent and child.
+   The address ranges of those symbols never overlap, so an arc covers
+   the range of such a child only if it is to that very child, and
+   arc_add need not search all the children of the parent.  Merging
+   many gmon.out files would otherwise spend most of its time there.  */
+static htab_t symtab_arcs;
+
+static hashval_t
+arc_hash (const void *p)
+{
+  const Arc *arc = (const Arc *) p;
+
+  return iterative_hash (&arc->child, sizeof (arc->child),
+			 htab_hash_pointer (arc->parent));
+}
+
+static int
+arc_eq (const void *p1, const void *p2)
+{
+  const Arc *arc1 = (const Arc *) p1;
+  const Arc *arc2 = (const Arc *) p2;
+
+  return arc1->parent == arc2->parent && arc1->child == arc2->child;
+}
+
+static bool
+in_symtab (Sym *sym)
+{
+  return sym >= symtab.base && sym < symtab.limit;
+}
+
 /*
  * Return TRUE iff PARENT has an arc to covers the address
  * range covered by CHILD.
@@ -90,10 +122,23 @@ arc_add (Sym *parent, Sym *child, unsigned long count)
 {
   static unsigned int maxarcs = 0;
   Arc *arc, **newarcs;
+  void **slot = NULL;
 
   DBG (TALLYDEBUG, printf ("[arc_add] %lu arcs from %s to %s\n",
 			   count, parent->name, child->name));
-  arc = arc_lookup (parent, child);
+  if (in_symtab (parent) && in_symtab (child))
+    {
+      Arc key;
+
+      if (symtab_arcs == NULL)
+	symtab_arcs = htab_create (1024, arc_hash, arc_eq, NULL);
+      key.parent = parent;
+      key.child = child;
+      slot = htab_find_slot (symtab_arcs, &key, INSERT);
+      arc = (Arc *) *slot;
+    }
+  else
+    arc = arc_lookup (parent, child);
   if (arc)
     {
       /*
@@ -109,6 +154,8 @@ arc_add (Sym *parent, Sym *child, unsigned long count)
   arc->parent = parent;
   arc->child = child;
   arc->count = count;
+  if (slot)
+    *slot = arc;
 
   /* If this isn't an arc for a recursive call to parent, then add it
      to the array of arcs.  */
@@ -46,6 +46,7 @@ DFN_Stack;
 
 static bool is_numbered (Sym *);
 static bool is_busy (Sym *);
+static int stack_pos (Sym *);
 static void find_cycle (Sym *);
 static void pre_visit (Sym *);
 static void post_visit (Sym *);
@@ -80,6 +81,22 @@ is_busy (Sym *child)
 }
 
 
+/*
+ * Position of SYM on the DFN stack, or 0 if it is not on the stack.
+ */
+static int
+stack_pos (Sym *sym)
+{
+  int pos = sym->cg.dfn_pos;
+
+  if (pos > 0 && pos <= dfn_depth && dfn_stack[pos].sym == sym)
+    {
+      return pos;
+    }
+  return 0;
+}
+
+
 /*
  * CHILD is part of a cycle.  Find the top caller into this cycle
  * that is not part of the cycle and make all functions in cycle
@@ -89,21 +106,24 @@ is_busy (Sym *child)
 static void
 find_cycle (Sym *child)
 {
-  Sym *head = 0;
+  Sym *head;
   Sym *tail;
   int cycle_top;
   int cycle_index;
 
-  for (cycle_top = dfn_depth; cycle_top > 0; --cycle_top)
+  /*
+   * The top of the cycle is the topmost stack entry that is either
+   * CHILD itself or the head of the cycle CHILD has been glommed into.
+   * Every symbol remembers its stack position, so there is no need to
+   * search the stack for it.
+   */
+  cycle_top = stack_pos (child);
+  if (child->cg.cyc.head != child)
     {
-      head = dfn_stack[cycle_top].sym;
-      if (child == head)
+      cycle_index = stack_pos (child->cg.cyc.head);
+      if (cycle_index > cycle_top)
 	{
-	  break;
-	}
-      if (child->cg.cyc.head != child && child->cg.cyc.head == head)
-	{
-	  break;
+	  cycle_top = cycle_index;
 	}
     }
   if (cycle_top <= 0)
@@ -111,6 +131,7 @@ find_cycle (Sym *child)
       fprintf (stderr, "[find_cycle] couldn't find head of cycle\n");
       done (1);
     }
+  head = dfn_stack[cycle_top].sym;
 #ifdef DEBUG
   if (debug_level & DFNDEBUG)
     {
@@ -149,14 +170,6 @@ find_cycle (Sym *child)
        * field points to the head of the cycle they are glommed
        * into.
        */
-      for (tail = head; tail->cg.cyc.next; tail = tail->cg.cyc.next)
-	{
-	  /* void: chase down to tail of things already glommed */
-	  DBG (DFNDEBUG,
-	       printf ("[find_cycle] tail ");
-	       print_name (tail);
-	       printf ("\n"));
-	}
       /*
        * If what we think is the top of the cycle has a cyclehead
        * field, then it's not really the head of the cycle, which is
@@ -169,6 +182,22 @@ find_cycle (Sym *child)
 	       print_name (head);
 	       printf ("\n"));
 	}
+      /*
+       * The head remembers the tail of things already glommed; only
+       * chase down to it when that is not known.
+       */
+      tail = head->cg.cyc.tail;
+      if (tail == NULL || tail->cg.cyc.head != head)
+	{
+	  tail = head;
+	}
+      for (; tail->cg.cyc.next; tail = tail->cg.cyc.next)
+	{
+	  DBG (DFNDEBUG,
+	       printf ("[find_cycle] tail ");
+	       print_name (tail);
+	       printf ("\n"));
+	}
       for (cycle_index = cycle_top + 1; cycle_index <= dfn_depth; ++cycle_index)
 	{
 	  child = dfn_stack[cycle_index].sym;
@@ -201,6 +230,7 @@ find_cycle (Sym *child)
 	      done (1);
 	    }
 	}
+      head->cg.cyc.tail = tail;
     }
 }
 
@@ -223,6 +253,7 @@ pre_visit (Sym *parent)
 
   dfn_stack[dfn_depth].sym = parent;
   dfn_stack[dfn_depth].cycle_top = dfn_depth;
+  parent->cg.dfn_pos = dfn_depth;
   parent->cg.top_order = DFN_BUSY;
   DBG (DFNDEBUG, printf ("[pre_visit]\t\t%d:", dfn_depth);
        print_name (parent);
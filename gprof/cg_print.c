@@ -39,6 +39,7 @@
 static void print_header (void);
 static void print_cycle (Sym *);
 static int cmp_member (Sym *, Sym *);
+static Sym *sort_member_list (Sym *);
 static void sort_members (Sym *);
 static void print_members (Sym *);
 static int cmp_arc (Arc *, Arc *);
@@ -158,31 +159,59 @@ cmp_member (Sym *left, Sym *right)
   return EQUALTO;
 }
 
-/* Sort members of a cycle.  */
+/* Merge sort the list of cycle members starting at LIST, which is
+   linked through CG.CYC.NEXT, into decreasing order.  Members that
+   compare equal keep their relative order.  */
 
-static void
-sort_members (Sym *cyc)
+static Sym *
+sort_member_list (Sym *list)
 {
-  Sym *todo, *doing, *prev;
+  Sym *left, *right, *slow, *fast;
+  Sym **tailp;
 
-  /* Detach cycle members from cyclehead,
-     and insertion sort them back on.  */
-  todo = cyc->cg.cyc.next;
-  cyc->cg.cyc.next = 0;
+  if (list == NULL || list->cg.cyc.next == NULL)
+    return list;
 
-  for (doing = todo; doing != NULL; doing = todo)
-    {
-      todo = doing->cg.cyc.next;
+  /* Split the list in half.  */
+  for (slow = list, fast = list->cg.cyc.next;
+       fast && fast->cg.cyc.next;
+       fast = fast->cg.cyc.next->cg.cyc.next)
+    slow = slow->cg.cyc.next;
+  right = slow->cg.cyc.next;
+  slow->cg.cyc.next = NULL;
+
+  left = sort_member_list (list);
+  right = sort_member_list (right);
 
-      for (prev = cyc; prev->cg.cyc.next; prev = prev->cg.cyc.next)
+  tailp = &list;
+  while (left && right)
+    {
+      if (cmp_member (right, left) == GREATERTHAN)
 	{
-	  if (cmp_member (doing, prev->cg.cyc.next) == GREATERTHAN)
-	    break;
+	  *tailp = right;
+	  right = right->cg.cyc.next;
 	}
-
-      doing->cg.cyc.next = prev->cg.cyc.next;
-      prev->cg.cyc.next = doing;
+      else
+	{
+	  *tailp = left;
+	  left = left->cg.cyc.next;
+	}
+      tailp = &(*tailp)->cg.cyc.next;
     }
+  *tailp = left ? left : right;
+
+  return list;
+}
+
+/* Sort members of a cycle.  */
+
+static void
+sort_members (Sym *cyc)
+{
+  /* The members are sorted the same way an insertion sort onto the
+     cyclehead would sort them, but in N log N rather than N^2 time,
+     which matters for large cycles.  */
+  cyc->cg.cyc.next = sort_member_list (cyc->cg.cyc.next);
 }
 
 /* Print the members of a cycle.  */
@@ -34,6 +34,11 @@
 #include "hertz.h"
 #include "hist.h"
 #include "libiberty.h"
+#include "hashtab.h"
+#if defined (HAVE_PTHREAD_H) && defined (HAVE_PTHREAD_CREATE)
+#include <pthread.h>
+#define GMON_THREADS 1
+#endif
 
 enum gmon_ptr_size {
   ptr_32bit,
@@ -571,6 +576,383 @@ gmon_out_read (const char *filename)
 }
 
 
+/* Summing many gmon.out files.
+
+   The files are split into runs of consecutive files, one per thread.
+   Each thread sums its run into a gmon_sum, reading one file at a time,
+   and then adds in the sums of the runs to its right as they finish,
+   pairwise as in a binary tree.  Histogram counts and arc counts are
+   only ever added, so the order of the additions does not matter.
+   Histogram records and arcs are kept in the order they were first
+   seen, so the final sum adds them to the histograms and call graph in
+   the same order as reading the files one after another would.
+
+   Anything unusual, such as a file that is not in the current gmon.out
+   format, a basic-block record or a histogram that does not match the
+   others, makes the whole sum fail.  The files are then read one after
+   another as usual, which reports the error.  */
+
+/* An arc read from a run of gmon.out files, before its addresses are
+   looked up in the symbol table.  */
+
+typedef struct gmon_raw_arc
+{
+  bfd_vma from_pc;
+  bfd_vma self_pc;
+  unsigned long count;
+  struct gmon_raw_arc *next;	/* The next arc that was first seen.  */
+} gmon_raw_arc;
+
+typedef struct
+{
+  histogram *hists;
+  unsigned int num_hists;
+  gmon_raw_arc *arcs;
+  gmon_raw_arc **arcs_tail;
+  htab_t arc_tab;
+  int input;			/* Like gmon_input.  */
+  int version;			/* The version of the last file.  */
+  bool failed;
+} gmon_sum;
+
+/* The files [FIRST,END) of the files being summed, summed into SUM by
+   one thread.  The thread then adds in the sums of the parts to its
+   right.  */
+
+typedef struct
+{
+  struct gmon_parts *parts;
+  int index;
+  int first, end;
+  gmon_sum sum;
+#ifdef GMON_THREADS
+  pthread_t thread;
+  bool started;
+#endif
+} gmon_part;
+
+typedef struct gmon_parts
+{
+  const char **names;
+  gmon_part *part;
+  int num_parts;
+#ifdef GMON_THREADS
+  /* Held while the threads are started, until it is known which ones
+     were.  */
+  pthread_mutex_t start_lock;
+#endif
+} gmon_parts;
+
+/* Only this many files or more are worth starting threads for.  */
+#define GMON_THREAD_MIN_FILES 4
+
+static hashval_t
+gmon_raw_arc_hash (const void *p)
+{
+  const gmon_raw_arc *arc = (const gmon_raw_arc *) p;
+
+  return iterative_hash (&arc->self_pc, sizeof (arc->self_pc),
+			 iterative_hash (&arc->from_pc, sizeof (arc->from_pc),
+					 0));
+}
+
+static int
+gmon_raw_arc_eq (const void *p1, const void *p2)
+{
+  const gmon_raw_arc *arc1 = (const gmon_raw_arc *) p1;
+  const gmon_raw_arc *arc2 = (const gmon_raw_arc *) p2;
+
+  return arc1->from_pc == arc2->from_pc && arc1->self_pc == arc2->self_pc;
+}
+
+static void
+gmon_sum_init (gmon_sum *sum)
+{
+  memset (sum, 0, sizeof (*sum));
+  sum->arcs_tail = &sum->arcs;
+  sum->arc_tab = htab_create (1024, gmon_raw_arc_hash, gmon_raw_arc_eq,
+			      NULL);
+}
+
+static void
+gmon_sum_free (gmon_sum *sum)
+{
+  gmon_raw_arc *arc, *next;
+  unsigned int i;
+
+  for (i = 0; i < sum->num_hists; ++i)
+    free (sum->hists[i].sample);
+  free (sum->hists);
+  for (arc = sum->arcs; arc; arc = next)
+    {
+      next = arc->next;
+      free (arc);
+    }
+  if (sum->arc_tab)
+    htab_delete (sum->arc_tab);
+  memset (sum, 0, sizeof (*sum));
+}
+
+/* Add ARC to SUM, taking it over.  */
+
+static void
+gmon_sum_add_arc (gmon_sum *sum, gmon_raw_arc *arc)
+{
+  void **slot = htab_find_slot (sum->arc_tab, arc, INSERT);
+
+  if (*slot)
+    {
+      ((gmon_raw_arc *) *slot)->count += arc->count;
+      free (arc);
+      return;
+    }
+  *slot = arc;
+  arc->next = NULL;
+  *sum->arcs_tail = arc;
+  sum->arcs_tail = &arc->next;
+}
+
+/* Add the histogram record RECORD to SUM, taking over its samples.  */
+
+static void
+gmon_sum_add_hist (gmon_sum *sum, histogram *record)
+{
+  if (!hist_sum_rec_fits (sum->hists, sum->num_hists, record))
+    {
+      free (record->sample);
+      sum->failed = true;
+      return;
+    }
+  hist_add_sum_rec (&sum->hists, &sum->num_hists, record);
+}
+
+/* Add the contents of the gmon.out file FILENAME to SUM.  */
+
+static void
+gmon_sum_read (gmon_sum *sum, const char *filename)
+{
+  FILE *ifp;
+  struct gmon_hdr ghdr;
+  unsigned char tag;
+
+  ifp = fopen (filename, FOPEN_RB);
+  if (!ifp)
+    {
+      sum->failed = true;
+      return;
+    }
+
+  if (fread (&ghdr, sizeof (struct gmon_hdr), 1, ifp) != 1
+      || strncmp (&ghdr.cookie[0], GMON_MAGIC, 4))
+    sum->failed = true;
+  else
+    {
+      sum->version = bfd_get_32 (core_bfd, (bfd_byte *) ghdr.version);
+      if (sum->version != GMON_VERSION && sum->version != 0)
+	sum->failed = true;
+    }
+
+  while (!sum->failed && fread (&tag, sizeof (tag), 1, ifp) == 1)
+    {
+      histogram record;
+      gmon_raw_arc *arc;
+      unsigned int count;
+
+      switch (tag)
+	{
+	case GMON_TAG_TIME_HIST:
+	  sum->input |= INPUT_HISTOGRAM;
+	  if (hist_read_sum_rec (ifp, &record))
+	    gmon_sum_add_hist (sum, &record);
+	  else
+	    sum->failed = true;
+	  break;
+
+	case GMON_TAG_CG_ARC:
+	  sum->input |= INPUT_CALL_GRAPH;
+	  arc = (gmon_raw_arc *) xmalloc (sizeof (*arc));
+	  if (gmon_io_read_vma (ifp, &arc->from_pc)
+	      || gmon_io_read_vma (ifp, &arc->self_pc)
+	      || gmon_io_read_32 (ifp, &count))
+	    {
+	      free (arc);
+	      sum->failed = true;
+	      break;
+	    }
+	  arc->count = count;
+	  gmon_sum_add_arc (sum, arc);
+	  break;
+
+	default:
+	  /* Basic-block records are looked up in the symbol table as they
+	     are read, and anything else is an error.  */
+	  sum->failed = true;
+	  break;
+	}
+    }
+
+  fclose (ifp);
+}
+
+/* Add the contents of SRC to DST and free SRC.  */
+
+static void
+gmon_sum_merge (gmon_sum *dst, gmon_sum *src)
+{
+  gmon_raw_arc *arc, *next;
+  unsigned int i;
+
+  if (src->failed)
+    dst->failed = true;
+  if (!dst->failed)
+    {
+      for (i = 0; i < src->num_hists; ++i)
+	gmon_sum_add_hist (dst, &src->hists[i]);
+      src->num_hists = 0;
+      for (arc = src->arcs; arc; arc = next)
+	{
+	  next = arc->next;
+	  gmon_sum_add_arc (dst, arc);
+	}
+      src->arcs = NULL;
+      dst->input |= src->input;
+      dst->version = src->version;
+    }
+  gmon_sum_free (src);
+}
+
+static void *
+gmon_sum_worker (void *arg)
+{
+  gmon_part *part = (gmon_part *) arg;
+  gmon_parts *parts = part->parts;
+  int i, step;
+
+  gmon_sum_init (&part->sum);
+  for (i = part->first; i < part->end && !part->sum.failed; ++i)
+    gmon_sum_read (&part->sum, parts->names[i]);
+
+#ifdef GMON_THREADS
+  /* Wait until it is known which parts have threads of their own.  */
+  pthread_mutex_lock (&parts->start_lock);
+  pthread_mutex_unlock (&parts->start_lock);
+#endif
+
+  /* Add in the parts to the right, one, two, four... parts away.  */
+  for (step = 1;
+       part->index % (2 * step) == 0 && part->index + step < parts->num_parts;
+       step *= 2)
+    {
+      gmon_part *other = &parts->part[part->index + step];
+
+#ifdef GMON_THREADS
+      if (other->started)
+	pthread_join (other->thread, NULL);
+      else
+#endif
+	gmon_sum_worker (other);
+      gmon_sum_merge (&part->sum, &other->sum);
+    }
+  return NULL;
+}
+
+/* The number of threads to sum NUM_FILES gmon.out files on.  */
+
+static int
+gmon_sum_threads (int num_files)
+{
+  long ncpus = 1;
+
+#if defined (GMON_THREADS) && defined (_SC_NPROCESSORS_ONLN)
+  ncpus = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+  if (ncpus > num_files / 2)
+    ncpus = num_files / 2;
+  return ncpus > 1 ? ncpus : 1;
+}
+
+/* Read the NUM_FILES gmon.out files NAMES, in addition to those read
+   so far, summing them on several threads where that is possible.  */
+
+void
+gmon_out_read_files (const char **names, int num_files)
+{
+  gmon_parts parts;
+  gmon_sum *sum;
+  gmon_raw_arc *arc;
+  int i, threads;
+  bool ok;
+
+  /* Old style files, the per-file information of -i and debugging
+     output all need the files to be read one after another.  */
+  threads = gmon_sum_threads (num_files);
+  if (num_files < GMON_THREAD_MIN_FILES
+      || (file_format != FF_AUTO && file_format != FF_MAGIC)
+      || (output_style & STYLE_GMON_INFO)
+      || debug_level)
+    threads = 1;
+  for (i = 0; i < num_files; ++i)
+    if (strcmp (names[i], "-") == 0)
+      threads = 1;
+  if (threads <= 1)
+    {
+      for (i = 0; i < num_files; ++i)
+	gmon_out_read (names[i]);
+      return;
+    }
+
+  parts.names = names;
+  parts.num_parts = threads;
+  parts.part = (gmon_part *) xcalloc (threads, sizeof (gmon_part));
+  for (i = 0; i < threads; ++i)
+    {
+      parts.part[i].parts = &parts;
+      parts.part[i].index = i;
+      parts.part[i].first = (long) num_files * i / threads;
+      parts.part[i].end = (long) num_files * (i + 1) / threads;
+    }
+#ifdef GMON_THREADS
+  pthread_mutex_init (&parts.start_lock, NULL);
+  pthread_mutex_lock (&parts.start_lock);
+  for (i = 1; i < threads; ++i)
+    parts.part[i].started = pthread_create (&parts.part[i].thread, NULL,
+					    gmon_sum_worker,
+					    &parts.part[i]) == 0;
+  pthread_mutex_unlock (&parts.start_lock);
+#endif
+  gmon_sum_worker (&parts.part[0]);
+#ifdef GMON_THREADS
+  pthread_mutex_destroy (&parts.start_lock);
+#endif
+
+  /* Only add the sum once it is known to fit the histograms that were
+     read before.  */
+  sum = &parts.part[0].sum;
+  ok = !sum->failed;
+  for (i = 0; ok && i < (int) sum->num_hists; ++i)
+    ok = hist_sum_rec_fits (histograms, num_histograms, &sum->hists[i]);
+  if (!ok)
+    {
+      gmon_sum_free (sum);
+      free (parts.part);
+      for (i = 0; i < num_files; ++i)
+	gmon_out_read (names[i]);
+      return;
+    }
+
+  for (i = 0; i < (int) sum->num_hists; ++i)
+    hist_add_sum_rec (&histograms, &num_histograms, &sum->hists[i]);
+  sum->num_hists = 0;
+  for (arc = sum->arcs; arc; arc = arc->next)
+    cg_tally (arc->from_pc, arc->self_pc, arc->count);
+  gmon_input |= sum->input;
+  gmon_file_version = sum->version;
+
+  gmon_sum_free (sum);
+  free (parts.part);
+}
+
+
 void
 gmon_out_write (const char *filename)
 {
@@ -588,6 +970,7 @@ gmon_out_write (const char *filename)
     {
       /* Write gmon header.  */
 
+      memset (&ghdr, 0, sizeof (ghdr));
       memcpy (&ghdr.cookie[0], GMON_MAGIC, 4);
       bfd_put_32 (core_bfd, (bfd_vma) GMON_VERSION, (bfd_byte *) ghdr.version);
 
@@ -38,6 +38,7 @@ extern int gmon_io_write_8 (FILE *ifp, unsigned int val);
 extern int gmon_io_write (FILE *ifp, char *buf, size_t n);
 
 extern void gmon_out_read   (const char *);
+extern void gmon_out_read_files (const char **, int);
 extern void gmon_out_write  (const char *);
 
 #endif /* gmon_io_h */
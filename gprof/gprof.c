@@ -547,14 +547,12 @@ This program is free software.  This program has absolutely no warranty.\n"));
     }
   else
     {
-      /* Get information about gmon.out file(s).  */
-      do
-	{
-	  gmon_out_read (gmon_name);
-	  if (optind < argc)
-	    gmon_name = argv[optind];
-	}
-      while (optind++ < argc);
+      /* Get information about gmon.out file(s).  The first one is
+	 read on its own, so that the others can be checked against its
+	 histogram records.  */
+      gmon_out_read (gmon_name);
+      if (optind < argc)
+	gmon_out_read_files ((const char **) argv + optind, argc - optind);
     }
 
   /* If user did not specify output style, try to guess something
@@ -33,6 +33,13 @@
 #include "math.h"
 #include "stdio.h"
 #include "stdlib.h"
+#if defined (HAVE_PTHREAD_H) && defined (HAVE_PTHREAD_CREATE)
+#include <pthread.h>
+#define HIST_THREADS 1
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #define UNITS_TO_CODE (offset_to_code / sizeof(UNIT))
 
@@ -171,6 +178,7 @@ hist_read_rec (FILE * ifp, const char *filename)
   bfd_vma lowpc, highpc;
   histogram n_record;
   histogram *record, *existing_record;
+  UNIT *counts;
   unsigned i;
 
   /* 1. Read the header and see if there's existing record for the
@@ -220,17 +228,21 @@ hist_read_rec (FILE * ifp, const char *filename)
 	       (unsigned long) record->lowpc, (unsigned long) record->highpc,
                record->num_bins));
 
+  /* Read all the bins at once; summing many gmon.out files spends
+     a good part of its time here.  */
+  counts = (UNIT *) xmalloc (record->num_bins * sizeof (UNIT));
+  i = fread (counts, sizeof (UNIT), record->num_bins, ifp);
+  if (i != record->num_bins)
+    {
+      fprintf (stderr,
+	      _("%s: %s: unexpected EOF after reading %u of %u samples\n"),
+	       whoami, filename, i, record->num_bins);
+      done (1);
+    }
+
   for (i = 0; i < record->num_bins; ++i)
     {
-      UNIT count;
-      if (fread (&count[0], sizeof (count), 1, ifp) != 1)
-	{
-	  fprintf (stderr,
-		  _("%s: %s: unexpected EOF after reading %u of %u samples\n"),
-		   whoami, filename, i, record->num_bins);
-	  done (1);
-	}
-      record->sample[i] += bfd_get_16 (core_bfd, (bfd_byte *) & count[0]);
+      record->sample[i] += bfd_get_16 (core_bfd, (bfd_byte *) &counts[i][0]);
       DBG (SAMPLEDEBUG,
 	   printf ("[hist_read_rec] 0x%lx: %u\n",
 		   (unsigned long) (record->lowpc
@@ -238,8 +250,109 @@ hist_read_rec (FILE * ifp, const char *filename)
                                     / record->num_bins),
 		   record->sample[i]));
     }
+  free (counts);
+}
+
+
+/* Read a histogram record from IFP into *RECORD, with its own array
+   of samples, for summing it with others before it is added to the
+   histograms read so far.  Return false if the record is truncated,
+   or does not match the histograms read so far as read_histogram_header
+   requires.  Nothing is reported, so that the caller can go back to
+   reading the files one at a time to get the error messages.  */
+
+bool
+hist_read_sum_rec (FILE *ifp, histogram *record)
+{
+  unsigned int profrate;
+  char n_hist_dimension[15];
+  char n_hist_dimension_abbrev;
+  double n_hist_scale;
+  UNIT *counts;
+  unsigned int i;
+
+  if (gmon_io_read_vma (ifp, &record->lowpc)
+      || gmon_io_read_vma (ifp, &record->highpc)
+      || gmon_io_read_32 (ifp, &record->num_bins)
+      || gmon_io_read_32 (ifp, &profrate)
+      || gmon_io_read (ifp, n_hist_dimension, 15)
+      || gmon_io_read (ifp, &n_hist_dimension_abbrev, 1))
+    return false;
+
+  n_hist_scale = (double)((record->highpc - record->lowpc) / sizeof (UNIT))
+    / record->num_bins;
+
+  /* The first histogram record sets the dimension and scale.  */
+  if (num_histograms == 0
+      || strncmp (n_hist_dimension, hist_dimension, 15) != 0
+      || n_hist_dimension_abbrev != hist_dimension_abbrev
+      || fabs (hist_scale - n_hist_scale) > 0.000001)
+    return false;
+
+  counts = (UNIT *) xmalloc (record->num_bins * sizeof (UNIT));
+  if (fread (counts, sizeof (UNIT), record->num_bins, ifp)
+      != record->num_bins)
+    {
+      free (counts);
+      return false;
+    }
+
+  record->sample = (int *) xmalloc (record->num_bins
+				    * sizeof (record->sample[0]));
+  for (i = 0; i < record->num_bins; ++i)
+    record->sample[i] = bfd_get_16 (core_bfd, (bfd_byte *) &counts[i][0]);
+  free (counts);
+  return true;
 }
 
+/* Return true if RECORD, read by hist_read_sum_rec, either has the same
+   address range and number of bins as one of the NUM records in
+   RECORDS, or overlaps none of them.  */
+
+bool
+hist_sum_rec_fits (const histogram *records, unsigned int num,
+		   const histogram *record)
+{
+  unsigned int i;
+
+  for (i = 0; i < num; ++i)
+    {
+      if (records[i].lowpc == record->lowpc
+	  && records[i].highpc == record->highpc)
+	return records[i].num_bins == record->num_bins;
+      if (records[i].lowpc < record->highpc
+	  && record->lowpc < records[i].highpc)
+	return false;
+    }
+  return true;
+}
+
+/* Add the samples of RECORD to those of the record for the same
+   addresses in the *NUM records of *RECORDS, or append RECORD to them.
+   RECORD must fit as hist_sum_rec_fits checks.  Its samples are freed
+   or taken over.  */
+
+void
+hist_add_sum_rec (histogram **records, unsigned int *num, histogram *record)
+{
+  unsigned int i, j;
+
+  for (i = 0; i < *num; ++i)
+    if ((*records)[i].lowpc == record->lowpc
+	&& (*records)[i].highpc == record->highpc)
+      {
+	for (j = 0; j < record->num_bins; ++j)
+	  (*records)[i].sample[j] += record->sample[j];
+	free (record->sample);
+	record->sample = NULL;
+	return;
+      }
+
+  *records = (histogram *) xrealloc (*records,
+				     sizeof (histogram) * (*num + 1));
+  (*records)[(*num)++] = *record;
+  record->sample = NULL;
+}
 
 /* Write all execution histograms file OFP.  FILENAME is the name
    of OFP and is provided for formatting error-messages only.  */
@@ -320,6 +433,27 @@ scale_and_align_entries (void)
 }
 
 
+/* The symbols [FIRST_SYM,END_SYM) that samples are assigned to in one
+   go, possibly on a thread of their own.  Credits that the flat profile
+   filters exclude are recorded in UNCREDITS in the order they are
+   found, so that they can be taken back out of TOTAL_TIME afterwards in
+   the same order as when all symbols are done in one go.  */
+
+typedef struct
+{
+  unsigned int rec;		/* Histogram record.  */
+  unsigned int bin;		/* Bin in that record.  */
+  double credit;
+} hist_uncredit;
+
+typedef struct
+{
+  unsigned int first_sym, end_sym;
+  hist_uncredit *uncredits;
+  size_t num_uncredits, max_uncredits;
+  size_t next_uncredit;		/* Next one to take out of TOTAL_TIME.  */
+} hist_part;
+
 /* Assign samples to the symbol to which they belong.
 
    Histogram bin I covers some address range [BIN_LOWPC,BIN_HIGH_PC)
@@ -355,22 +489,52 @@ scale_and_align_entries (void)
    until the next bin.  In conjunction with the alignment of routine
    addresses, this should allow us to have only one sample for every
    four bytes of text space and never have any overlap (the two end
-   cases, above).  */
+   cases, above).
+
+   Only the symbols of PART are credited with the samples of histogram
+   record REC.  */
 
 static void
-hist_assign_samples_1 (histogram *r)
+hist_assign_samples_1 (unsigned int rec, const bool *credit_sym,
+		       hist_part *part)
 {
+  histogram *r = &histograms[rec];
   bfd_vma bin_low_pc, bin_high_pc;
   bfd_vma sym_low_pc, sym_high_pc;
-  bfd_vma overlap, addr;
+  bfd_vma overlap;
   unsigned int bin_count;
   unsigned int i, j, k;
+  unsigned int lo, hi;
   double count_time, credit;
 
   bfd_vma lowpc = r->lowpc / sizeof (UNIT);
 
-  /* Iterate over all sample bins.  */
-  for (i = 0, k = 1; i < r->num_bins; ++i)
+  /* Symbols that end at or below the first bin can never be credited,
+     so start the merge at the first symbol that ends above it.  */
+  for (lo = part->first_sym, hi = part->end_sym; lo < hi;)
+    {
+      j = lo + (hi - lo) / 2;
+      if (symtab.base[j + 1].hist.scaled_addr <= lowpc)
+	lo = j + 1;
+      else
+	hi = j;
+    }
+  if (lo == part->end_sym)
+    return;
+
+  /* Likewise, bins that end below that symbol credit nothing.  */
+  sym_low_pc = symtab.base[lo].hist.scaled_addr;
+  for (i = 0, hi = r->num_bins; i < hi;)
+    {
+      j = i + (hi - i) / 2;
+      if (lowpc + (bfd_vma) (hist_scale * (j + 1)) < sym_low_pc)
+	i = j + 1;
+      else
+	hi = j;
+    }
+
+  /* Iterate over the sample bins.  */
+  for (k = lo + 1; i < r->num_bins; ++i)
     {
       bin_count = r->sample[i];
       if (! bin_count)
@@ -380,19 +544,24 @@ hist_assign_samples_1 (histogram *r)
       bin_high_pc = lowpc + (bfd_vma) (hist_scale * (i + 1));
       count_time = bin_count;
 
+      /* Once only the last symbol is left and it ends below this bin,
+	 no later bin can be credited either.  */
+      if (k >= part->end_sym
+	  && bin_low_pc >= symtab.base[part->end_sym].hist.scaled_addr)
+	break;
+
       DBG (SAMPLEDEBUG,
 	   printf (
       "[assign_samples] bin_low_pc=0x%lx, bin_high_pc=0x%lx, bin_count=%u\n",
 		    (unsigned long) (sizeof (UNIT) * bin_low_pc),
 		    (unsigned long) (sizeof (UNIT) * bin_high_pc),
 		    bin_count));
-      total_time += count_time;
 
       /* Credit all symbols that are covered by bin I.
 
          PR gprof/13325: Make sure that K does not get decremented
 	 and J will never be less than 0.  */
-      for (j = k - 1; j < symtab.len; k = ++j)
+      for (j = k - 1; j < part->end_sym; k = ++j)
 	{
 	  sym_low_pc = symtab.base[j].hist.scaled_addr;
 	  sym_high_pc = symtab.base[j + 1].hist.scaled_addr;
@@ -419,41 +588,210 @@ hist_assign_samples_1 (histogram *r)
 			   symtab.base[j].name, overlap * count_time / hist_scale,
 			   (long) overlap));
 
-	      addr = symtab.base[j].addr;
 	      credit = overlap * count_time / hist_scale;
 
-	      /* Credit symbol if it appears in INCL_FLAT or that
-		 table is empty and it does not appear it in
-		 EXCL_FLAT.  */
-	      if (sym_lookup (&syms[INCL_FLAT], addr)
-		  || (syms[INCL_FLAT].len == 0
-		      && !sym_lookup (&syms[EXCL_FLAT], addr)))
+	      if (credit_sym == NULL || credit_sym[j])
 		{
 		  symtab.base[j].hist.time += credit;
 		}
 	      else
 		{
-		  total_time -= credit;
+		  if (part->num_uncredits == part->max_uncredits)
+		    {
+		      part->max_uncredits = 2 * part->max_uncredits + 64;
+		      part->uncredits = (hist_uncredit *)
+			xrealloc (part->uncredits,
+				  part->max_uncredits * sizeof (hist_uncredit));
+		    }
+		  part->uncredits[part->num_uncredits].rec = rec;
+		  part->uncredits[part->num_uncredits].bin = i;
+		  part->uncredits[part->num_uncredits].credit = credit;
+		  part->num_uncredits++;
 		}
 	    }
 	}
     }
+}
+
+/* Add the samples of histogram record REC to TOTAL_TIME, less the
+   credits that PARTS recorded as excluded from the flat profile.  */
+
+static void
+hist_total_time (unsigned int rec, hist_part *parts, unsigned int num_parts)
+{
+  histogram *r = &histograms[rec];
+  unsigned int i, p;
+
+  for (i = 0; i < r->num_bins; ++i)
+    {
+      unsigned int bin_count = r->sample[i];
+      double count_time = bin_count;
+
+      if (! bin_count)
+	continue;
+
+      total_time += count_time;
+      for (p = 0; p < num_parts; ++p)
+	{
+	  hist_part *part = &parts[p];
+
+	  while (part->next_uncredit < part->num_uncredits
+		 && part->uncredits[part->next_uncredit].rec == rec
+		 && part->uncredits[part->next_uncredit].bin == i)
+	    total_time -= part->uncredits[part->next_uncredit++].credit;
+	}
+    }
 
   DBG (SAMPLEDEBUG, printf ("[assign_samples] total_time %f\n",
 			    total_time));
 }
 
-/* Calls 'hist_assign_sampes_1' for all histogram records read so far. */
+/* Only histograms with at least this many bins in all are worth
+   starting threads for.  */
+#define HIST_THREAD_MIN_BINS (1 << 16)
+
+/* The parts of the symbol table that are still to be done.  */
+
+typedef struct
+{
+#ifdef HIST_THREADS
+  pthread_mutex_t lock;
+#endif
+  const bool *credit_sym;
+  hist_part *parts;
+  unsigned int num_parts;
+  unsigned int next_part;
+} hist_queue;
+
+static void *
+hist_assign_worker (void *arg)
+{
+  hist_queue *queue = (hist_queue *) arg;
+
+  for (;;)
+    {
+      hist_part *part = NULL;
+      unsigned int rec;
+
+#ifdef HIST_THREADS
+      pthread_mutex_lock (&queue->lock);
+#endif
+      if (queue->next_part < queue->num_parts)
+	part = &queue->parts[queue->next_part++];
+#ifdef HIST_THREADS
+      pthread_mutex_unlock (&queue->lock);
+#endif
+      if (part == NULL)
+	break;
+
+      for (rec = 0; rec < num_histograms; ++rec)
+	hist_assign_samples_1 (rec, queue->credit_sym, part);
+    }
+  return NULL;
+}
+
+/* The number of threads to assign samples on.  */
+
+static unsigned int
+hist_threads (void)
+{
+#if defined (HIST_THREADS) && defined (_SC_NPROCESSORS_ONLN)
+  unsigned int i;
+  size_t num_bins = 0;
+  long ncpus;
+
+  /* Keep the debugging output in order.  */
+  if (debug_level & SAMPLEDEBUG)
+    return 1;
+
+  for (i = 0; i < num_histograms; ++i)
+    num_bins += histograms[i].num_bins;
+  if (num_bins < HIST_THREAD_MIN_BINS)
+    return 1;
+
+  ncpus = sysconf (_SC_NPROCESSORS_ONLN);
+  if (ncpus > 1)
+    return ncpus;
+#endif
+  return 1;
+}
+
+/* Calls 'hist_assign_samples_1' for all histogram records read so far.
+
+   With more than one thread, the symbol table is split into parts that
+   the threads take in turn.  A symbol is only credited by the thread
+   doing its part, in the same order as with one thread, and TOTAL_TIME
+   is summed afterwards in bin order.  So the floating point results do
+   not depend on the number of threads.  */
 void
 hist_assign_samples (void)
 {
   unsigned i;
+  bool *credit_sym = NULL;
+  unsigned int threads;
+  hist_queue queue;
 
   scale_and_align_entries ();
 
+  /* Credit symbol if it appears in INCL_FLAT or that table is empty
+     and it does not appear it in EXCL_FLAT.  Decide that once per
+     symbol rather than once per overlapping bin.  */
+  if (syms[INCL_FLAT].len != 0 || syms[EXCL_FLAT].len != 0)
+    {
+      credit_sym = (bool *) xmalloc (symtab.len * sizeof (bool));
+      for (i = 0; i < symtab.len; ++i)
+	{
+	  bfd_vma addr = symtab.base[i].addr;
+
+	  credit_sym[i] = (sym_lookup (&syms[INCL_FLAT], addr)
+			   || (syms[INCL_FLAT].len == 0
+			       && !sym_lookup (&syms[EXCL_FLAT], addr)));
+	}
+    }
+
+  /* Several parts per thread even out symbols with many samples.  */
+  threads = hist_threads ();
+  queue.num_parts = threads == 1 ? 1 : 4 * threads;
+  if (queue.num_parts > symtab.len)
+    queue.num_parts = symtab.len ? symtab.len : 1;
+  queue.parts = (hist_part *) xcalloc (queue.num_parts, sizeof (hist_part));
+  for (i = 0; i < queue.num_parts; ++i)
+    {
+      queue.parts[i].first_sym = (size_t) symtab.len * i / queue.num_parts;
+      queue.parts[i].end_sym = ((size_t) symtab.len * (i + 1)
+				/ queue.num_parts);
+    }
+  queue.credit_sym = credit_sym;
+  queue.next_part = 0;
+
+#ifdef HIST_THREADS
+  {
+    pthread_t *workers;
+    unsigned int nworkers;
+
+    pthread_mutex_init (&queue.lock, NULL);
+    workers = (pthread_t *) xmalloc (threads * sizeof (pthread_t));
+    for (nworkers = 0; nworkers < threads - 1; nworkers++)
+      if (pthread_create (&workers[nworkers], NULL, hist_assign_worker,
+			  &queue) != 0)
+	break;
+    hist_assign_worker (&queue);
+    for (i = 0; i < nworkers; i++)
+      pthread_join (workers[i], NULL);
+    free (workers);
+    pthread_mutex_destroy (&queue.lock);
+  }
+#else
+  hist_assign_worker (&queue);
+#endif
+
   for (i = 0; i < num_histograms; ++i)
-    hist_assign_samples_1 (&histograms[i]);
+    hist_total_time (i, queue.parts, queue.num_parts);
 
+  for (i = 0; i < queue.num_parts; ++i)
+    free (queue.parts[i].uncredits);
+  free (queue.parts);
+  free (credit_sym);
 }
 
 /* Print header for flag histogram profile.  */
@@ -38,6 +38,10 @@ extern unsigned    num_histograms;
 extern double hist_scale;
 
 extern void hist_read_rec        (FILE *, const char *);
+extern bool hist_read_sum_rec     (FILE *, histogram *);
+extern bool hist_sum_rec_fits    (const histogram *, unsigned int,
+				  const histogram *);
+extern void hist_add_sum_rec     (histogram **, unsigned int *, histogram *);
 extern void hist_write_hist      (FILE *, const char *);
 extern void hist_assign_samples  (void);
 extern void hist_print           (void);
@@ -78,6 +78,7 @@ typedef struct sym
 	double child_time;	/* Cumulative ticks in children.  */
 	int index;		/* Index in the graph list.  */
 	int top_order;		/* Graph call chain top-sort order.  */
+	int dfn_pos;		/* Position on the DFN stack while busy.  */
 	bool print_flag;	/* Should this be printed?  */
 	struct
 	  {
@@ -91,6 +92,7 @@ typedef struct sym
 	    int num;		/* Internal number of cycle on.  */
 	    struct sym *head;	/* Head of cycle.  */
 	    struct sym *next;	/* Next member of cycle.  */
+	    struct sym *tail;	/* Last member of cycle (head only).  */
 	  }
 	cyc;
 	struct arc *parents;	/* List of caller arcs.  */
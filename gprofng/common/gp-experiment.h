@@ -62,6 +62,7 @@
 #define SP_DEADLOCK_FILE        "deadlocks"
 #define SP_FRINFO_FILE          "frameinfo"
 #define SP_WARN_FILE            "warnings.xml"
+#define SP_INDEX_FILE           "index"
 
 #define SP_LIBCOLLECTOR_NAME    "libgp-collector.so"
 #define SP_LIBAUDIT_NAME        "libcollect-ng.so"
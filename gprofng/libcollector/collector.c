@@ -891,6 +891,7 @@ __collector_open_experiment (const char *exp, const char *params, sp_origin_t or
   // In any case, we still have to create the key before a thread can use it.
   __collector_ext_gettid_tsd_create_key ();
   __collector_ext_dispatcher_tsd_create_key ();
+  __collector_ext_iolib_tsd_create_key ();
 
   /* allocate tsd for the current thread */
   if (__collector_tsd_allocate () != 0)
@@ -1411,6 +1412,9 @@ __collector_clean_state ()
     if (modules[i]->stopDataCollection != NULL)
       modules[i]->stopDataCollection ();
 
+  /* Drop the packets the parent's threads have buffered */
+  __collector_iolib_fork_child_cleanup ();
+
   // Now we can reset modules
   for (i = 0; i < nmodules; i++)
     {
@@ -65,6 +65,8 @@ extern void __collector_delete_handle (struct DataHandle*);
 extern int __collector_write_record (struct DataHandle*, Common_packet*);
 extern int __collector_write_packet (struct DataHandle*, CM_Packet*);
 extern int __collector_write_string (struct DataHandle*, char*, int);
+extern void __collector_ext_iolib_tsd_create_key ();
+extern void __collector_iolib_fork_child_cleanup ();
 extern FrameInfo __collector_get_frame_info (hrtime_t, int, void *);
 extern FrameInfo __collector_getUID (CM_Array *arg, FrameInfo uid);
 extern int __collector_getStackTrace (void *buf, int size, void *bptr,
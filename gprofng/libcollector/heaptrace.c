@@ -67,6 +67,31 @@ static CollectorModule heap_hndl = COLLECTOR_MODULE_ERR;
 static const Heap_packet heap_packet0 = { .comm.tsize = sizeof ( Heap_packet) };
 static __thread int reentrance = 0;
 
+/* Sampled heap tracing (-H sample=N).  Each thread counts down the bytes
+ * it allocates and traces the allocation that reaches zero.  The next
+ * countdown is drawn from an exponential distribution with mean N, so
+ * an allocation of S bytes is traced with probability 1 - exp(-S/N),
+ * which lets the analyzer scale the data back to estimated totals.
+ * The addresses of traced allocations are kept in sampled_addrs, so
+ * that only their frees are traced.  Changes to the table are made under
+ * sampled_addrs_lock; free() looks addresses up without it and checks
+ * sampled_addrs_seq, which is odd while the table is being rehashed.
+ */
+static size_t heap_sample = 0;
+static __thread long long sample_left = 0;
+static __thread uint64_t sample_rnd = 0;
+static struct Heap *heap_heap = NULL;
+
+#define SAMPLED_ADDRS_SIZE   (1 << 18)  /* must be a power of two */
+#define SAMPLED_ADDRS_PROBES 32
+#define ADDR_EMPTY           ((void *) 0)
+#define ADDR_FREED           ((void *) 1)
+static void **sampled_addrs = NULL;
+static int sampled_addrs_full = 0;  /* an address was not recorded: trace all frees */
+static int sampled_addrs_freed = 0; /* ADDR_FREED slots */
+static uint32_t sampled_addrs_seq = 0;
+static collector_mutex_t sampled_addrs_lock = COLLECTOR_MUTEX_INITIALIZER;
+
 #define CHCK_REENTRANCE  ( !heap_mode || reentrance != 0 )
 #define PUSH_REENTRANCE  (reentrance++)
 #define POP_REENTRANCE   (reentrance--)
@@ -134,7 +159,19 @@ open_experiment (const char *exp)
   if (params == NULL)   /* Heap data collection not specified */
     return COL_ERROR_HEAPINIT;
 
-  if (*params != 'o') // Not -H on. Read a range.
+  if (CALL_UTIL (strncmp)(params, "sample=", 7) == 0)
+    {
+      heap_sample = (size_t) CALL_UTIL (strtoull) (params + 7, NULL, 0);
+      heap_heap = collector_interface->newHeap ();
+      if (heap_heap != NULL)
+	sampled_addrs = (void **) collector_interface->allocCSize (heap_heap,
+			      SAMPLED_ADDRS_SIZE * sizeof (void *), 1);
+      if (sampled_addrs != NULL)
+	CALL_UTIL (memset)(sampled_addrs, 0, SAMPLED_ADDRS_SIZE * sizeof (void *));
+      else
+	sampled_addrs_full = 1;
+    }
+  else if (*params != 'o') // Not -H on. Read a range.
     {
       char *s;
       start_range = (size_t) CALL_UTIL (strtoull) (params, &s, 0);
@@ -143,7 +180,11 @@ open_experiment (const char *exp)
       fprintf(stderr, "Range: %lld - %lld\n", (long long) start_range, (long long) end_range);
     }
   
-  collector_interface->writeLog ("<profile name=\"%s\">\n", SP_JCMD_HEAPTRACE);
+  if (heap_sample != 0)
+    collector_interface->writeLog ("<profile name=\"%s\" sample=\"%lld\">\n",
+				   SP_JCMD_HEAPTRACE, (long long) heap_sample);
+  else
+    collector_interface->writeLog ("<profile name=\"%s\">\n", SP_JCMD_HEAPTRACE);
   collector_interface->writeLog ("  <profdata fname=\"%s\"/>\n",
 				 module_interface.description);
 
@@ -253,6 +294,178 @@ init_heap_intf ()
   return 0;
 }
 
+/*------------------------------------------------------------- sampling */
+
+/* Return ln(u) for u uniformly distributed in (0,1], given 64 random bits.  */
+static double
+log_uniform (uint64_t rnd)
+{
+  double x = (double) ((rnd >> 11) + 1) / 9007199254740992.0; /* 2^53 */
+  int e = 0;
+  while (x < 0.5)
+    {
+      x *= 2;
+      e--;
+    }
+  /* ln(x) = 2 * atanh(z) for x in [0.5,1], |z| <= 1/3 */
+  double z = (x - 1) / (x + 1);
+  double z2 = z * z;
+  double t = z * (1 + z2 * (1.0 / 3 + z2 * (1.0 / 5 + z2 * (1.0 / 7
+		 + z2 * (1.0 / 9 + z2 / 11)))));
+  return e * 0.69314718055994530942 + 2 * t;
+}
+
+/* Return the number of bytes to allocate before the next sample.  */
+static long long
+next_sample (void)
+{
+  if (sample_rnd == 0)
+    sample_rnd = (uint64_t) gethrtime () ^ (uint64_t) (uintptr_t) &sample_rnd;
+  /* xorshift64* */
+  sample_rnd ^= sample_rnd >> 12;
+  sample_rnd ^= sample_rnd << 25;
+  sample_rnd ^= sample_rnd >> 27;
+  uint64_t rnd = sample_rnd * 0x2545F4914F6CDD1DULL;
+  return (long long) (-log_uniform (rnd) * heap_sample) + 1;
+}
+
+/* Return non-zero if an allocation of SIZE bytes is to be traced.  */
+static int
+sample_allocation (size_t size)
+{
+  if (heap_sample == 0)
+    return 1;
+  if (sample_rnd == 0)
+    sample_left = next_sample ();
+  sample_left -= (long long) size;
+  if (sample_left > 0)
+    return 0;
+  sample_left = next_sample ();
+  return 1;
+}
+
+static unsigned
+sampled_addr_hash (void *ptr)
+{
+  return (unsigned) (((uint64_t) (uintptr_t) ptr * 0x9E3779B97F4A7C15ULL) >> 40);
+}
+
+#define SAMPLED_ADDR_SLOT(idx) (sampled_addrs + ((idx) & (SAMPLED_ADDRS_SIZE - 1)))
+
+/* Store PTR in the first free slot of its probe sequence.
+ * Called with sampled_addrs_lock held.  */
+static int
+sampled_addr_insert (void *ptr)
+{
+  unsigned idx = sampled_addr_hash (ptr);
+  for (int i = 0; i < SAMPLED_ADDRS_PROBES; i++)
+    {
+      void **p = SAMPLED_ADDR_SLOT (idx + i);
+      if (*p == ADDR_FREED)
+	sampled_addrs_freed--;
+      else if (*p != ADDR_EMPTY)
+	continue;
+      *p = ptr;
+      return 1;
+    }
+  return 0;
+}
+
+/* Drop all ADDR_FREED slots and move every address back as close to its
+ * hash slot as it will go.  Called with sampled_addrs_lock held.  */
+static void
+sampled_addr_rehash ()
+{
+  __atomic_store_n (&sampled_addrs_seq, sampled_addrs_seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence (__ATOMIC_RELEASE);
+  for (int i = 0; i < SAMPLED_ADDRS_SIZE; i++)
+    if (sampled_addrs[i] == ADDR_FREED)
+      sampled_addrs[i] = ADDR_EMPTY;
+  sampled_addrs_freed = 0;
+  /* An address never lands after the slot it is taken from, since that
+     slot is free again by then.  */
+  for (int i = 0; i < SAMPLED_ADDRS_SIZE; i++)
+    {
+      void *v = sampled_addrs[i];
+      if (v == ADDR_EMPTY)
+	continue;
+      sampled_addrs[i] = ADDR_EMPTY;
+      sampled_addr_insert (v);
+    }
+  __atomic_store_n (&sampled_addrs_seq, sampled_addrs_seq + 1, __ATOMIC_RELEASE);
+}
+
+/* Remember the address of a traced allocation.  */
+static void
+sampled_addr_put (void *ptr)
+{
+  if (ptr == NULL || sampled_addrs == NULL)
+    return;
+  __collector_mutex_lock (&sampled_addrs_lock);
+  if (!sampled_addr_insert (ptr))
+    sampled_addrs_full = 1;
+  __collector_mutex_unlock (&sampled_addrs_lock);
+}
+
+/* Find the slot holding PTR, or return NULL.  */
+static void **
+sampled_addr_find (void *ptr)
+{
+  unsigned idx = sampled_addr_hash (ptr);
+  for (int i = 0; i < SAMPLED_ADDRS_PROBES; i++)
+    {
+      void **p = SAMPLED_ADDR_SLOT (idx + i);
+      void *v = *(void * volatile *) p;
+      if (v == ptr)
+	return p;
+      if (v == ADDR_EMPTY)
+	break;
+    }
+  return NULL;
+}
+
+/* Forget PTR.  Return non-zero if its free is to be traced.  */
+static int
+sampled_addr_remove (void *ptr)
+{
+  if (heap_sample == 0)
+    return 1;
+  if (sampled_addrs == NULL)
+    return sampled_addrs_full;
+  for (;;)
+    {
+      uint32_t seq = __atomic_load_n (&sampled_addrs_seq, __ATOMIC_ACQUIRE);
+      if ((seq & 1) == 0)
+	{
+	  void **p = sampled_addr_find (ptr);
+	  __atomic_thread_fence (__ATOMIC_ACQUIRE);
+	  if (p == NULL)
+	    {
+	      if (__atomic_load_n (&sampled_addrs_seq, __ATOMIC_RELAXED) == seq)
+		return sampled_addrs_full;
+	      continue;
+	    }
+	}
+      /* PTR was traced, or the table is being rehashed.  */
+      __collector_mutex_lock (&sampled_addrs_lock);
+      void **p = sampled_addr_find (ptr);
+      if (p != NULL)
+	{
+	  /* No other address probes past an empty slot.  */
+	  if (*SAMPLED_ADDR_SLOT (p - sampled_addrs + 1) == ADDR_EMPTY)
+	    *p = ADDR_EMPTY;
+	  else
+	    {
+	      *p = ADDR_FREED;
+	      if (++sampled_addrs_freed > SAMPLED_ADDRS_SIZE / 4)
+		sampled_addr_rehash ();
+	    }
+	}
+      __collector_mutex_unlock (&sampled_addrs_lock);
+      return p != NULL || sampled_addrs_full;
+    }
+}
+
 /*------------------------------------------------------------- malloc */
 
 void *
@@ -275,7 +488,7 @@ malloc (size_t size)
       return ret;
     }
   PUSH_REENTRANCE;
-  if (size < start_range || size >= end_range)
+  if (size < start_range || size >= end_range || !sample_allocation (size))
     {
       ret = (void *) CALL_REAL (malloc)(size);
       POP_REENTRANCE;
@@ -284,6 +497,7 @@ malloc (size_t size)
   Heap_packet hpacket = heap_packet0;
   hpacket.comm.tstamp = gethrtime ();
   ret = (void *) CALL_REAL (malloc)(size);
+  sampled_addr_put (ret);
   hpacket.mtype = MALLOC_TRACE;
   hpacket.size = (Size_type) size;
   hpacket.vaddr = (intptr_t) ret;
@@ -316,6 +530,13 @@ free (void *ptr)
       return;
     }
   PUSH_REENTRANCE;
+  /* Forget a traced address before 'free' makes it reusable */
+  if (!sampled_addr_remove (ptr))
+    {
+      CALL_REAL (free)(ptr);
+      POP_REENTRANCE;
+      return;
+    }
   /* Get a timestamp before 'free' to enforce consistency */
   Heap_packet hpacket = heap_packet0;
   hpacket.comm.tstamp = gethrtime ();
@@ -350,15 +571,42 @@ realloc (void *ptr, size_t size)
       return ret;
     }
   PUSH_REENTRANCE;
+  if (heap_sample != 0 && (size < start_range || size >= end_range
+			   || !sample_allocation (size)))
+    {
+      /* The new block is not traced, but the old one may have been */
+      int traced = ptr != NULL && sampled_addr_remove (ptr);
+      Heap_packet hpacket = heap_packet0;
+      hpacket.comm.tstamp = gethrtime ();
+      ret = (void *) CALL_REAL (realloc)(ptr, size);
+      if (traced && ret == NULL && size != 0)
+	sampled_addr_put (ptr);   /* the old block is still in use */
+      else if (traced)
+	{
+	  hpacket.mtype = FREE_TRACE;
+	  hpacket.vaddr = (intptr_t) ptr;
+	  hpacket.comm.frinfo = collector_interface->getFrameInfo (heap_hndl,
+			hpacket.comm.tstamp, FRINFO_FROM_STACK, &hpacket);
+	  collector_interface->writeDataRecord (heap_hndl, (Common_packet*) & hpacket);
+	}
+      POP_REENTRANCE;
+      return ret;
+    }
   if (size < start_range || size >= end_range)
     {
       ret = (void *) CALL_REAL (realloc)(ptr, size);
       POP_REENTRANCE;
       return ret;
     }
+  if (ptr != NULL)
+    sampled_addr_remove (ptr);
   Heap_packet hpacket = heap_packet0;
   hpacket.comm.tstamp = gethrtime ();
   ret = (void *) CALL_REAL (realloc)(ptr, size);
+  if (ret == NULL && size != 0)
+    sampled_addr_put (ptr);
+  else
+    sampled_addr_put (ret);
   hpacket.mtype = REALLOC_TRACE;
   hpacket.size = (Size_type) size;
   hpacket.vaddr = (intptr_t) ret;
@@ -382,7 +630,7 @@ memalign (size_t align, size_t size)
       return ret;
     }
   PUSH_REENTRANCE;
-  if (size < start_range || size >= end_range)
+  if (size < start_range || size >= end_range || !sample_allocation (size))
     {
       ret = (void *) CALL_REAL (memalign)(align, size);
       POP_REENTRANCE;
@@ -391,6 +639,7 @@ memalign (size_t align, size_t size)
   Heap_packet hpacket = heap_packet0;
   hpacket.comm.tstamp = gethrtime ();
   ret = (void *) CALL_REAL (memalign)(align, size);
+  sampled_addr_put (ret);
   hpacket.mtype = MALLOC_TRACE;
   hpacket.size = (Size_type) size;
   hpacket.vaddr = (intptr_t) ret;
@@ -415,7 +664,7 @@ valloc (size_t size)
       return ret;
     }
   PUSH_REENTRANCE;
-  if (size < start_range || size >= end_range)
+  if (size < start_range || size >= end_range || !sample_allocation (size))
     {
       ret = (void *) CALL_REAL (valloc)(size);
       POP_REENTRANCE;
@@ -424,6 +673,7 @@ valloc (size_t size)
   Heap_packet hpacket = heap_packet0;
   hpacket.comm.tstamp = gethrtime ();
   ret = (void *) CALL_REAL (valloc)(size);
+  sampled_addr_put (ret);
   hpacket.mtype = MALLOC_TRACE;
   hpacket.size = (Size_type) size;
   hpacket.vaddr = (intptr_t) ret;
@@ -452,7 +702,7 @@ calloc (size_t size, size_t esize)
     }
   PUSH_REENTRANCE;
   size_t sz = size * esize;
-  if (sz < start_range || sz >= end_range)
+  if (sz < start_range || sz >= end_range || !sample_allocation (sz))
     {
       ret = (void *) CALL_REAL (calloc)(size, esize);
       POP_REENTRANCE;
@@ -461,6 +711,7 @@ calloc (size_t size, size_t esize)
   Heap_packet hpacket = heap_packet0;
   hpacket.comm.tstamp = gethrtime ();
   ret = (void *) CALL_REAL (calloc)(size, esize);
+  sampled_addr_put (ret);
   hpacket.mtype = MALLOC_TRACE;
   hpacket.size = (Size_type) (size * esize);
   hpacket.vaddr = (intptr_t) ret;
@@ -480,6 +731,14 @@ __collector_heap_record (int mtype, size_t size, void *vaddr)
   if (CHCK_REENTRANCE)
     return;
   PUSH_REENTRANCE;
+  if ((mtype == MALLOC_TRACE && !sample_allocation (size))
+      || (mtype == FREE_TRACE && !sampled_addr_remove (vaddr)))
+    {
+      POP_REENTRANCE;
+      return;
+    }
+  if (mtype == MALLOC_TRACE)
+    sampled_addr_put (vaddr);
   Heap_packet hpacket = heap_packet0;
   hpacket.comm.tstamp = gethrtime ();
   hpacket.mtype = mtype;
@@ -35,6 +35,7 @@
 #include "collector.h"
 #include "gp-experiment.h"
 #include "memmgr.h"
+#include "tsd.h"
 
 /* ------------- Data and prototypes for block management --------- */
 #define IO_BLK      0 /* Concurrent requests */
@@ -46,6 +47,12 @@
 
 /* IO_BLK, IO_SEQ */
 #define NCHUNKS     64
+#define NRUN        8 /* IO_BLK blocks mapped to the file at a time */
+
+/* IO_BLK thread buffers */
+#define TBUFSZ      8192 /* Size of a thread buffer, header included */
+#define TBUF_AGE    (100 * (hrtime_t) 1000000)  /* Flush packets older than this */
+#define TBUF_IDLE   (1000 * (hrtime_t) 1000000) /* Reuse buffers unused for this long */
 
 /* IO_TXT */
 #define NBUFS  64 /* Number of text buffers */
@@ -70,6 +77,7 @@ typedef struct DataHandle
 
   /* IO_BLK, IO_SEQ */
   uint32_t nflow;           /* number of data flows */
+  uint32_t nrun;            /* number of consecutive blocks in one mapping */
   uint32_t *blkstate;       /* block states, nflow*NCHUNKS array */
   uint32_t *blkoff;         /* block offset, nflow*NCHUNKS array */
   uint32_t nchnk;           /* number of active chunks, probably small for IO_BLK */
@@ -83,8 +91,30 @@ typedef struct DataHandle
   uint64_t curpos;          /* current buffer and file offset */
 } DataHandle;
 
+/*
+ * A thread buffer collects the packets one thread writes to one IO_BLK
+ * handle, so that they are copied to the file in batches, with a single
+ * block acquisition for many packets.  Whoever fills or flushes a buffer
+ * holds it: HOLDER is set from 0 to the thread id with compare-and-swap.
+ * Buffers are never freed, only reused, so that deleteHandle can flush
+ * the ones threads still have.
+ */
+typedef struct ThreadBuffer
+{
+  struct ThreadBuffer *next;    /* next buffer in all_tbufs */
+  DataHandle *hndl;             /* handle the packets are for, NULL if unused */
+  collector_thread_t owner;     /* thread that fills the buffer */
+  uint32_t holder;              /* thread id of the holder, or 0 */
+  uint32_t len;                 /* bytes of packets in data */
+  hrtime_t first;               /* when the oldest packet in data was added */
+  hrtime_t last;                /* when a packet was last added */
+  uint8_t data[];
+} ThreadBuffer;
+
 #define PROFILE_DATAHNDL_MAX    16
 static DataHandle data_hndls[PROFILE_DATAHNDL_MAX];
+static ThreadBuffer *all_tbufs = NULL;
+static unsigned tbuf_key = COLLECTOR_TSD_INVALID_KEY;
 static int initialized = 0;
 static long blksz;          /* Block size. Multiple of page size. Power of two to make (x%blksz)==(x&(blksz-1)) fast. */
 static long log2blksz;      /* log2(blksz) to make (x/blksz)==(x>>log2blksz) fast. */
@@ -100,6 +130,9 @@ static uint8_t *getBlock (DataHandle *hndl, unsigned iflow, unsigned ichunk);
 static int remapBlock (DataHandle *hndl, unsigned iflow, unsigned ichunk);
 static int newBlock (DataHandle *hndl, unsigned iflow, unsigned ichunk);
 static void deleteBlock (DataHandle *hndl, unsigned iflow, unsigned ichunk);
+static int writePackets (DataHandle *hndl, uint8_t *data, int len, int deleting);
+static int tbufWrite (DataHandle *hndl, CM_Packet *pckt);
+static void tbufFlushAll (DataHandle *hndl);
 
 /* IO_TXT */
 static int is_not_the_log_file (char *fname);
@@ -293,9 +326,14 @@ __collector_create_handle (char *descp)
 	  if (nflow < 16)
 	    nflow = 16;
 	  hndl->nflow = (uint32_t) nflow;
+	  hndl->nrun = NRUN;
 	}
       else if (hndl->iotype == IO_SEQ)
-	hndl->nflow = 1;
+	{
+	  /* The reader expects no holes in IO_SEQ files */
+	  hndl->nflow = 1;
+	  hndl->nrun = 1;
+	}
       TprintfT (DBG_LT2, "create_handle calling allocCSize blkstate fname=`%s' nflow=%d NCHUNKS=%d size=%ld (0x%lx)\n",
 		fname, hndl->nflow, NCHUNKS,
 		(long) (hndl->nflow * NCHUNKS * sizeof (uint32_t)),
@@ -331,6 +369,10 @@ deleteHandle (DataHandle *hndl)
     return;
   hndl->active = 0;
 
+  if (hndl->iotype == IO_BLK)
+    /* Write what threads still have buffered */
+    tbufFlushAll (hndl);
+
   if (hndl->iotype == IO_BLK || hndl->iotype == IO_SEQ)
     {
       /* Delete all blocks. */
@@ -486,8 +528,10 @@ __collector_set_size_limit (char *par)
  */
 
 /*
- * Allocate a chunk (nflow blocks) contiguously in virtual memory.
- * Its blocks will be mmapped to the file individually.
+ * Allocate a chunk (nflow runs of nrun blocks) contiguously in virtual memory.
+ * Each run will be mmapped to nrun consecutive blocks of the file, so that
+ * a data flow only needs to remap (and take the address space lock) once
+ * every nrun blocks.
  */
 static int
 allocateChunk (DataHandle *hndl, unsigned ichunk)
@@ -509,7 +553,7 @@ allocateChunk (DataHandle *hndl, unsigned ichunk)
 	{
 	  /* allocate virtual memory */
 	  uint8_t *newchunk = (uint8_t*) CALL_UTIL (mmap64_) (0,
-		  (size_t) (blksz * hndl->nflow), PROT_READ | PROT_WRITE,
+		  (size_t) (blksz * hndl->nrun * hndl->nflow), PROT_READ | PROT_WRITE,
 #if ARCH(SPARC)
 		  MAP_SHARED | MAP_ANON,
 #else
@@ -520,8 +564,8 @@ allocateChunk (DataHandle *hndl, unsigned ichunk)
 	    {
 	      deleteHandle (hndl);
 	      TprintfT (DBG_LT1, " allocateChunk mmap:  start=0x%x length=%ld (0x%lx), offset=%d ret=%p\n",
-			0, (long) (blksz * hndl->nflow),
-			(long) (blksz * hndl->nflow), 0, newchunk);
+			0, (long) (blksz * hndl->nrun * hndl->nflow),
+			(long) (blksz * hndl->nrun * hndl->nflow), 0, newchunk);
 	      TprintfT (0, "allocateChunk: can't mmap MAP_ANON (for %s): %s\n", hndl->fname, CALL_UTIL (strerror) (errno));
 	      __collector_log_write ("<event kind=\"%s\" id=\"%d\" ec=\"%d\">MAP_ANON (for %s)</event>\n",
 				     SP_JCMD_CERROR, COL_ERROR_FILEMAP, errno, hndl->fname);
@@ -553,16 +597,29 @@ allocateChunk (DataHandle *hndl, unsigned ichunk)
 }
 
 /*
- * Get the address for block (iflow,ichunk).
+ * Get the address for the run of blocks (iflow,ichunk).
  */
 static uint8_t *
 getBlock (DataHandle *hndl, unsigned iflow, unsigned ichunk)
 {
-  return hndl->chunks[ichunk] + iflow * blksz;
+  return hndl->chunks[ichunk] + iflow * hndl->nrun * blksz;
+}
+
+/*
+ * Count NBLOCKS newly used blocks of HNDL against the experiment size limit.
+ */
+static void
+charge_blocks (DataHandle *hndl, int nblocks)
+{
+  if (hndl->exempt == 0)
+    exp_size_ck (nblocks, hndl->fname);
+  else
+    Tprintf (DBG_LT1, "exp_size_ck() bypassed for %d block(s); exempt fname = %s\n",
+	     nblocks, hndl->fname);
 }
 
 /*
- * Map block (iflow,ichunk) to the next part of the file.
+ * Map the run of blocks (iflow,ichunk) to the next part of the file.
  */
 static int
 remapBlock (DataHandle *hndl, unsigned iflow, unsigned ichunk)
@@ -570,10 +627,12 @@ remapBlock (DataHandle *hndl, unsigned iflow, unsigned ichunk)
   int rc = 0;
   int fd;
   /* Get the old file nblk and increment it atomically. */
+  size_t runsz = (size_t) hndl->nrun * blksz;
   uint32_t oldblk = hndl->nblk;
   for (;;)
     {
-      uint32_t newblk = __collector_cas_32 (&hndl->nblk, oldblk, oldblk + 1);
+      uint32_t newblk = __collector_cas_32 (&hndl->nblk, oldblk,
+					    oldblk + hndl->nrun);
       if (newblk == oldblk)
 	break;
       oldblk = newblk;
@@ -644,7 +703,7 @@ remapBlock (DataHandle *hndl, unsigned iflow, unsigned ichunk)
   /* Ensure disk space is allocated and the block offset is 0 */
   uint32_t zero = 0;
   int n = CALL_UTIL (pwrite64_) (fd, &zero, sizeof (zero),
-				(off64_t) (offset + blksz - sizeof (zero)));
+				(off64_t) (offset + runsz - sizeof (zero)));
   if (n <= 0)
     {
       deleteHandle (hndl);
@@ -660,14 +719,14 @@ remapBlock (DataHandle *hndl, unsigned iflow, unsigned ichunk)
   /* Map block to file */
   uint8_t *bptr = getBlock (hndl, iflow, ichunk);
   uint8_t *vaddr = (uint8_t *) CALL_UTIL (mmap64_) ((void*) bptr,
-	  (size_t) blksz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+	  runsz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
 	  fd, offset);
 
   if (vaddr != bptr)
     {
       deleteHandle (hndl);
       TprintfT (DBG_LT1, " remapBlock mmap:  start=%p length=%ld (0x%lx) offset=0x%llx ret=%p\n",
-		bptr, (long) blksz, (long) blksz, (long long) offset, vaddr);
+		bptr, (long) runsz, (long) runsz, (long long) offset, vaddr);
       TprintfT (0, "remapBlock: can't mmap file: %s : errno=%d\n", hndl->fname, errno);
       (void) __collector_log_write ("<event kind=\"%s\" id=\"%d\" ec=\"%d\">%s: remap</event>\n",
 				    SP_JCMD_CERROR, COL_ERROR_FILEMAP, errno, hndl->fname);
@@ -677,11 +736,9 @@ remapBlock (DataHandle *hndl, unsigned iflow, unsigned ichunk)
     }
   CALL_UTIL (close)(fd);
 
-  if (hndl->exempt == 0)
-    exp_size_ck (1, hndl->fname);
-  else
-    Tprintf (DBG_LT1, "exp_size_ck() bypassed for %d block(s); exempt fname = %s\n",
-	       1, hndl->fname);
+  /* Only the first block of the run counts against the size limit for
+     now; the others are counted as the writer moves into them.  */
+  charge_blocks (hndl, 1);
 exit:
   /* Restore the previous cancellation state */
   pthread_setcancelstate (old_cstate, NULL);
@@ -706,7 +763,7 @@ static void
 deleteBlock (DataHandle *hndl, unsigned iflow, unsigned ichunk)
 {
   uint8_t *bptr = getBlock (hndl, iflow, ichunk);
-  CALL_UTIL (munmap)((void*) bptr, blksz);
+  CALL_UTIL (munmap)((void*) bptr, hndl->nrun * blksz);
   hndl->blkstate[iflow * NCHUNKS + ichunk] = ST_INIT;
 
   /* Update the number of active blocks */
@@ -776,6 +833,19 @@ __collector_write_packet (DataHandle *hndl, CM_Packet *pckt)
       TprintfT (0, "collector_write_packet: packet too long: %d (max %ld)\n", recsz, blksz);
       return 1;
     }
+  if (hndl->iotype == IO_BLK && tbufWrite (hndl, pckt) == 0)
+    return 0;
+  return writePackets (hndl, (uint8_t *) pckt, recsz, 0);
+}
+
+/*
+ * Write the LEN bytes of packets at DATA to the file of HNDL.
+ * DELETING is set when deleteHandle flushes thread buffers; it deletes
+ * the blocks itself once they are all written.
+ */
+static int
+writePackets (DataHandle *hndl, uint8_t *data, int len, int deleting)
+{
   collector_thread_t tid = __collector_no_threads ? __collector_lwp_self ()
 						  : __collector_thr_self ();
   unsigned iflow = (unsigned) (((unsigned long) tid) % hndl->nflow);
@@ -814,41 +884,265 @@ __collector_write_packet (DataHandle *hndl, CM_Packet *pckt)
 
   if (state == ST_INIT && newBlock (hndl, iflow, ichunk) != 0)
       return 1;
+  /* blkoff is the offset in the run; packets never straddle a block */
   uint8_t *bptr = getBlock (hndl, iflow, ichunk);
   uint32_t blkoff = hndl->blkoff[iflow * NCHUNKS + ichunk];
-  if (blkoff + recsz > blksz)
+  for (int off = 0; off < len;)
     {
-      /* The record doesn't fit. Close the block */
-      if (blkoff < blksz)
+      CM_Packet *pckt = (CM_Packet *) (data + off);
+      int recsz = pckt->tsize;
+      if (recsz == 0)
+	break;
+      if ((blkoff & (blksz - 1)) + recsz > blksz)
 	{
+	  /* The record doesn't fit. Close the block */
 	  Common_packet *closed = (Common_packet *) (bptr + blkoff);
 	  closed->type = CLOSED_PCKT;
-	  closed->tsize = blksz - blkoff; /* redundant */
+	  closed->tsize = blksz - (blkoff & (blksz - 1)); /* redundant */
+	  blkoff = (blkoff | (blksz - 1)) + 1;
 	}
-      if (remapBlock (hndl, iflow, ichunk) != 0)
-	return 1;
-      blkoff = hndl->blkoff[iflow * NCHUNKS + ichunk];
-    }
-  if (blkoff + recsz < blksz)
-    {
-      /* Set the empty padding */
-      Common_packet *empty = (Common_packet *) (bptr + blkoff + recsz);
-      empty->type = EMPTY_PCKT;
-      empty->tsize = blksz - blkoff - recsz;
+      if (blkoff == hndl->nrun * blksz)
+	{
+	  /* The run is full */
+	  if (remapBlock (hndl, iflow, ichunk) != 0)
+	    return 1;
+	  blkoff = hndl->blkoff[iflow * NCHUNKS + ichunk];
+	}
+      else if (blkoff != 0 && (blkoff & (blksz - 1)) == 0)
+	/* First write to the next block of the run */
+	charge_blocks (hndl, 1);
+      if ((blkoff & (blksz - 1)) + recsz < blksz)
+	{
+	  /* Set the empty padding */
+	  Common_packet *empty = (Common_packet *) (bptr + blkoff + recsz);
+	  empty->type = EMPTY_PCKT;
+	  empty->tsize = blksz - (blkoff & (blksz - 1)) - recsz;
+	}
+      __collector_memcpy (bptr + blkoff, pckt, recsz);
+      blkoff += recsz;
+      off += recsz;
     }
-  __collector_memcpy (bptr + blkoff, pckt, recsz);
 
   /* Release block */
-  if (hndl->active == 0)
+  if (hndl->active == 0 && !deleting)
     {
       deleteBlock (hndl, iflow, ichunk);
       return 0;
     }
-  hndl->blkoff[iflow * NCHUNKS + ichunk] += recsz;
+  hndl->blkoff[iflow * NCHUNKS + ichunk] = blkoff;
   sptr[ichunk] = ST_FREE;
   return 0;
 }
 
+/*
+ *    IO_BLK thread buffers
+ *
+ *      Rather than acquiring a block for every packet, each thread adds
+ *      its packets to a buffer of its own for the handle, and copies them
+ *      to the file together when the buffer is full, when its oldest
+ *      packet is TBUF_AGE old, and when the handle is deleted.  The age
+ *      limit bounds what is lost if the process is killed.
+ *
+ *      A thread finds its buffers through thread-specific data, indexed
+ *      by handle.  A buffer nobody added to for TBUF_IDLE, most likely
+ *      that of a thread that has exited, is flushed and given to the next
+ *      thread that needs one.  The old owner, if it is still around, sees
+ *      that the buffer is no longer its own and looks for another.
+ *
+ *      Whoever cannot get hold of a buffer, such as a signal handler that
+ *      interrupted a thread adding to it, writes the packet directly.
+ */
+void
+__collector_ext_iolib_tsd_create_key ()
+{
+  tbuf_key = __collector_tsd_create_key (PROFILE_DATAHNDL_MAX * sizeof (ThreadBuffer *),
+					 NULL, NULL);
+}
+
+void
+__collector_iolib_fork_child_cleanup ()
+{
+  /* The buffers hold packets of the parent and are held by its threads */
+  for (ThreadBuffer *tb = all_tbufs; tb != NULL; tb = tb->next)
+    {
+      tb->hndl = NULL;
+      tb->len = 0;
+      tb->holder = 0;
+    }
+}
+
+static int
+tbufAcquire (ThreadBuffer *tb, uint32_t self)
+{
+  return __collector_cas_32 (&tb->holder, 0, self) == 0;
+}
+
+static void
+tbufRelease (ThreadBuffer *tb, uint32_t self)
+{
+  __collector_cas_32 (&tb->holder, self, 0);
+}
+
+/*
+ * Write the packets in the held buffer TB to the file.
+ */
+static void
+tbufFlush (ThreadBuffer *tb, int deleting)
+{
+  if (tb->len > 0)
+    writePackets (tb->hndl, tb->data, tb->len, deleting);
+  tb->len = 0;
+}
+
+/*
+ * Find an unused buffer, or allocate a new one, and hold it for HNDL
+ * on behalf of the calling thread SELF.
+ */
+static ThreadBuffer *
+tbufNew (DataHandle *hndl, collector_thread_t self, hrtime_t now)
+{
+  uint32_t self32 = (uint32_t) (unsigned long) self;
+  ThreadBuffer *tb;
+  for (tb = all_tbufs; tb != NULL; tb = tb->next)
+    {
+      if (tb->holder != 0 || (tb->hndl != NULL && now - tb->last < TBUF_IDLE))
+	continue;
+      if (!tbufAcquire (tb, self32))
+	continue;
+      if (tb->hndl == NULL || now - tb->last >= TBUF_IDLE)
+	break;
+      tbufRelease (tb, self32);
+    }
+  if (tb != NULL)
+    {
+      /* Write out what the last owner left */
+      if (tb->hndl != NULL && tb->hndl->active)
+	tbufFlush (tb, 0);
+    }
+  else
+    {
+      tb = (ThreadBuffer *) __collector_allocCSize (__collector_heap, TBUFSZ, 1);
+      if (tb == NULL)
+	return NULL;
+      tb->holder = self32;
+      ThreadBuffer *head = all_tbufs;
+      for (;;)
+	{
+	  tb->next = head;
+	  ThreadBuffer *old = (ThreadBuffer *) __collector_cas_ptr (&all_tbufs,
+								    head, tb);
+	  if (old == head)
+	    break;
+	  head = old;
+	}
+    }
+  tb->hndl = hndl;
+  tb->owner = self;
+  tb->len = 0;
+  tb->last = now;
+  return tb;
+}
+
+/*
+ * Add PCKT to the calling thread's buffer for HNDL.
+ * Return 0 if that was done, 1 if PCKT should be written directly.
+ */
+static int
+tbufWrite (DataHandle *hndl, CM_Packet *pckt)
+{
+  int recsz = pckt->tsize;
+  if (recsz > TBUFSZ - (int) sizeof (ThreadBuffer))
+    return 1;
+  ThreadBuffer **tbufs = (ThreadBuffer **) __collector_tsd_get_by_key (tbuf_key);
+  if (tbufs == NULL)
+    return 1;
+  collector_thread_t self = __collector_no_threads ? __collector_lwp_self ()
+						   : __collector_thr_self ();
+  uint32_t self32 = (uint32_t) (unsigned long) self;
+  hrtime_t now = __collector_gethrtime ();
+  unsigned ihndl = hndl - data_hndls;
+  ThreadBuffer *tb = tbufs[ihndl];
+  if (tb != NULL)
+    {
+      if (!tbufAcquire (tb, self32))
+	return 1;
+      if (tb->owner != self || tb->hndl != hndl)
+	{
+	  /* Another thread has taken the buffer over */
+	  tbufRelease (tb, self32);
+	  tb = NULL;
+	}
+    }
+  if (tb == NULL)
+    {
+      tb = tbufNew (hndl, self, now);
+      tbufs[ihndl] = tb;
+      if (tb == NULL)
+	return 1;
+    }
+  if (hndl->active == 0)
+    {
+      /* The handle is being deleted, and this buffer may be flushed already */
+      tbufRelease (tb, self32);
+      return 1;
+    }
+
+  if (tb->len + recsz > TBUFSZ - sizeof (ThreadBuffer))
+    tbufFlush (tb, 0);
+  if (tb->len == 0)
+    tb->first = now;
+  __collector_memcpy (tb->data + tb->len, pckt, recsz);
+  tb->len += recsz;
+  tb->last = now;
+  if (now - tb->first >= TBUF_AGE)
+    tbufFlush (tb, 0);
+  tbufRelease (tb, self32);
+  return 0;
+}
+
+/*
+ * Flush all buffers for HNDL, which is being deleted.
+ */
+static void
+tbufFlushAll (DataHandle *hndl)
+{
+  collector_thread_t self = __collector_no_threads ? __collector_lwp_self ()
+						   : __collector_thr_self ();
+  uint32_t self32 = (uint32_t) (unsigned long) self;
+  for (ThreadBuffer *tb = all_tbufs; tb != NULL; tb = tb->next)
+    {
+      if (tb->hndl != hndl)
+	continue;
+      /* Wait for the holder to finish, unless that is this thread
+	 itself, deleting the handle because a flush ran into the
+	 experiment size limit.  */
+      hrtime_t timeout = __collector_gethrtime () + 10 * ((hrtime_t) 1000000000);
+      int held = 0;
+      while (tb->holder != self32)
+	{
+	  if (tbufAcquire (tb, self32))
+	    {
+	      held = 1;
+	      break;
+	    }
+	  if (__collector_gethrtime () > timeout)
+	    {
+	      TprintfT (0, "tbufFlushAll ERROR: timeout waiting for a thread buffer for %s\n",
+			hndl->fname);
+	      break;
+	    }
+	}
+      if (!held)
+	continue;
+      if (tb->hndl == hndl)
+	{
+	  tbufFlush (tb, 1);
+	  tb->hndl = NULL;
+	}
+      tbufRelease (tb, self32);
+    }
+}
+
 /*
  *    IO_TXT files
  *
@@ -294,6 +294,7 @@ static int omp_no_walk = 0;
 #define OmpValTableSize 65536
 static unsigned long *AddrTable_RA_FROMFP = NULL; // Cache for RA_FROMFP pcs
 static unsigned long *AddrTable_RA_EOSTCK = NULL; // Cache for RA_EOSTCK pcs
+static uint64_t *AddrTable_RA_SPOFF = NULL; // Cache for pcs with the RA at a fixed sp offset
 static struct WalkContext *OmpCurCtxs = NULL;
 static struct WalkContext *OmpCtxs = NULL;
 static uint32_t *OmpVals = NULL;
@@ -445,6 +446,8 @@ __collector_ext_unwind_init (int record)
   AddrTable_RA_FROMFP = (unsigned long*) __collector_allocCSize (__collector_heap, sz, 1);
   sz = ValTableSize * sizeof (*AddrTable_RA_EOSTCK);
   AddrTable_RA_EOSTCK = (unsigned long*) __collector_allocCSize (__collector_heap, sz, 1);
+  sz = ValTableSize * sizeof (*AddrTable_RA_SPOFF);
+  AddrTable_RA_SPOFF = (uint64_t*) __collector_allocCSize (__collector_heap, sz, 1);
   if (omp_no_walk && (__collector_omp_stack_trace != NULL || __collector_mpi_stack_trace != NULL))
     {
       sz = OmpValTableSize * sizeof (*OmpCurCtxs);
@@ -1501,6 +1504,8 @@ struct AdvWalkContext
   unsigned long regs[16];
   int tidx;         /* targets table index */
   uint32_t cval;    /* cache value */
+  int fp_from_sp;   /* fp was set from sp */
+  int no_spoff;     /* sp or fp depend on more than the initial sp */
 };
 
 static unsigned long
@@ -1581,8 +1586,17 @@ static const uint32_t RA_EOSTCK = (uint32_t) - 2; /* end-of-stack */
 
 #define DELETE_CURCTX()  __collector_memcpy (cur, buf + (--nctx), sizeof (*cur))
 
+/* AddrTable_RA_SPOFF entries: the pc in the low bits,
+ * the distance in words from sp to the caller's sp in the high bits.
+ * A single 64-bit store keeps an entry consistent without locks.
+ */
+#define SPOFF_SHIFT     48
+#define SPOFF_PC_MASK   ((1ULL << SPOFF_SHIFT) - 1)
+#define SPOFF_MAX       ((1UL << (64 - SPOFF_SHIFT)) - 1)
+
 /**
- * Look for pc in AddrTable_RA_FROMFP and in AddrTable_RA_EOSTCK
+ * Look for pc in AddrTable_RA_FROMFP, AddrTable_RA_SPOFF
+ * and in AddrTable_RA_EOSTCK
  * @param wctx
  * @return
  */
@@ -1621,6 +1635,33 @@ cache_get (struct WalkContext *wctx)
 	  return RA_SUCCESS;
 	}
     }
+  if (AddrTable_RA_SPOFF != NULL)
+    {
+      uint64_t idx = wctx->pc % ValTableSize;
+      uint64_t val = AddrTable_RA_SPOFF[ idx ];
+      if (val != 0 && (val & SPOFF_PC_MASK) == wctx->pc)
+	{ // Found in AddrTable_RA_SPOFF
+	  unsigned long *sp = (unsigned long *) wctx->sp + (val >> SPOFF_SHIFT);
+	  /* validate the RA location before use */
+	  if ((unsigned long) sp > wctx->sbase)
+	    return RA_FAILURE;
+	  unsigned long ra = sp[-1];
+	  unsigned long tbgn = wctx->tbgn;
+	  unsigned long tend = wctx->tend;
+	  if (ra < tbgn || ra >= tend)
+	    if (!__collector_check_segment (ra, &tbgn, &tend, 0))
+	      return RA_FAILURE;
+	  unsigned long npc = adjust_ret_addr (ra, ra - tbgn, tend);
+	  if (npc == 0)
+	    return RA_FAILURE;
+	  DprintfT (SP_DUMP_UNWIND, "unwind.c:%d cached sp offset pc=0x%lX\n", __LINE__, npc);
+	  wctx->pc = npc;
+	  wctx->sp = (unsigned long) sp;
+	  wctx->tbgn = tbgn;
+	  wctx->tend = tend;
+	  return RA_SUCCESS;
+	}
+    }
   if (NULL == AddrTable_RA_EOSTCK)
     return RA_FAILURE;
   uint64_t idx = wctx->pc % ValTableSize;
@@ -1664,11 +1705,41 @@ cache_put (struct WalkContext *wctx, const uint32_t val)
 		// invalidate pc in RA_FROMFP cache
 		AddrTable_RA_FROMFP[ idx ] = 0;
 	    }
+	  if (NULL != AddrTable_RA_SPOFF)
+	    {
+	      if ((AddrTable_RA_SPOFF[ idx ] & SPOFF_PC_MASK) == wctx->pc)
+		// invalidate pc in RA_SPOFF cache
+		AddrTable_RA_SPOFF[ idx ] = 0;
+	    }
 	}
       return;
     }
 }
 
+/**
+ * Save pc in RA_SPOFF cache after a walk from pc, sp and fp
+ * found the caller's frame in wctx by decoding instructions.
+ * Only a walk in which sp changed by constants alone and fp
+ * was left alone gives a rule that holds for every visit of pc.
+ */
+static void
+cache_put_spoff (unsigned long pc, unsigned long sp, unsigned long fp,
+		 struct WalkContext *wctx, struct AdvWalkContext *cur)
+{
+  if (NULL == AddrTable_RA_SPOFF || cur->no_spoff || cur->ra_loc != NULL
+      || cur->cval == RA_FROMFP || wctx->fp != fp || wctx->sp <= sp)
+    return;
+  unsigned long off = (wctx->sp - sp) / sizeof (unsigned long);
+  if ((uint64_t) pc > SPOFF_PC_MASK || off > SPOFF_MAX
+      || sp + off * sizeof (unsigned long) != wctx->sp)
+    return;
+  uint64_t idx = pc % ValTableSize;
+  AddrTable_RA_SPOFF[ idx ] = ((uint64_t) off << SPOFF_SHIFT) | pc;
+  if (NULL != AddrTable_RA_EOSTCK && AddrTable_RA_EOSTCK[ idx ] == pc)
+    // invalidate pc in RA_EOSTCK cache
+    AddrTable_RA_EOSTCK[ idx ] = 0;
+}
+
 static int
 process_return_real (struct WalkContext *wctx, struct AdvWalkContext *cur, int cache_on)
 {
@@ -1894,6 +1965,9 @@ find_i386_ret_addr (struct WalkContext *wctx, int do_walk)
   int retc = cache_get (wctx);
   if (retc != RA_FAILURE)
     return retc;
+  unsigned long pc0 = wctx->pc;
+  unsigned long sp0 = wctx->sp;
+  unsigned long fp0 = wctx->fp;
 
   /* An attempt to perform code analysis for call stack tracing */
   unsigned char opcode;
@@ -2809,6 +2883,7 @@ startWalk:
 	    }
 	  else if (reg == RBP)
 	    {
+	      cur->fp_from_sp = 0;
 	      if (cur->fp_loc == cur->sp)
 		{
 		  cur->fp = cur->fp_sav;
@@ -2816,7 +2891,12 @@ startWalk:
 		}
 	      else if (cur->sp >= cur->sp_safe &&
 		       (unsigned long) cur->sp < wctx->sbase)
-		cur->fp = (unsigned long*) (*cur->sp);
+		{
+		  cur->fp = (unsigned long*) (*cur->sp);
+		  cur->no_spoff = 1;
+		  if (wctx->fp == (unsigned long) cur->sp)
+		    cur->cval = RA_FROMFP;
+		}
 	    }
 	  else if (reg == RSP)
 	    {
@@ -2827,6 +2907,7 @@ startWalk:
 		  if (nsp >= cur->sp && nsp <= cur->fp)
 		    {
 		      cur->sp = nsp;
+		      cur->no_spoff = 1;
 		    }
 		  else
 		    {
@@ -2966,7 +3047,10 @@ startWalk:
 	      if (extop == 0) /* add  imm32,%esp */
 		cur->sp = (unsigned long*) ((long) cur->sp + immz);
 	      else if (extop == 4) /* and imm32,%esp */
-		cur->sp = (unsigned long*) ((long) cur->sp & immz);
+		{
+		  cur->sp = (unsigned long*) ((long) cur->sp & immz);
+		  cur->no_spoff = 1;
+		}
 	      else if (extop == 5) /* sub imm32,%esp */
 		cur->sp = (unsigned long*) ((long) cur->sp - immz);
 	      if (cur->sp - RED_ZONE > cur->sp_safe)
@@ -2988,7 +3072,10 @@ startWalk:
 	      if (extop == 0) /* add  imm8,%esp */
 		cur->sp = (unsigned long*) ((long) cur->sp + imm8);
 	      else if (extop == 4) /* and imm8,%esp */
+		{
 		  cur->sp = (unsigned long*) ((long) cur->sp & imm8);
+		  cur->no_spoff = 1;
+		}
 	      else if (extop == 5) /* sub imm8,%esp */
 		cur->sp = (unsigned long*) ((long) cur->sp - imm8);
 	      if (cur->sp - RED_ZONE > cur->sp_safe)
@@ -3011,10 +3098,14 @@ startWalk:
 	  if (MRM_MOD (modrm) == 0xc0)
 	    {
 	      if (MRM_REGS (modrm) == RBP && MRM_REGD (modrm) == RSP)
-		/* movl %esp,%ebp */
-		cur->fp = cur->sp;
+		{ /* movl %esp,%ebp */
+		  cur->fp = cur->sp;
+		  cur->fp_from_sp = 1;
+		}
 	      else if (MRM_REGS (modrm) == RSP && MRM_REGD (modrm) == RBP)
 		{ /* mov %ebp,%esp */
+		  if (!cur->fp_from_sp)
+		    cur->no_spoff = 1;
 		  cur->sp = cur->fp;
 		  if (cur->sp - RED_ZONE > cur->sp_safe)
 		    cur->sp_safe = cur->sp - RED_ZONE;
@@ -3083,10 +3174,14 @@ startWalk:
 	  if (MRM_MOD (modrm) == 0xc0)
 	    {
 	      if (MRM_REGS (modrm) == RSP && MRM_REGD (modrm) == RBP)
-		/* mov %esp,%ebp */
-		cur->fp = cur->sp;
+		{ /* mov %esp,%ebp */
+		  cur->fp = cur->sp;
+		  cur->fp_from_sp = 1;
+		}
 	      else if (MRM_REGS (modrm) == RBP && MRM_REGD (modrm) == RSP)
 		{ /* mov %ebp,%esp */
+		  if (!cur->fp_from_sp)
+		    cur->no_spoff = 1;
 		  cur->sp = cur->fp;
 		  if (cur->sp - RED_ZONE > cur->sp_safe)
 		    cur->sp_safe = cur->sp - RED_ZONE;
@@ -3102,13 +3197,17 @@ startWalk:
 		    { /* mov disp32(%esp),%ebp */
 		      immv = read_int (cur->pc + 2, 4);
 		      unsigned long *ptr = (unsigned long*) ((char*) cur->sp + immv);
+		      cur->fp_from_sp = 0;
 		      if (cur->fp_loc == ptr)
 			{
 			  cur->fp = cur->fp_sav;
 			  cur->fp_loc = NULL;
 			}
 		      else if (ptr >= cur->sp_safe && (unsigned long) ptr < wctx->sbase)
-			cur->fp = (unsigned long*) (*ptr);
+			{
+			  cur->fp = (unsigned long*) (*ptr);
+			  cur->no_spoff = 1;
+			}
 		    }
 		}
 	    }
@@ -3120,13 +3219,17 @@ startWalk:
 		    { /* mov disp8(%esp),%ebp - JVM */
 		      imm8 = ((char*) (cur->pc))[2];
 		      unsigned long *ptr = (unsigned long*) ((char*) cur->sp + imm8);
+		      cur->fp_from_sp = 0;
 		      if (cur->fp_loc == ptr)
 			{
 			  cur->fp = cur->fp_sav;
 			  cur->fp_loc = NULL;
 			}
 		      else if (ptr >= cur->sp_safe && (unsigned long) ptr < wctx->sbase)
-			cur->fp = (unsigned long*) (*ptr);
+			{
+			  cur->fp = (unsigned long*) (*ptr);
+			  cur->no_spoff = 1;
+			}
 		    }
 		}
 	    }
@@ -3136,6 +3239,7 @@ startWalk:
 		{
 		  if (cur->pc[1] == 0x24)
 		    { /* mov (%esp),%ebp */
+		      cur->fp_from_sp = 0;
 		      if (cur->fp_loc == cur->sp)
 			{
 			  cur->fp = cur->fp_sav;
@@ -3143,7 +3247,10 @@ startWalk:
 			}
 		      else if (cur->sp >= cur->sp_safe &&
 			       (unsigned long) cur->sp < wctx->sbase)
-			cur->fp = (unsigned long*) *cur->sp;
+			{
+			  cur->fp = (unsigned long*) *cur->sp;
+			  cur->no_spoff = 1;
+			}
 		    }
 		}
 	    }
@@ -3254,6 +3361,7 @@ startWalk:
 		      goto checkFP;
 		    }
 		  cur->sp = (unsigned long *) val;
+		  cur->no_spoff = 1;
 		  if (cur->sp - RED_ZONE > cur->sp_safe)
 		    cur->sp_safe = cur->sp - RED_ZONE;
 		}
@@ -3384,6 +3492,8 @@ startWalk:
 	    int rc = process_return (wctx, cur);
 	    if (rc != RA_FAILURE)
 	      {
+		if (rc == RA_SUCCESS && jmp_reg_switch_mode == 0)
+		  cache_put_spoff (pc0, sp0, fp0, wctx, cur);
 		if (save_ctx)
 		  omp_cache_put (cur->sp_safe, &wctx_pc_save, wctx, rc);
 		return rc;
@@ -3449,8 +3559,11 @@ startWalk:
 	  break;
 	case 0xc9: /* leave */
 	  /* mov %ebp,%esp */
+	  if (!cur->fp_from_sp)
+	    cur->no_spoff = 1;
 	  cur->sp = cur->fp;
 	  /* pop %ebp */
+	  cur->fp_from_sp = 0;
 	  if (cur->fp_loc == cur->sp)
 	    {
 	      cur->fp = cur->fp_sav;
@@ -3460,6 +3573,7 @@ startWalk:
 		   (unsigned long) cur->sp < wctx->sbase)
 	    {
 	      cur->fp = (unsigned long*) (*cur->sp);
+	      cur->no_spoff = 1;
 	      if (wctx->fp == (unsigned long) cur->sp)
 		cur->cval = RA_FROMFP;
 	    }
@@ -3830,6 +3944,8 @@ startWalk:
 			  DprintfT (SP_DUMP_UNWIND, "unwind.c: give up return address under jmp switch mode, opcode = 0xff\n");
 			  goto checkFP;
 			}
+		      if (rc == RA_SUCCESS && jmp_reg_switch_mode == 0)
+			cache_put_spoff (pc0, sp0, fp0, wctx, cur);
 		      if (save_ctx)
 			omp_cache_put (cur->sp_safe, &wctx_pc_save, wctx, rc);
 		      return rc;
@@ -610,7 +610,7 @@ BaseMetric::specify ()
       username = dbe_strdup (GTXT ("Allocations"));
       snprintf (buf, sizeof (buf), NTXT ("(HTYPE!=%d)&&(HTYPE!=%d)&&HVADDR"),
 		FREE_TRACE, MUNMAP_TRACE);
-      specify_metric (buf, NTXT ("1"));
+      specify_metric (buf, NTXT ("HALLOCS"));
       cmd = dbe_strdup (NTXT ("heapalloccnt"));
       break;
     case HEAP_ALLOC_BYTES:
@@ -618,7 +618,7 @@ BaseMetric::specify ()
       username = dbe_strdup (GTXT ("Bytes Allocated"));
       snprintf (buf, sizeof (buf), NTXT ("(HTYPE!=%d)&&(HTYPE!=%d)&&HVADDR"),
 		FREE_TRACE, MUNMAP_TRACE);
-      specify_metric (buf, NTXT ("HSIZE"));
+      specify_metric (buf, NTXT ("HALLOC_BYTES"));
       cmd = dbe_strdup (NTXT ("heapallocbytes"));
       break;
     case HEAP_LEAK_CNT:
@@ -626,7 +626,7 @@ BaseMetric::specify ()
       username = dbe_strdup (GTXT ("Leaks"));
       snprintf (buf, sizeof (buf), "(HTYPE!=%d)&&(HTYPE!=%d)&&HVADDR&&HLEAKED",
 		FREE_TRACE, MUNMAP_TRACE);
-      specify_metric (buf, NTXT ("1"));
+      specify_metric (buf, NTXT ("HALLOCS"));
       cmd = dbe_strdup (NTXT ("heapleakcnt"));
       break;
     case HEAP_LEAK_BYTES:
@@ -218,6 +218,10 @@ DbeSession::DbeSession (Settings *_settings, bool _ipc_mode, bool _rdt_mode)
 			GTXT ("Current leaks"), TYPE_UINT64, 0);
   propNames_name_store (PROP_DDSCR_LNK, NTXT ("DDSCR_LNK"),
 			NULL, TYPE_UINT64, DDFLAG_NOSHOW);
+  propNames_name_store (PROP_HALLOCS, NTXT ("HALLOCS"),
+			GTXT ("Estimated allocations"), TYPE_UINT64, 0);
+  propNames_name_store (PROP_HALLOC_BYTES, NTXT ("HALLOC_BYTES"),
+			GTXT ("Estimated bytes allocated"), TYPE_UINT64, 0);
 
   // IO tracing properties
   propNames_name_store (PROP_IOTYPE, NTXT ("IOTYPE"));
@@ -508,6 +512,7 @@ DbeSession::init ()
   user_exp_id_counter = 0;
   status_ompavail = 0;
   archive_mode = 0;
+  exp_index = NULL;
 
 #if DEBUG
   char *s = getenv (NTXT ("MPMT_DEBUG"));
@@ -1116,7 +1121,7 @@ void
 DbeSession::open_experiment (Experiment *exp, char *path)
 {
   exp->open (path);
-  if (exp->get_status () != Experiment::FAILURE)
+  if (exp->get_status () != Experiment::FAILURE && exp_index == NULL)
     exp->read_experiment_data (false);
   exp->open_epilogue ();
 
@@ -72,6 +72,7 @@ class StringBuilder;
 class UserLabel;
 class DbeFile;
 class DbeJarFile;
+class ExpIndex;
 class FileData;
 class HeapData;
 template <typename ITEM> class DbeSyncMap;
@@ -392,6 +393,7 @@ public:
   Vector<char *> *tmp_files;
   int status_ompavail;
   int archive_mode;
+  ExpIndex *exp_index;      // index the experiment is restored from
   bool ipc_mode;
   bool rdt_mode;
 
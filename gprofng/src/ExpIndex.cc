@@ -0,0 +1,1087 @@
+/* Copyright (C) 2021-2025 Free Software Foundation, Inc.
+   Contributed by Oracle.
+
+   This file is part of GNU Binutils.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.  */
+
+#include "config.h"
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "util.h"
+#include "gp-experiment.h"
+#include "DbeSession.h"
+#include "DbeView.h"
+#include "DbeFile.h"
+#include "DefaultMap.h"
+#include "Emsg.h"
+#include "Experiment.h"
+#include "ExpIndex.h"
+#include "Function.h"
+#include "LoadObject.h"
+#include "Module.h"
+#include "PathTree.h"
+#include "Settings.h"
+#include "SourceFile.h"
+#include "StringMap.h"
+
+// The index file is a header followed by sections of records.
+// All fields are 64-bit words in host byte order, so that the records
+// can be used in place in the mapped file.  Strings are offsets into
+// the string table, other references are indices into a section.
+
+static const uint64_t IDX_MAGIC = 0x5844494e49504721ULL;
+static const uint64_t IDX_FORMAT = 1;
+static const uint64_t NO_IDX = (uint64_t) -1;
+
+enum
+{
+  SEC_FILES,    // IdxFile: files the index depends on
+  SEC_LOBJS,    // IdxLobj: all load objects of the session
+  SEC_MODULES,  // IdxModule
+  SEC_SOURCES,  // IdxSource
+  SEC_FUNCS,    // IdxFunc
+  SEC_LINES,    // IdxLine: line tables of the functions
+  SEC_INLINED,  // IdxInlined: inlined subroutines of the functions
+  SEC_INSTRS,   // IdxInstr
+  SEC_SLOTS,    // IdxSlot: metrics of the PathTree
+  SEC_NODES,    // IdxNode: PathTree nodes, starting from the root
+  SEC_DESC,     // node indices of the descendants
+  SEC_VALUES,   // metric values, by slot and then by node
+  SEC_STRTAB,   // strings
+  SEC_LAST
+};
+
+struct IdxSection
+{
+  uint64_t offset;
+  uint64_t count;
+};
+
+struct IdxHeader
+{
+  uint64_t magic;
+  uint64_t format;
+  uint64_t fsize;
+  uint64_t version;     // VERSION of the writer
+  uint64_t view_mode;
+  uint64_t depth;       // depth of the PathTree
+  uint64_t nentries;    // entries in the experiment directory
+  IdxSection sec[SEC_LAST];
+};
+
+struct IdxFile
+{
+  uint64_t path;
+  uint64_t in_expt;     // path is relative to the experiment directory
+  uint64_t size;
+  uint64_t mtime;
+  uint64_t mtime_nsec;
+};
+
+struct IdxLobj
+{
+  uint64_t pathname;
+  uint64_t size;
+};
+
+struct IdxModule
+{
+  uint64_t lobj;
+  uint64_t noname;      // the module is lobj->noname
+  uint64_t name;
+  uint64_t file_name;
+  uint64_t lang_code;
+  uint64_t flags;
+  uint64_t main_source;
+};
+
+struct IdxSource
+{
+  uint64_t name;
+  uint64_t unknown;     // the <Unknown> source of the session
+};
+
+struct IdxFunc
+{
+  uint64_t module;      // NO_IDX for the <Unknown> function
+  uint64_t name;
+  uint64_t mangled_name;
+  uint64_t match_name;
+  uint64_t flags;
+  uint64_t size;
+  uint64_t img_offset;
+  uint64_t def_source;
+  uint64_t line_first;
+  uint64_t line_last;
+  uint64_t lines;
+  uint64_t nlines;
+  uint64_t inlined;
+  uint64_t ninlined;
+};
+
+struct IdxLine
+{
+  uint64_t offset;
+  uint64_t size;
+  uint64_t source;
+  uint64_t lineno;
+  uint64_t line_offset;
+  uint64_t line_size;
+  uint64_t base_offset;
+};
+
+struct IdxInlined
+{
+  uint64_t source;      // NO_IDX if there is no line
+  uint64_t lineno;
+  uint64_t low_pc;
+  uint64_t high_pc;
+  uint64_t level;
+  uint64_t fname;
+};
+
+struct IdxInstr
+{
+  uint64_t func;
+  uint64_t flags;
+  uint64_t addr;
+};
+
+struct IdxSlot
+{
+  uint64_t type;
+  uint64_t cmd;
+  uint64_t expr_spec;
+  uint64_t vtype;
+};
+
+struct IdxNode
+{
+  uint64_t ancestor;
+  uint64_t instr;       // NO_IDX for the root
+  uint64_t desc;
+  uint64_t ndesc;       // NO_IDX for a leaf
+};
+
+static const size_t sec_rec_size[SEC_LAST] = {
+  sizeof (IdxFile), sizeof (IdxLobj), sizeof (IdxModule), sizeof (IdxSource),
+  sizeof (IdxFunc), sizeof (IdxLine), sizeof (IdxInlined), sizeof (IdxInstr),
+  sizeof (IdxSlot), sizeof (IdxNode), sizeof (uint64_t), sizeof (uint64_t), 1
+};
+
+#define SEC(type, s)    ((type *) ((char *) base + hdr->sec[s].offset))
+#define NSEC(s)         ((long) hdr->sec[s].count)
+
+// Files of the experiment directory that are not part of the key
+static bool
+skip_entry (const char *nm)
+{
+  return strcmp (nm, ".") == 0 || strcmp (nm, "..") == 0
+	  || strncmp (nm, NTXT (SP_INDEX_FILE), strlen (SP_INDEX_FILE)) == 0;
+}
+
+static int
+str_cmp (const void *a, const void *b)
+{
+  return strcmp (*(char **) a, *(char **) b);
+}
+
+static int
+id_cmp (const void *a, const void *b)
+{
+  Histable *h1 = *(Histable **) a;
+  Histable *h2 = *(Histable **) b;
+  return h1->id < h2->id ? -1 : h1->id > h2->id ? 1 : 0;
+}
+
+// Sorted names of the entries of a directory, or NULL
+static Vector<char*> *
+list_dir (const char *path)
+{
+  DIR *dir = opendir (path);
+  if (dir == NULL)
+    return NULL;
+  Vector<char*> *names = new Vector<char*>;
+  struct dirent *entry;
+  while ((entry = readdir (dir)) != NULL)
+    if (!skip_entry (entry->d_name))
+      names->append (dbe_strdup (entry->d_name));
+  closedir (dir);
+  names->sort (str_cmp);
+  return names;
+}
+
+ExpIndex::ExpIndex (void *_base, int64_t _fsize)
+{
+  base = _base;
+  fsize = _fsize;
+  hdr = (IdxHeader *) base;
+}
+
+ExpIndex::~ExpIndex ()
+{
+  munmap ((caddr_t) base, (size_t) fsize);
+}
+
+char *
+ExpIndex::str (uint64_t off)
+{
+  if (off >= hdr->sec[SEC_STRTAB].count)
+    return NULL;
+  return SEC (char, SEC_STRTAB) + off;
+}
+
+ExpIndex *
+ExpIndex::open (char *expt_dir, DbeView *dbev)
+{
+  char *fname = dbe_sprintf (NTXT ("%s/%s"), expt_dir, SP_INDEX_FILE);
+  int fd = open64 (fname, O_RDONLY);
+  free (fname);
+  if (fd == -1)
+    return NULL;
+  int64_t fsize = lseek (fd, 0, SEEK_END);
+  if (fsize < (int64_t) sizeof (IdxHeader))
+    {
+      close (fd);
+      return NULL;
+    }
+  void *base = mmap (NULL, (size_t) fsize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (base == MAP_FAILED)
+    return NULL;
+  ExpIndex *idx = new ExpIndex (base, fsize);
+  IdxHeader *hdr = idx->hdr;
+  bool ok = hdr->magic == IDX_MAGIC && hdr->format == IDX_FORMAT
+	  && hdr->fsize == (uint64_t) fsize;
+  for (int i = 0; ok && i < SEC_LAST; i++)
+    {
+      IdxSection *sec = hdr->sec + i;
+      ok = sec->offset % sizeof (uint64_t) == 0 && sec->offset <= hdr->fsize
+	      && sec->count <= (hdr->fsize - sec->offset) / sec_rec_size[i];
+    }
+  if (ok)
+    {
+      // The string table must end with a terminator
+      long nstr = NSEC (SEC_STRTAB);
+      ok = nstr > 0 && SEC (char, SEC_STRTAB)[nstr - 1] == 0;
+    }
+  if (ok)
+    ok = dbe_strcmp (idx->str (hdr->version), NTXT (VERSION)) == 0
+	    && hdr->view_mode == (uint64_t) dbev->get_view_mode ()
+	    && dbev->isShowAll () && idx->check_files (expt_dir);
+  if (ok)
+    {
+      // All load objects were shown when the index was written
+      Settings *settings = dbev->get_settings ();
+      IdxLobj *lobjs = SEC (IdxLobj, SEC_LOBJS);
+      for (long i = 0, sz = NSEC (SEC_LOBJS); ok && i < sz; i++)
+	{
+	  char *pathname = idx->str (lobjs[i].pathname);
+	  ok = pathname != NULL
+		  && settings->get_lo_setting (pathname) == LIBEX_SHOW;
+	}
+    }
+  if (!ok)
+    {
+      delete idx;
+      return NULL;
+    }
+  return idx;
+}
+
+bool
+ExpIndex::check_files (char *expt_dir)
+{
+  Vector<char*> *names = list_dir (expt_dir);
+  if (names == NULL)
+    return false;
+  bool ok = (uint64_t) names->size () == hdr->nentries;
+  Destroy (names);
+
+  IdxFile *files = SEC (IdxFile, SEC_FILES);
+  for (long i = 0, sz = NSEC (SEC_FILES); ok && i < sz; i++)
+    {
+      IdxFile *f = files + i;
+      char *path = str (f->path);
+      if (path == NULL)
+	return false;
+      if (f->in_expt)
+	path = dbe_sprintf (NTXT ("%s/%s"), expt_dir, path);
+      dbe_stat_t sbuf;
+      ok = dbe_stat (path, &sbuf) == 0
+	      && (uint64_t) sbuf.st_size == f->size
+	      && (uint64_t) sbuf.st_mtim.tv_sec == f->mtime
+	      && (uint64_t) sbuf.st_mtim.tv_nsec == f->mtime_nsec;
+      if (f->in_expt)
+	free (path);
+    }
+  return ok;
+}
+
+bool
+ExpIndex::restore (DbeView *dbev)
+{
+  PathTree *ptree = dbev->get_path_tree ();
+  if (dbeSession->nexps () != 1 || dbeSession->is_omp_available ()
+      || ptree->nodes != 2 || ptree->nslots != 0)
+    return false;
+  Experiment *exp = dbeSession->get_exp (0);
+  if (exp->get_status () == Experiment::FAILURE)
+    return false;
+
+  long nlobjs = NSEC (SEC_LOBJS);
+  long nmods = NSEC (SEC_MODULES);
+  long nsrcs = NSEC (SEC_SOURCES);
+  long nfuncs = NSEC (SEC_FUNCS);
+  long nlines = NSEC (SEC_LINES);
+  long ninlined = NSEC (SEC_INLINED);
+  long ninstrs = NSEC (SEC_INSTRS);
+  long nslots = NSEC (SEC_SLOTS);
+  long nnodes = NSEC (SEC_NODES);
+  long ndesc = NSEC (SEC_DESC);
+  IdxLobj *lrecs = SEC (IdxLobj, SEC_LOBJS);
+  IdxModule *mrecs = SEC (IdxModule, SEC_MODULES);
+  IdxSource *srecs = SEC (IdxSource, SEC_SOURCES);
+  IdxFunc *frecs = SEC (IdxFunc, SEC_FUNCS);
+  IdxLine *lnrecs = SEC (IdxLine, SEC_LINES);
+  IdxInlined *irecs = SEC (IdxInlined, SEC_INLINED);
+  IdxInstr *insrecs = SEC (IdxInstr, SEC_INSTRS);
+  IdxSlot *slrecs = SEC (IdxSlot, SEC_SLOTS);
+  IdxNode *nrecs = SEC (IdxNode, SEC_NODES);
+  uint64_t *desc = SEC (uint64_t, SEC_DESC);
+  int64_t *values = SEC (int64_t, SEC_VALUES);
+  if (nnodes < 1 || (uint64_t) NSEC (SEC_VALUES) != (uint64_t) nslots * nnodes)
+    return false;
+
+  // Find the load objects and the metrics, and check all references
+  // before anything is created.
+  Vector<LoadObject*> *lobjs = dbeSession->get_LoadObjects ();
+  StringMap<LoadObject*> *lomap = new StringMap<LoadObject*>(128, 128);
+  for (long i = 0, sz = VecSize (lobjs); i < sz; i++)
+    {
+      LoadObject *lo = lobjs->get (i);
+      if (dbev->get_lo_expand (lo->seg_idx) != LIBEX_SHOW)
+	{
+	  delete lomap;
+	  return false;
+	}
+      lomap->put (lo->get_pathname (), lo);
+    }
+  bool ok = VecSize (lobjs) == nlobjs;
+  LoadObject **lo_list = new LoadObject*[nlobjs];
+  for (long i = 0; ok && i < nlobjs; i++)
+    {
+      char *pathname = str (lrecs[i].pathname);
+      lo_list[i] = pathname ? lomap->get (pathname) : NULL;
+      ok = lo_list[i] != NULL;
+    }
+  delete lomap;
+  BaseMetric **bm_list = new BaseMetric*[nslots];
+  for (long i = 0; ok && i < nslots; i++)
+    {
+      IdxSlot *s = slrecs + i;
+      bm_list[i] = dbeSession->find_metric ((BaseMetric::Type) s->type,
+					    str (s->cmd), str (s->expr_spec));
+      // Slots hold VT_INT, VT_LLONG or VT_ULLONG values (see PathTree)
+      ok = bm_list[i] != NULL && (s->vtype == VT_INT || s->vtype == VT_LLONG
+				  || s->vtype == VT_ULLONG);
+    }
+  for (long i = 0; ok && i < nmods; i++)
+    ok = mrecs[i].lobj < (uint64_t) nlobjs
+	    && mrecs[i].main_source < (uint64_t) nsrcs
+	    && str (mrecs[i].name) != NULL;
+  for (long i = 0; ok && i < nsrcs; i++)
+    ok = srecs[i].unknown || str (srecs[i].name) != NULL;
+  for (long i = 0; ok && i < nfuncs; i++)
+    {
+      IdxFunc *f = frecs + i;
+      ok = f->module == NO_IDX
+	      || (f->module < (uint64_t) nmods && str (f->name) != NULL
+		  && (f->def_source == NO_IDX || f->def_source < (uint64_t) nsrcs)
+		  && f->lines <= (uint64_t) nlines
+		  && f->nlines <= (uint64_t) nlines - f->lines
+		  && f->inlined <= (uint64_t) ninlined
+		  && f->ninlined <= (uint64_t) ninlined - f->inlined);
+    }
+  for (long i = 0; ok && i < nlines; i++)
+    ok = lnrecs[i].source < (uint64_t) nsrcs;
+  for (long i = 0; ok && i < ninlined; i++)
+    ok = irecs[i].source == NO_IDX || irecs[i].source < (uint64_t) nsrcs;
+  for (long i = 0; ok && i < ninstrs; i++)
+    ok = insrecs[i].func < (uint64_t) nfuncs;
+  for (long i = 0; ok && i < nnodes; i++)
+    {
+      // Node i + 1 comes after its ancestor; the root is node 1
+      IdxNode *n = nrecs + i;
+      ok = (i == 0 ? n->ancestor == 0 && n->instr == NO_IDX
+	    : n->ancestor >= 1 && n->ancestor <= (uint64_t) i
+	    && n->instr < (uint64_t) ninstrs
+	    && nrecs[n->ancestor - 1].ndesc != NO_IDX)
+	      && (n->ndesc == NO_IDX || (n->desc <= (uint64_t) ndesc
+					 && n->ndesc <= (uint64_t) ndesc - n->desc));
+    }
+  for (long i = 0; ok && i < ndesc; i++)
+    ok = desc[i] >= 2 && desc[i] <= (uint64_t) nnodes;
+  if (!ok)
+    {
+      delete[] lo_list;
+      delete[] bm_list;
+      return false;
+    }
+
+  // Sources, modules, functions and instructions are created in the
+  // order of their original ids, so that they sort the same way.
+  SourceFile **src_list = new SourceFile*[nsrcs];
+  for (long i = 0; i < nsrcs; i++)
+    src_list[i] = srecs[i].unknown ? dbeSession->get_Unknown_Source ()
+	    : exp->get_source (str (srecs[i].name));
+
+  Module **mod_list = new Module*[nmods];
+  for (long i = 0; i < nmods; i++)
+    {
+      IdxModule *m = mrecs + i;
+      LoadObject *lo = lo_list[m->lobj];
+      Module *mod = m->noname ? lo->noname
+	      : dbeSession->createModule (lo, str (m->name));
+      mod->lang_code = (Sp_lang_code) m->lang_code;
+      mod->flags = (unsigned int) m->flags;
+      if (str (m->file_name))
+	mod->set_file_name (dbe_strdup (str (m->file_name)));
+      mod->main_source = src_list[m->main_source];
+      mod->openSourceFlag = Module::AE_OK;
+      mod_list[i] = mod;
+    }
+
+  Function **func_list = new Function*[nfuncs];
+  for (long i = 0; i < nfuncs; i++)
+    {
+      IdxFunc *f = frecs + i;
+      if (f->module == NO_IDX)
+	{
+	  func_list[i] = dbeSession->get_Unknown_Function ();
+	  continue;
+	}
+      Function *func = dbeSession->createFunction ();
+      Module *mod = mod_list[f->module];
+      func->module = mod;
+      func->flags = (unsigned int) f->flags;
+      func->size = (int64_t) f->size;
+      func->img_offset = f->img_offset;
+      func->set_mangled_name (str (f->mangled_name));
+      func->set_match_name (str (f->match_name));
+      func->Histable::set_name (dbe_strdup (str (f->name)));
+      func->set_comparable_name (str (f->name));
+      func->def_source = f->def_source == NO_IDX ? NULL
+	      : src_list[f->def_source];
+      func->line_first = (int) f->line_first;
+      func->line_last = (int) f->line_last;
+      mod->functions->append (func);
+      for (uint64_t j = f->lines; j < f->lines + f->nlines; j++)
+	{
+	  IdxLine *ln = lnrecs + j;
+	  DbeLine *dbeline = src_list[ln->source]->find_dbeline (func,
+							       (int) ln->lineno);
+	  if (dbeline == NULL)
+	    continue;
+	  dbeline->offset = ln->line_offset;
+	  dbeline->size = (int64_t) ln->line_size;
+	  dbeline->dbeline_base->offset = ln->base_offset;
+	  func->append_PC_info ((int64_t) ln->offset, (int64_t) ln->size,
+				dbeline);
+	}
+      func_list[i] = func;
+    }
+
+  // Inlined subroutines are kept in one block per module, as Dwarf does
+  for (long i = 0; i < nmods; i++)
+    {
+      Module *mod = mod_list[i];
+      uint64_t cnt = 0;
+      for (long j = 0; j < nfuncs; j++)
+	if (frecs[j].module == (uint64_t) i)
+	  cnt += frecs[j].ninlined;
+      if (cnt == 0 || mod->inlinedSubr != NULL)
+	continue;
+      mod->inlinedSubr = (InlinedSubr *) xmalloc (cnt * sizeof (InlinedSubr));
+      InlinedSubr *p = mod->inlinedSubr;
+      for (long j = 0; j < nfuncs; j++)
+	{
+	  IdxFunc *f = frecs + j;
+	  if (f->module != (uint64_t) i || f->ninlined == 0)
+	    continue;
+	  func_list[j]->inlinedSubr = p;
+	  func_list[j]->inlinedSubrCnt = (int) f->ninlined;
+	  for (uint64_t k = f->inlined; k < f->inlined + f->ninlined; k++, p++)
+	    {
+	      IdxInlined *r = irecs + k;
+	      p->dbeLine = r->source == NO_IDX ? NULL
+		      : src_list[r->source]->find_dbeline ((int) r->lineno);
+	      p->func = NULL;
+	      p->fname = dbe_strdup (str (r->fname));
+	      p->low_pc = r->low_pc;
+	      p->high_pc = r->high_pc;
+	      p->level = (int) r->level;
+	    }
+	}
+    }
+
+  // Without the symbol tables, the experiment took the mapped sizes
+  for (long i = 0; i < nlobjs; i++)
+    lo_list[i]->size = (int64_t) lrecs[i].size;
+
+  DbeInstr **instr_list = new DbeInstr*[ninstrs];
+  for (long i = 0; i < ninstrs; i++)
+    instr_list[i] = func_list[insrecs[i].func]->find_dbeinstr (
+				(int) insrecs[i].flags, insrecs[i].addr);
+
+  // The PathTree: node i + 1 of the index is node i + 1 of the tree
+  for (long i = 0; i < nslots; i++)
+    ptree->allocate_slot (bm_list[i]->get_id (), (ValueTag) slrecs[i].vtype);
+  for (long i = 1; i < nnodes; i++)
+    ptree->new_Node ((PathTree::NodeIdx) nrecs[i].ancestor,
+		     instr_list[nrecs[i].instr], nrecs[i].ndesc == NO_IDX);
+  for (long i = 0; i < nnodes; i++)
+    {
+      IdxNode *n = nrecs + i;
+      PathTree::Node *node = ptree->NODE_IDX (i + 1);
+      for (uint64_t j = n->desc; n->ndesc != NO_IDX && j < n->desc + n->ndesc; j++)
+	node->descendants->append ((PathTree::NodeIdx) desc[j]);
+      for (long k = 0; k < nslots; k++)
+	{
+	  int64_t val = values[k * nnodes + i];
+	  if (val != 0)
+	    ptree->INCREMENT_METRIC (ptree->slots + k, i + 1, val);
+	}
+    }
+  ptree->depth = (int) hdr->depth;
+  ptree->nexps = dbeSession->nexps ();
+  ptree->phaseIdx = dbev->getPhaseIdx ();
+  ptree->ftree_needs_update = true;
+
+  delete[] lo_list;
+  delete[] bm_list;
+  delete[] src_list;
+  delete[] mod_list;
+  delete[] func_list;
+  delete[] instr_list;
+  return true;
+}
+
+void
+ExpIndex::read_skipped (Experiment *exp)
+{
+  // What parse.cc and DbeSession::open_experiment skipped
+  for (long i = 0, sz = VecSize (exp->loadObjs); i < sz; i++)
+    {
+      LoadObject *lo = exp->loadObjs->get (i);
+      lo->sync_read_stabs ();
+      for (Emsg *m = lo->fetch_warnings (); m; m = m->next)
+	exp->warnq->append (m->get_warn (), m->get_msg ());
+      for (Emsg *m = lo->fetch_comments (); m; m = m->next)
+	exp->commentq->append (m->get_warn (), m->get_msg ());
+    }
+  exp->read_experiment_data (false);
+}
+
+// Growing buffer for one section of the index being written
+class IdxBuf
+{
+public:
+  IdxBuf ()
+  {
+    data = NULL;
+    len = lim = 0;
+  }
+
+  ~IdxBuf ()
+  {
+    free (data);
+  }
+
+  void
+  add (const void *p, size_t n)
+  {
+    if (len + n > lim)
+      {
+	lim = (len + n) * 2;
+	data = (char *) xrealloc (data, lim);
+      }
+    memcpy (data + len, p, n);
+    len += n;
+  }
+
+  void
+  add (uint64_t w)
+  {
+    add (&w, sizeof (w));
+  }
+
+  char *data;
+  size_t len;
+  size_t lim;
+};
+
+// String table of the index being written
+class IdxStrtab
+{
+public:
+  IdxStrtab ()
+  {
+    map = new StringMap<uint64_t>(1024, 1024);
+  }
+
+  ~IdxStrtab ()
+  {
+    delete map;
+  }
+
+  uint64_t
+  add (const char *s)
+  {
+    if (s == NULL)
+      return NO_IDX;
+    uint64_t off = map->get (s);
+    if (off == 0)
+      {
+	// Offsets are kept plus one, 0 is "not found"
+	off = buf.len + 1;
+	buf.add (s, strlen (s) + 1);
+	map->put (s, off);
+      }
+    return off - 1;
+  }
+
+  IdxBuf buf;
+
+private:
+  StringMap<uint64_t> *map;
+};
+
+static void
+add_file (IdxBuf *files, IdxStrtab *strs, const char *path, bool in_expt,
+	  const char *expt_dir)
+{
+  char *fnm = in_expt ? dbe_sprintf (NTXT ("%s/%s"), expt_dir, path)
+	  : (char *) path;
+  dbe_stat_t sbuf;
+  if (dbe_stat (fnm, &sbuf) == 0)
+    {
+      IdxFile f;
+      f.path = strs->add (path);
+      f.in_expt = in_expt ? 1 : 0;
+      f.size = (uint64_t) sbuf.st_size;
+      f.mtime = (uint64_t) sbuf.st_mtim.tv_sec;
+      f.mtime_nsec = (uint64_t) sbuf.st_mtim.tv_nsec;
+      files->add (&f, sizeof (f));
+    }
+  if (in_expt)
+    free (fnm);
+}
+
+// Return true if the index can represent FUNC
+static bool
+is_indexable (Function *func)
+{
+  if (func == dbeSession->get_Unknown_Function ())
+    return true;
+  Module *mod = func->module;
+  if (mod == NULL || mod->lang_code == Sp_lang_java
+      || func->get_type () != Histable::FUNCTION)
+    return false;
+  LoadObject *lo = mod->loadobject;
+  return (lo->flags & SEG_FLAG_DYNAMIC) == 0 && lo->platform != Java
+	  && (lo->dbeFile->filetype & DbeFile::F_FICTION) == 0;
+}
+
+void
+ExpIndex::write (char *expt_dir, DbeView *dbev)
+{
+  if (dbeSession->nexps () != 1 || dbeSession->is_omp_available ()
+      || !dbev->isShowAll ()
+      || dbev->get_settings ()->get_compare_mode () != CMP_DISABLE)
+    return;
+  Experiment *exp = dbeSession->get_exp (0);
+  if (exp->get_status () == Experiment::FAILURE || exp->broken
+      || VecSize (exp->children_exps) != 0)
+    return;
+  PathTree *ptree = dbev->get_path_tree ();
+  if (ptree->reset () != NORMAL || ptree->indxtype >= 0
+      || ptree->nodes < 2 || ptree->NODE_IDX (1)->instr != ptree->total_obj)
+    return;
+
+  // Load objects, with their paths as the key to find them again
+  Vector<LoadObject*> *lobjs = dbeSession->get_LoadObjects ();
+  DefaultMap<LoadObject*, long> *lo_idx = new DefaultMap<LoadObject*, long>;
+  StringMap<LoadObject*> *lo_names = new StringMap<LoadObject*>(128, 128);
+  bool ok = true;
+  for (long i = 0, sz = VecSize (lobjs); ok && i < sz; i++)
+    {
+      LoadObject *lo = lobjs->get (i);
+      ok = lo_names->get (lo->get_pathname ()) == NULL
+	      && dbev->get_lo_expand (lo->seg_idx) == LIBEX_SHOW;
+      lo_names->put (lo->get_pathname (), lo);
+      lo_idx->put (lo, i + 1);
+    }
+  delete lo_names;
+
+  // Instructions and functions of the nodes
+  Vector<DbeInstr*> *instrs = new Vector<DbeInstr*>;
+  Vector<Function*> *funcs = new Vector<Function*>;
+  DefaultMap<DbeInstr*, long> *instr_idx = new DefaultMap<DbeInstr*, long>;
+  DefaultMap<Function*, long> *func_idx = new DefaultMap<Function*, long>;
+  for (long i = 2; ok && i < ptree->nodes; i++)
+    {
+      Histable *obj = ptree->NODE_IDX (i)->instr;
+      ok = obj->get_type () == Histable::INSTR;
+      if (!ok)
+	break;
+      DbeInstr *instr = (DbeInstr *) obj;
+      Function *func = instr->func;
+      ok = is_indexable (func) && lo_idx->get (func->module->loadobject) != 0;
+      if (ok && instr_idx->get (instr) == 0)
+	{
+	  instrs->append (instr);
+	  instr_idx->put (instr, 1);
+	}
+      if (ok && func_idx->get (func) == 0)
+	{
+	  funcs->append (func);
+	  func_idx->put (func, 1);
+	}
+    }
+
+  // Make the modules read their line tables
+  Function *f_unknown = dbeSession->get_Unknown_Function ();
+  for (long i = 0, sz = funcs->size (); ok && i < sz; i++)
+    if (funcs->get (i) != f_unknown)
+      (void) funcs->get (i)->getDefSrc ();
+
+  // Messages of the load objects would be lost with the index
+  for (long i = 0, sz = VecSize (exp->loadObjs); ok && i < sz; i++)
+    {
+      LoadObject *lo = exp->loadObjs->get (i);
+      ok = lo->fetch_warnings () == NULL && lo->fetch_comments () == NULL;
+    }
+
+  // The metrics of the slots
+  Vector<BaseMetric*> *mlist = dbev->get_all_reg_metrics ();
+  Vector<BaseMetric*> *slot_bms = new Vector<BaseMetric*>;
+  for (int i = 0; ok && i < ptree->nslots; i++)
+    {
+      BaseMetric *bm = NULL;
+      for (long j = 0, sz = VecSize (mlist); j < sz; j++)
+	if (mlist->get (j)->get_id () == ptree->slots[i].id)
+	  {
+	    bm = mlist->get (j);
+	    break;
+	  }
+      ok = bm != NULL && dbeSession->find_metric (bm->get_type (),
+			bm->get_cmd (), bm->get_expr_spec ()) == bm;
+      slot_bms->append (bm);
+    }
+  if (!ok)
+    {
+      delete lo_idx;
+      delete instrs;
+      delete funcs;
+      delete instr_idx;
+      delete func_idx;
+      delete slot_bms;
+      return;
+    }
+
+  // Number the objects in the order of their ids
+  instrs->sort (id_cmp);
+  funcs->sort (id_cmp);
+  Vector<Module*> *mods = new Vector<Module*>;
+  Vector<SourceFile*> *srcs = new Vector<SourceFile*>;
+  DefaultMap<Module*, long> *mod_idx = new DefaultMap<Module*, long>;
+  DefaultMap<SourceFile*, long> *src_idx = new DefaultMap<SourceFile*, long>;
+  for (long i = 0, sz = instrs->size (); i < sz; i++)
+    instr_idx->put (instrs->get (i), i);
+  for (long i = 0, sz = funcs->size (); i < sz; i++)
+    {
+      Function *func = funcs->get (i);
+      func_idx->put (func, i);
+      if (func == f_unknown)
+	continue;
+      Module *mod = func->module;
+      if (mod_idx->get (mod) == 0)
+	{
+	  mods->append (mod);
+	  mod_idx->put (mod, 1);
+	}
+      Vector<SourceFile*> fsrcs;
+      fsrcs.append (func->def_source);
+      fsrcs.append (mod->getMainSrc ());
+      for (int j = 0, cnt = func->get_PC_info_count (); j < cnt; j++)
+	{
+	  int64_t offset, size;
+	  fsrcs.append (func->get_PC_info (j, offset, size)->sourceFile);
+	}
+      for (int j = 0; j < func->inlinedSubrCnt; j++)
+	{
+	  DbeLine *dbeline = func->inlinedSubr[j].dbeLine;
+	  fsrcs.append (dbeline ? dbeline->sourceFile : NULL);
+	}
+      for (long j = 0, cnt = fsrcs.size (); j < cnt; j++)
+	{
+	  SourceFile *sf = fsrcs.get (j);
+	  if (sf != NULL && src_idx->get (sf) == 0)
+	    {
+	      srcs->append (sf);
+	      src_idx->put (sf, 1);
+	    }
+	}
+    }
+  mods->sort (id_cmp);
+  srcs->sort (id_cmp);
+  for (long i = 0, sz = mods->size (); i < sz; i++)
+    mod_idx->put (mods->get (i), i);
+  for (long i = 0, sz = srcs->size (); i < sz; i++)
+    src_idx->put (srcs->get (i), i);
+
+  IdxBuf sec[SEC_LAST];
+  IdxStrtab strs;
+  IdxHeader hdr;
+  memset (&hdr, 0, sizeof (hdr));
+  hdr.magic = IDX_MAGIC;
+  hdr.format = IDX_FORMAT;
+  hdr.version = strs.add (NTXT (VERSION));
+  hdr.view_mode = (uint64_t) dbev->get_view_mode ();
+  hdr.depth = (uint64_t) ptree->depth;
+
+  // The key: the experiment directory, its archives, the load objects
+  Vector<char*> *names = list_dir (expt_dir);
+  if (names == NULL)
+    ok = false;
+  else
+    {
+      hdr.nentries = names->size ();
+      for (long i = 0, sz = names->size (); i < sz; i++)
+	add_file (sec + SEC_FILES, &strs, names->get (i), true, expt_dir);
+      Destroy (names);
+    }
+  char *arch_dir = dbe_sprintf (NTXT ("%s/%s"), expt_dir, SP_ARCHIVES_DIR);
+  names = list_dir (arch_dir);
+  free (arch_dir);
+  for (long i = 0, sz = VecSize (names); i < sz; i++)
+    {
+      char *nm = dbe_sprintf (NTXT ("%s/%s"), SP_ARCHIVES_DIR, names->get (i));
+      add_file (sec + SEC_FILES, &strs, nm, true, expt_dir);
+      free (nm);
+    }
+  if (names)
+    Destroy (names);
+
+  for (long i = 0, sz = VecSize (lobjs); i < sz; i++)
+    {
+      LoadObject *lo = lobjs->get (i);
+      IdxLobj r;
+      r.pathname = strs.add (lo->get_pathname ());
+      r.size = (uint64_t) lo->size;
+      sec[SEC_LOBJS].add (&r, sizeof (r));
+      char *location = lo->dbeFile->get_location (false);
+      if (location != NULL && (lo->dbeFile->filetype & DbeFile::F_FICTION) == 0)
+	add_file (sec + SEC_FILES, &strs, location, false, expt_dir);
+    }
+
+  for (long i = 0, sz = mods->size (); i < sz; i++)
+    {
+      Module *mod = mods->get (i);
+      IdxModule r;
+      r.lobj = lo_idx->get (mod->loadobject) - 1;
+      r.noname = mod == mod->loadobject->noname ? 1 : 0;
+      r.name = strs.add (mod->get_name ());
+      r.file_name = strs.add (mod->file_name);
+      r.lang_code = (uint64_t) mod->lang_code;
+      r.flags = (uint64_t) mod->flags;
+      r.main_source = src_idx->get (mod->getMainSrc ());
+      sec[SEC_MODULES].add (&r, sizeof (r));
+    }
+
+  for (long i = 0, sz = srcs->size (); i < sz; i++)
+    {
+      SourceFile *sf = srcs->get (i);
+      IdxSource r;
+      r.unknown = sf == dbeSession->get_Unknown_Source () ? 1 : 0;
+      r.name = strs.add (sf->get_name ());
+      sec[SEC_SOURCES].add (&r, sizeof (r));
+    }
+
+  for (long i = 0, sz = funcs->size (); i < sz; i++)
+    {
+      Function *func = funcs->get (i);
+      IdxFunc r;
+      memset (&r, 0, sizeof (r));
+      r.module = NO_IDX;
+      r.def_source = NO_IDX;
+      r.lines = sec[SEC_LINES].len / sizeof (IdxLine);
+      r.inlined = sec[SEC_INLINED].len / sizeof (IdxInlined);
+      if (func != f_unknown)
+	{
+	  r.module = mod_idx->get (func->module);
+	  r.name = strs.add (func->Histable::get_name ());
+	  r.mangled_name = strs.add (func->get_mangled_name ());
+	  r.match_name = strs.add (func->get_match_name ());
+	  r.flags = func->flags;
+	  r.size = (uint64_t) func->size;
+	  r.img_offset = func->img_offset;
+	  if (func->def_source)
+	    r.def_source = src_idx->get (func->def_source);
+	  r.line_first = (uint64_t) func->line_first;
+	  r.line_last = (uint64_t) func->line_last;
+	  r.nlines = func->get_PC_info_count ();
+	  for (uint64_t j = 0; j < r.nlines; j++)
+	    {
+	      int64_t offset, size;
+	      DbeLine *dbeline = func->get_PC_info ((int) j, offset, size);
+	      IdxLine ln;
+	      ln.offset = (uint64_t) offset;
+	      ln.size = (uint64_t) size;
+	      ln.source = src_idx->get (dbeline->sourceFile);
+	      ln.lineno = (uint64_t) dbeline->lineno;
+	      ln.line_offset = dbeline->offset;
+	      ln.line_size = (uint64_t) dbeline->size;
+	      ln.base_offset = dbeline->dbeline_base->offset;
+	      sec[SEC_LINES].add (&ln, sizeof (ln));
+	    }
+	  r.ninlined = func->inlinedSubrCnt;
+	  for (uint64_t j = 0; j < r.ninlined; j++)
+	    {
+	      InlinedSubr *p = func->inlinedSubr + j;
+	      IdxInlined in;
+	      in.source = p->dbeLine ? src_idx->get (p->dbeLine->sourceFile)
+		      : NO_IDX;
+	      in.lineno = p->dbeLine ? (uint64_t) p->dbeLine->lineno : 0;
+	      in.low_pc = p->low_pc;
+	      in.high_pc = p->high_pc;
+	      in.level = (uint64_t) p->level;
+	      in.fname = strs.add (p->fname);
+	      sec[SEC_INLINED].add (&in, sizeof (in));
+	    }
+	}
+      sec[SEC_FUNCS].add (&r, sizeof (r));
+    }
+
+  for (long i = 0, sz = instrs->size (); i < sz; i++)
+    {
+      DbeInstr *instr = instrs->get (i);
+      IdxInstr r;
+      r.func = func_idx->get (instr->func);
+      r.flags = (uint64_t) instr->flags;
+      r.addr = instr->addr;
+      sec[SEC_INSTRS].add (&r, sizeof (r));
+    }
+
+  for (long i = 0, sz = slot_bms->size (); i < sz; i++)
+    {
+      BaseMetric *bm = slot_bms->get (i);
+      IdxSlot r;
+      r.type = (uint64_t) bm->get_type ();
+      r.cmd = strs.add (bm->get_cmd ());
+      r.expr_spec = strs.add (bm->get_expr_spec ());
+      r.vtype = (uint64_t) ptree->slots[i].vtype;
+      sec[SEC_SLOTS].add (&r, sizeof (r));
+    }
+
+  long nnodes = ptree->nodes - 1;
+  for (long i = 1; i <= nnodes; i++)
+    {
+      PathTree::Node *node = ptree->NODE_IDX (i);
+      IdxNode r;
+      r.ancestor = (uint64_t) node->ancestor;
+      r.instr = i == 1 ? NO_IDX : instr_idx->get ((DbeInstr *) node->instr);
+      r.desc = sec[SEC_DESC].len / sizeof (uint64_t);
+      r.ndesc = NO_IDX;
+      if (node->descendants)
+	{
+	  r.ndesc = node->descendants->size ();
+	  for (long j = 0; j < (long) r.ndesc; j++)
+	    sec[SEC_DESC].add ((uint64_t) node->descendants->get (j));
+	}
+      sec[SEC_NODES].add (&r, sizeof (r));
+    }
+  for (int k = 0; k < ptree->nslots; k++)
+    {
+      PathTree::Slot *slot = ptree->slots + k;
+      for (long i = 1; i <= nnodes; i++)
+	{
+	  long chunk = i / PathTree::CHUNKSZ;
+	  long off = i % PathTree::CHUNKSZ;
+	  int64_t val = 0;
+	  if (slot->vtype == VT_LLONG || slot->vtype == VT_ULLONG)
+	    {
+	      if (slot->mvals64[chunk])
+		val = slot->mvals64[chunk][off];
+	    }
+	  else if (slot->mvals[chunk])
+	    val = slot->mvals[chunk][off];
+	  sec[SEC_VALUES].add ((uint64_t) val);
+	}
+    }
+  sec[SEC_STRTAB].add (strs.buf.data, strs.buf.len);
+
+  // Lay out the sections after the header, each on a word boundary
+  uint64_t offset = sizeof (hdr);
+  for (int i = 0; i < SEC_LAST; i++)
+    {
+      hdr.sec[i].offset = offset;
+      hdr.sec[i].count = sec[i].len / sec_rec_size[i];
+      offset += (sec[i].len + sizeof (uint64_t) - 1) & ~(sizeof (uint64_t) - 1);
+    }
+  hdr.fsize = offset;
+
+  // Write a temporary file and rename it, so that readers never see
+  // a partial index.  Any failure just leaves no index behind.
+  char *fname = dbe_sprintf (NTXT ("%s/%s"), expt_dir, SP_INDEX_FILE);
+  char *tmpname = dbe_sprintf (NTXT ("%s.%d"), fname, (int) getpid ());
+  int fd = ok ? open64 (tmpname, O_WRONLY | O_CREAT | O_TRUNC, 0644) : -1;
+  if (fd != -1)
+    {
+      static const char pad[sizeof (uint64_t)] = { 0 };
+      ok = ::write (fd, &hdr, sizeof (hdr)) == (ssize_t) sizeof (hdr);
+      for (int i = 0; ok && i < SEC_LAST; i++)
+	{
+	  size_t npad = -sec[i].len & (sizeof (uint64_t) - 1);
+	  ok = (sec[i].len == 0
+		|| ::write (fd, sec[i].data, sec[i].len) == (ssize_t) sec[i].len)
+		  && (npad == 0 || ::write (fd, pad, npad) == (ssize_t) npad);
+	}
+      if (close (fd) != 0)
+	ok = false;
+      if (!ok || rename (tmpname, fname) != 0)
+	unlink (tmpname);
+    }
+  free (tmpname);
+  free (fname);
+
+  delete lo_idx;
+  delete instrs;
+  delete funcs;
+  delete instr_idx;
+  delete func_idx;
+  delete slot_bms;
+  delete mods;
+  delete srcs;
+  delete mod_idx;
+  delete src_idx;
+}
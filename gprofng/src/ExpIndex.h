@@ -0,0 +1,75 @@
+/* Copyright (C) 2021-2025 Free Software Foundation, Inc.
+   Contributed by Oracle.
+
+   This file is part of GNU Binutils.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.  */
+
+#ifndef _EXP_INDEX_H
+#define _EXP_INDEX_H
+
+// An ExpIndex is a cache of the processed data of one experiment,
+// kept in the file <experiment>/index.
+//
+// It holds the functions, line tables and instructions referenced by
+// the PathTree of the view, and the PathTree nodes with their metric
+// values.  When the index is up to date, the experiment is opened
+// without reading the symbol tables of its load objects and without
+// reading its packets; the objects and the PathTree are rebuilt from
+// the mapped file instead.
+//
+// The index is keyed by the size and the modification time of every
+// file of the experiment and of every load object it refers to.
+// It is only written and used for a single experiment with no
+// descendants, seen in user, expert or machine mode with all load
+// objects shown, for the reports listed in er_print::check_args.
+
+#include "util.h"
+
+class DbeView;
+class Experiment;
+struct IdxHeader;
+
+class ExpIndex
+{
+public:
+  ~ExpIndex ();
+
+  // Map <expt_dir>/index; return NULL if it is missing or out of date
+  static ExpIndex *open (char *expt_dir, DbeView *dbev);
+
+  // Rebuild the objects and the PathTree of dbev from the index.
+  // Return false if the opened experiment does not match it.
+  bool restore (DbeView *dbev);
+
+  // Read the data that was skipped because of the index
+  static void read_skipped (Experiment *exp);
+
+  // Write <expt_dir>/index for the experiment loaded in dbev
+  static void write (char *expt_dir, DbeView *dbev);
+
+private:
+  ExpIndex (void *_base, int64_t _fsize);
+
+  char *str (uint64_t off);
+  bool check_files (char *expt_dir);
+
+  void *base;
+  int64_t fsize;
+  IdxHeader *hdr;
+};
+
+#endif /* _EXP_INDEX_H */
@@ -27,6 +27,7 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include <sys/param.h>
 #include <set>
 
@@ -975,6 +976,9 @@ Experiment::ExperimentHandler::startElement (char*, char*, char *qName, Attribut
       else if (strcmp (str, NTXT ("heaptrace")) == 0)
 	{
 	  exp->coll_params.heap_mode = 1;
+	  str = attrs->getValue (NTXT ("sample"));
+	  if (str != NULL)
+	    exp->coll_params.heap_sample = atoll (str);
 	  exp->leaklistavail = true;
 	  exp->heapdataavail = true;
 	  exp->register_metric (Metric::HEAP_ALLOC_BYTES);
@@ -3566,6 +3570,52 @@ Experiment::get_iotrace_events ()
   return dDscr;
 }
 
+// An allocation of HSIZE bytes is in a sampled experiment with probability
+// 1 - exp(-HSIZE/heap_sample).  Return the number of allocations it stands for.
+static double
+heap_sample_weight (Size hsize, long long heap_sample)
+{
+  if (heap_sample <= 0 || hsize == 0)
+    return 1.0;
+  return 1.0 / -expm1 (-(double) hsize / heap_sample);
+}
+
+// Metrics sum integer event values, so the weighted estimates have to be
+// rounded somewhere.  Rounding each event biases the totals whenever the
+// weight is not a whole number.  Instead keep the exact running sums per
+// call stack and give each event the step in their rounded values.  The
+// total for a call stack then differs from the exact one by less than one,
+// and that of a function by less than the number of stacks it is on.
+struct HeapEstimate
+{
+  double allocs, bytes;
+  uint64_t allocs_rounded, bytes_rounded;
+};
+
+static uint64_t
+heap_scaled_step (double &sum, uint64_t &rounded, double val)
+{
+  sum += val;
+  uint64_t total = (uint64_t) (sum + 0.5);
+  uint64_t step = total - rounded;
+  rounded = total;
+  return step;
+}
+
+// Return the running sums for the call stack FRINFO in ESTIMATES.
+static HeapEstimate *
+heap_estimate (DefaultMap<uint64_t, HeapEstimate*> *estimates,
+	       uint64_t frinfo)
+{
+  HeapEstimate *est = estimates->get (frinfo);
+  if (est == NULL)
+    {
+      est = new HeapEstimate ();
+      estimates->put (frinfo, est);
+    }
+  return est;
+}
+
 DataDescriptor *
 Experiment::get_heap_events ()
 {
@@ -3631,12 +3681,27 @@ Experiment::get_heap_events ()
   prop->flags = DDFLAG_NOSHOW;
   dDscr->addProperty (prop);
 
+  // Estimates for the allocations that were not sampled
+  prop = new PropDescr (PROP_HALLOCS, NTXT ("HALLOCS"));
+  prop->uname = dbe_strdup (GTXT ("Estimated Allocations"));
+  prop->vtype = TYPE_UINT64;
+  dDscr->addProperty (prop);
+
+  prop = new PropDescr (PROP_HALLOC_BYTES, NTXT ("HALLOC_BYTES"));
+  prop->uname = dbe_strdup (GTXT ("Estimated Bytes Allocated"));
+  prop->vtype = TYPE_UINT64;
+  dDscr->addProperty (prop);
+
   DataView *dview = dDscr->createView ();
   dview->sort (PROP_TSTAMP);
 
   // Keep track of memory usage
   Size memoryUsage = 0;
 
+  // Running totals of the weighted allocations, per call stack
+  DefaultMap<uint64_t, HeapEstimate*> *estimates =
+	  new DefaultMap<uint64_t, HeapEstimate*>;
+
   HeapMap *heapmap = new HeapMap ();
   long sz = dview->getSize ();
   for (long i = 0; i < sz; i++)
@@ -3654,6 +3719,15 @@ Experiment::get_heap_events ()
 	  dview->setValue (PROP_TSTAMP2, i, (uint64_t) MAX_TIME);
 	  if (vaddr)
 	    {
+	      double w = heap_sample_weight (hsize, coll_params.heap_sample);
+	      HeapEstimate *est = heap_estimate (estimates,
+				      dview->getULongValue (PROP_FRINFO, i));
+	      hsize = heap_scaled_step (est->bytes, est->bytes_rounded,
+					hsize * w);
+	      dview->setValue (PROP_HALLOCS, i,
+			       heap_scaled_step (est->allocs,
+						 est->allocs_rounded, w));
+	      dview->setValue (PROP_HALLOC_BYTES, i, hsize);
 	      dview->setValue (PROP_HLEAKED, i, hsize);
 	      heapmap->allocate (vaddr, i + 1);
 
@@ -3674,7 +3748,7 @@ Experiment::get_heap_events ()
 		  memoryUsage -= leaked;
 		  dview->setValue (PROP_HMEM_USAGE, i, memoryUsage);
 
-		  Size alloc = dview->getLongValue (PROP_HSIZE, idx);
+		  Size alloc = dview->getLongValue (PROP_HALLOC_BYTES, idx);
 		  // update allocation
 		  dview->setValue (PROP_HLEAKED, idx, (uint64_t) 0);
 		  dview->setValue (PROP_TSTAMP2, idx, tstamp);
@@ -3697,7 +3771,7 @@ Experiment::get_heap_events ()
 		  memoryUsage -= leaked;
 		  dview->setValue (PROP_HMEM_USAGE, i, memoryUsage);
 
-		  Size alloc = dview->getLongValue (PROP_HSIZE, idx);
+		  Size alloc = dview->getLongValue (PROP_HALLOC_BYTES, idx);
 		  // update allocation
 		  dview->setValue (PROP_HLEAKED, idx, (uint64_t) 0);
 		  dview->setValue (PROP_TSTAMP2, idx, tstamp);
@@ -3708,6 +3782,15 @@ Experiment::get_heap_events ()
 	    }
 	  if (vaddr)
 	    {
+	      double w = heap_sample_weight (hsize, coll_params.heap_sample);
+	      HeapEstimate *est = heap_estimate (estimates,
+				      dview->getULongValue (PROP_FRINFO, i));
+	      hsize = heap_scaled_step (est->bytes, est->bytes_rounded,
+					hsize * w);
+	      dview->setValue (PROP_HALLOCS, i,
+			       heap_scaled_step (est->allocs,
+						 est->allocs_rounded, w));
+	      dview->setValue (PROP_HALLOC_BYTES, i, hsize);
 	      dview->setValue (PROP_HLEAKED, i, hsize);
 	      heapmap->allocate (vaddr, i + 1);
 
@@ -3726,6 +3809,8 @@ Experiment::get_heap_events ()
 	      if (mtype == MMAP_TRACE)
 		{
 		  dview->setValue (PROP_TSTAMP2, i, (uint64_t) MAX_TIME);
+		  dview->setValue (PROP_HALLOCS, i, (uint64_t) 1);
+		  dview->setValue (PROP_HALLOC_BYTES, i, hsize);
 		  dview->setValue (PROP_HLEAKED, i, hsize);
 		  list = heapmap->mmap (vaddr, hsize, i);
 
@@ -3789,6 +3874,9 @@ Experiment::get_heap_events ()
     }
   delete heapmap;
   delete dview;
+  Vector<HeapEstimate*> *est_list = estimates->values ();
+  Destroy (est_list);
+  delete estimates;
 
   return dDscr;
 }
@@ -3845,7 +3933,7 @@ Experiment::create_heapsz_data_view (DataView *heap_dview)
   long sz = dview->getSize ();
   for (long i = 0; i < sz; i++)
     {
-      int64_t hsize = (int64_t) dview->getULongValue (PROP_HSIZE, i);
+      int64_t hsize = (int64_t) dview->getULongValue (PROP_HALLOC_BYTES, i);
       uint64_t leaks = dview->getULongValue (PROP_HLEAKED, i);
       long alloc_pkt_id = dview->getIdByIdx (i);
       update_heapsz_packet (pkt_id_set, dview, alloc_pkt_id, hsize, leaks);
@@ -4315,7 +4403,11 @@ Experiment::write_coll_params ()
   if (coll_params.heap_mode == 1)
     {
       sb.setLength (0);
-      sb.append (GTXT ("  Heap tracing"));
+      if (coll_params.heap_sample > 0)
+	sb.sprintf (GTXT ("  Heap tracing, sampling one allocation per %lld bytes"),
+		    coll_params.heap_sample);
+      else
+	sb.append (GTXT ("  Heap tracing"));
       commentq->append (new Emsg (CMSG_COMMENT, sb));
     }
   if (coll_params.io_mode == 1)
@@ -4454,43 +4546,66 @@ check_mstate (char *ptr, PacketDescriptor *pDscr, int arg)
 
 #define PACKET_ALIGNMENT 4
 
-uint64_t
-Experiment::readPacket (Data_window *dwin, Data_window::Span *span)
+// Bind the packet at SPAN->offset and return its address, or NULL if
+// there is nothing to process there.  *PCKTSZ is set to the number of
+// bytes to skip to the next packet, or to 0 at the end of the data.
+static char *
+bind_packet (Data_window *dwin, Data_window::Span *span, uint64_t *pcktsz,
+	     int *invalid)
 {
   Common_packet *rcp = (Common_packet *) dwin->bind (span,
 						    sizeof (CommonHead_packet));
   uint16_t v16;
   uint64_t size = 0;
+  *pcktsz = 0;
   if (rcp)
     {
       if ((((long) rcp) % PACKET_ALIGNMENT) != 0)
 	{
-	  invalid_packet++;
-	  size = PROFILE_BUFFER_CHUNK - span->offset % PROFILE_BUFFER_CHUNK;
-	  return size;
+	  (*invalid)++;
+	  *pcktsz = PROFILE_BUFFER_CHUNK - span->offset % PROFILE_BUFFER_CHUNK;
+	  return NULL;
 	}
       v16 = (uint16_t) rcp->tsize;
       size = dwin->decode (v16);
       if (size == 0)
 	{
-	  size = PROFILE_BUFFER_CHUNK - span->offset % PROFILE_BUFFER_CHUNK;
-	  return size;
+	  *pcktsz = PROFILE_BUFFER_CHUNK - span->offset % PROFILE_BUFFER_CHUNK;
+	  return NULL;
 	}
       rcp = (Common_packet *) dwin->bind (span, size);
     }
   if (rcp == NULL)
-    return 0;
+    return NULL;
 
   if ((((long) rcp) % PACKET_ALIGNMENT) != 0)
     {
-      invalid_packet++;
-      size = PROFILE_BUFFER_CHUNK - span->offset % PROFILE_BUFFER_CHUNK;
-      return size;
+      (*invalid)++;
+      *pcktsz = PROFILE_BUFFER_CHUNK - span->offset % PROFILE_BUFFER_CHUNK;
+      return NULL;
     }
-  v16 = (uint16_t) rcp->type;
+  *pcktsz = size;
+  return (char *) rcp;
+}
+
+uint64_t
+Experiment::readPacket (Data_window *dwin, Data_window::Span *span)
+{
+  uint64_t size;
+  char *ptr = bind_packet (dwin, span, &size, &invalid_packet);
+  if (ptr != NULL)
+    processPacket (dwin, ptr, size);
+  return size;
+}
+
+void
+Experiment::processPacket (Data_window *dwin, char *ptr, uint64_t size)
+{
+  Common_packet *rcp = (Common_packet *) ptr;
+  uint16_t v16 = (uint16_t) rcp->type;
   uint32_t rcptype = dwin->decode (v16);
   if (rcptype == EMPTY_PCKT)
-    return size;
+    return;
   if (rcptype == FRAME_PCKT)
     {
       RawFramePacket *fp = new RawFramePacket;
@@ -4504,7 +4619,7 @@ Experiment::readPacket (Data_window *dwin, Data_window::Span *span)
 	{
 	  invalid_packet++;
 	  delete fp;
-	  return size;
+	  return;
 	}
       v16 = (uint16_t) ((Frame_packet*) rcp)->tsize;
       char *end = (char*) rcp + dwin->decode (v16);
@@ -4627,7 +4742,7 @@ Experiment::readPacket (Data_window *dwin, Data_window::Span *span)
 	  ptr += hsize;
 	}
       frmpckts->append (fp);
-      return size;
+      return;
     }
   else if (rcptype == UID_PCKT)
     {
@@ -4637,7 +4752,7 @@ Experiment::readPacket (Data_window *dwin, Data_window::Span *span)
       v16 = (uint16_t) rcp->tsize;
       size_t arr_length = dwin->decode (v16) - sizeof (Uid_packet);
       if (arr_length <= 0)
-	return size;
+	return;
       uint64_t link_uid = (uint64_t) 0;
       if (dwin->decode (uidp->flags) & COMPRESSED_INFO)
 	{
@@ -4656,15 +4771,15 @@ Experiment::readPacket (Data_window *dwin, Data_window::Span *span)
       else
 	add_uid (dwin, uid, (int) (arr_length / sizeof (uint64_t)),
 		 (uint64_t*) arr_bytes, link_uid);
-      return size;
+      return;
     }
 
   PacketDescriptor *pcktDescr = getPacketDescriptor (rcptype);
   if (pcktDescr == NULL)
-    return size;
+    return;
   DataDescriptor *dataDescr = pcktDescr->getDataDescriptor ();
   if (dataDescr == NULL)
-    return size;
+    return;
 
   /* omazur: TBR START -- old experiment */
   if (rcptype == PROF_PCKT)
@@ -4680,7 +4795,6 @@ Experiment::readPacket (Data_window *dwin, Data_window::Span *span)
     }
   else
     readPacket (dwin, (char*) rcp, pcktDescr, dataDescr, 0, size);
-  return size;
 }
 
 static uint32_t get_v32(char *p)
@@ -4783,6 +4897,149 @@ Experiment::readPacket (Data_window *dwin, char *ptr, PacketDescriptor *pDscr,
     }
 }
 
+// Large data files are read in parallel.  The collector never lets a
+// packet straddle a block (a power of two, at least 64KB), so a file can
+// be cut at any multiple of PARALLEL_READ_SPAN and each piece walked on
+// its own.  Workers bind, validate and copy out the packets of a piece;
+// the copies are then processed in file order on the calling thread, so
+// the records and tags come out exactly as in a serial read.
+#define PARALLEL_READ_SPAN  (4 * 1024 * 1024)
+#define PARALLEL_READ_BATCH 16  // pieces in flight at a time
+#define PARALLEL_READ_MIN   (4 * PARALLEL_READ_SPAN)
+
+typedef struct
+{
+  char *fname;
+  bool need_swap_endian;
+  int64_t start;        // offset of the first packet
+  int64_t end;          // walk up to this offset
+  int64_t stop;         // offset where the walk stopped
+  bool eod;             // the walk hit the end of the data
+  int invalid;          // count of invalid packets
+  char *buf;            // packets, each preceded by its size
+  size_t buf_used;
+  size_t buf_size;
+} packet_span_ctx;
+
+static int
+read_packet_span (void *arg)
+{
+  packet_span_ctx *ctx = (packet_span_ctx *) arg;
+  ctx->stop = ctx->start;
+  ctx->eod = false;
+  Data_window *dwin = new Data_window (ctx->fname);
+  if (dwin->not_opened ())
+    {
+      // Nothing is copied; the next piece will not line up and the
+      // caller reads the rest serially.
+      delete dwin;
+      return 0;
+    }
+  dwin->need_swap_endian = ctx->need_swap_endian;
+
+  Data_window::Span span;
+  span.offset = ctx->start;
+  span.length = dwin->get_fsize () - ctx->start;
+  while (span.offset < ctx->end)
+    {
+      uint64_t pcktsz;
+      char *ptr = bind_packet (dwin, &span, &pcktsz, &ctx->invalid);
+      if (pcktsz == 0)
+	{
+	  ctx->eod = true;
+	  break;
+	}
+      if (ptr != NULL)
+	{
+	  size_t need = sizeof (uint64_t) + ((pcktsz + 7) & ~(uint64_t) 7);
+	  if (ctx->buf_used + need > ctx->buf_size)
+	    {
+	      ctx->buf_size = ctx->buf_size * 2 + need;
+	      ctx->buf = (char *) xrealloc (ctx->buf, ctx->buf_size);
+	    }
+	  *(uint64_t *) (ctx->buf + ctx->buf_used) = pcktsz;
+	  memcpy (ctx->buf + ctx->buf_used + sizeof (uint64_t), ptr, pcktsz);
+	  ctx->buf_used += need;
+	}
+      span.length -= pcktsz;
+      span.offset += pcktsz;
+    }
+  ctx->stop = span.offset;
+  delete dwin;
+  return 0;
+}
+
+// Process the packets of *SPAN in parallel for as long as the pieces line
+// up with the serial walk.  *SPAN is advanced past what was processed.
+// Return true if the end of the data was reached.
+bool
+Experiment::read_packet_spans (Data_window *dwin, Data_window::Span *span,
+			       char *progress_bar_msg)
+{
+  int64_t fsize = span->offset + span->length;
+  packet_span_ctx ctxs[PARALLEL_READ_BATCH];
+  memset (ctxs, 0, sizeof (ctxs));
+  while (span->offset < fsize)
+    {
+      int nctx = 0;
+      DbeThreadPool *threadPool = new DbeThreadPool (-1);
+      for (int64_t off = span->offset;
+	   off < fsize && nctx < PARALLEL_READ_BATCH; nctx++)
+	{
+	  packet_span_ctx *ctx = ctxs + nctx;
+	  ctx->fname = dwin->fname;
+	  ctx->need_swap_endian = dwin->need_swap_endian;
+	  ctx->start = off;
+	  off = (off / PARALLEL_READ_SPAN + 1) * PARALLEL_READ_SPAN;
+	  if (off > fsize)
+	    off = fsize;
+	  ctx->end = off;
+	  ctx->invalid = 0;
+	  ctx->buf_used = 0;
+	  threadPool->put_queue (new DbeQueue (read_packet_span, ctx));
+	}
+      threadPool->wait_queues ();
+      delete threadPool;
+
+      bool done = false;
+      for (int i = 0; i < nctx; i++)
+	{
+	  packet_span_ctx *ctx = ctxs + i;
+	  if (ctx->start != span->offset
+	      || (ctx->stop == ctx->start && !ctx->eod))
+	    {
+	      // The previous piece ended inside a packet of this one,
+	      // or this one could not be read.  Let the caller continue
+	      // serially from here.
+	      done = true;
+	      break;
+	    }
+	  for (size_t n = 0; n < ctx->buf_used;)
+	    {
+	      uint64_t pcktsz = *(uint64_t *) (ctx->buf + n);
+	      processPacket (dwin, ctx->buf + n + sizeof (uint64_t), pcktsz);
+	      n += sizeof (uint64_t) + ((pcktsz + 7) & ~(uint64_t) 7);
+	    }
+	  invalid_packet += ctx->invalid;
+	  span->length -= ctx->stop - span->offset;
+	  span->offset = ctx->stop;
+	  if (ctx->eod)
+	    {
+	      for (int j = 0; j < PARALLEL_READ_BATCH; j++)
+		free (ctxs[j].buf);
+	      return true;
+	    }
+	}
+      theApplication->set_progress ((int) (100 * span->offset / fsize),
+				    progress_bar_msg);
+      if (done)
+	break;
+    }
+  for (int j = 0; j < PARALLEL_READ_BATCH; j++)
+    free (ctxs[j].buf);
+  return span->offset >= fsize;
+}
+
 #define PROG_BYTE 102400 // update progress bar every PROG_BYTE bytes
 
 void
@@ -4810,6 +5067,10 @@ Experiment::read_data_file (const char *fname, const char *msg)
   total_len = remain_len = span.length;
   progress_bar_msg = dbe_sprintf (NTXT ("%s %s"), NTXT ("  "), msg);
   invalid_packet = 0;
+  if (span.length >= PARALLEL_READ_MIN
+      && read_packet_spans (dwin, &span, progress_bar_msg))
+    span.length = 0;
+  remain_len = span.length;
   for (;;)
     {
       uint64_t pcktsz = readPacket (dwin, &span);
@@ -501,6 +501,9 @@ protected:
   class ExperimentLabelsHandler;
 
   uint64_t readPacket (Data_window *dwin, Data_window::Span *span);
+  void processPacket (Data_window *dwin, char *ptr, uint64_t size);
+  bool read_packet_spans (Data_window *dwin, Data_window::Span *span,
+			  char *progress_bar_msg);
   void readPacket (Data_window *dwin, char *ptr, PacketDescriptor *pDscr,
 		   DataDescriptor *dDscr, int arg, uint64_t pktsz);
 
@@ -478,6 +478,37 @@ Function::copy_PCInfo (Function *from)
     }
 }
 
+int
+Function::get_PC_info_count ()
+{
+  return linetab ? linetab->size () : 0;
+}
+
+DbeLine *
+Function::get_PC_info (int i, int64_t &offset, int64_t &pc_size)
+{
+  PCInfo *pcinf = linetab->fetch (i);
+  offset = pcinf->offset;
+  pc_size = pcinf->size;
+  return pcinf->src_info->src_line;
+}
+
+// Append an entry with its final size; entries come in offset order
+void
+Function::append_PC_info (int64_t offset, int64_t pc_size, DbeLine *dbeline)
+{
+  if (linetab == NULL)
+    linetab = new Vector<PCInfo*>;
+  PCInfo *pcinfo = new PCInfo;
+  pcinfo->offset = offset;
+  pcinfo->size = pc_size;
+  SrcInfo *srcInfo = new_srcInfo ();
+  srcInfo->src_line = dbeline;
+  srcInfo->included_from = NULL;
+  pcinfo->src_info = srcInfo;
+  linetab->append (pcinfo);
+}
+
 void
 Function::add_PC_info (uint64_t offset, int lineno, SourceFile *cur_src)
 {
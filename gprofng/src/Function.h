@@ -98,6 +98,11 @@ public:
   SourceFile *popSrcFile ();
   int func_cmp (Function *func, SourceFile *srcContext = NULL);
   void copy_PCInfo (Function *f);
+
+  // Line table entries, as saved and restored by ExpIndex
+  int get_PC_info_count ();
+  DbeLine *get_PC_info (int i, int64_t &offset, int64_t &pc_size);
+  void append_PC_info (int64_t offset, int64_t pc_size, DbeLine *dbeline);
   DbeLine *mapPCtoLine (uint64_t addr, SourceFile *src = NULL);
   DbeInstr *mapLineToPc (DbeLine *dbeLine);
   DbeInstr *find_dbeinstr (int flag, uint64_t addr);
@@ -343,6 +343,8 @@ HeapActivity::computeCallStack (Histable::Type type, VMode viewMode)
       for (long i = 0; i < sz; ++i)
 	{
 	  uint64_t nByte = heapPkts->getULongValue (PROP_HSIZE, i);
+	  uint64_t estBytes = heapPkts->getULongValue (PROP_HALLOC_BYTES, i);
+	  int32_t cnt = heapPkts->getIntValue (PROP_HALLOCS, i);
 	  uint64_t stackId = (uint64_t) getStack (viewMode, heapPkts, i);
 	  Heap_type heapType = (Heap_type) heapPkts->getIntValue (PROP_HTYPE, i);
 	  uint64_t leaked = heapPkts->getULongValue (PROP_HLEAKED, i);
@@ -374,16 +376,20 @@ HeapActivity::computeCallStack (Histable::Type type, VMode viewMode)
 	      else
 		continue;
 
-	      hData->addAllocEvent (nByte);
-	      hDataTotal->addAllocEvent (nByte);
-	      hDataTotal->setAllocStat (nByte);
+	      hData->addAllocEvent (estBytes, cnt);
+	      hDataTotal->addAllocEvent (estBytes, cnt);
+	      hDataTotal->setAllocStat (nByte, cnt);
 	      hDataTotal->setPeakMemUsage (heapSize, hData->getStackId (),
 					   timestamp, pid, userExpId);
 	      if (leaked > 0)
 		{
-		  hData->addLeakEvent (leaked);
-		  hDataTotal->addLeakEvent (leaked);
-		  hDataTotal->setLeakStat (leaked);
+		  hData->addLeakEvent (leaked, cnt);
+		  hDataTotal->addLeakEvent (leaked, cnt);
+		  // A malloc'd block leaks as a whole, and its HLEAKED is the
+		  // estimate for all the blocks it stands for.  Only mmap'd
+		  // regions, which are not sampled, can leak in part.
+		  hDataTotal->setLeakStat (heapType == MMAP_TRACE ? leaked : nByte,
+					   cnt);
 		}
 	      break;
 	    case MUNMAP_TRACE:
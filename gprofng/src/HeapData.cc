@@ -210,75 +210,75 @@ HeapData::setPeakMemUsage (int64_t pmu, uint64_t sId, hrtime_t ts, int procId, i
 }
 
 void
-HeapData::setAllocStat (int64_t nb)
+HeapData::setAllocStat (int64_t nb, int32_t cnt)
 {
   if (aSmallestBytes > nb)
     aSmallestBytes = nb;
   if (aLargestBytes < nb)
     aLargestBytes = nb;
   if (nb >= 0 && nb <= _1KB)
-    a0KB1KBCnt++;
+    a0KB1KBCnt += cnt;
   else if (nb <= _8KB)
-    a1KB8KBCnt++;
+    a1KB8KBCnt += cnt;
   else if (nb <= _32KB)
-    a8KB32KBCnt++;
+    a8KB32KBCnt += cnt;
   else if (nb <= _128KB)
-    a32KB128KBCnt++;
+    a32KB128KBCnt += cnt;
   else if (nb <= _256KB)
-    a128KB256KBCnt++;
+    a128KB256KBCnt += cnt;
   else if (nb <= _512KB)
-    a256KB512KBCnt++;
+    a256KB512KBCnt += cnt;
   else if (nb <= _1000KB)
-    a512KB1000KBCnt++;
+    a512KB1000KBCnt += cnt;
   else if (nb <= _10MB)
-    a1000KB10MBCnt++;
+    a1000KB10MBCnt += cnt;
   else if (nb <= _100MB)
-    a10MB100MBCnt++;
+    a10MB100MBCnt += cnt;
   else if (nb <= _1GB)
-    a100MB1GBCnt++;
+    a100MB1GBCnt += cnt;
   else if (nb <= _10GB)
-    a1GB10GBCnt++;
+    a1GB10GBCnt += cnt;
   else if (nb <= _100GB)
-    a10GB100GBCnt++;
+    a10GB100GBCnt += cnt;
   else if (nb <= _1TB)
-    a100GB1TBCnt++;
+    a100GB1TBCnt += cnt;
   else if (nb <= _10TB)
-    a1TB10TBCnt++;
+    a1TB10TBCnt += cnt;
 }
 
 void
-HeapData::setLeakStat (int64_t nb)
+HeapData::setLeakStat (int64_t nb, int32_t cnt)
 {
   if (lSmallestBytes > nb)
     lSmallestBytes = nb;
   if (lLargestBytes < nb)
     lLargestBytes = nb;
   if (nb >= 0 && nb <= _1KB)
-    l0KB1KBCnt++;
+    l0KB1KBCnt += cnt;
   else if (nb <= _8KB)
-    l1KB8KBCnt++;
+    l1KB8KBCnt += cnt;
   else if (nb <= _32KB)
-    l8KB32KBCnt++;
+    l8KB32KBCnt += cnt;
   else if (nb <= _128KB)
-    l32KB128KBCnt++;
+    l32KB128KBCnt += cnt;
   else if (nb <= _256KB)
-    l128KB256KBCnt++;
+    l128KB256KBCnt += cnt;
   else if (nb <= _512KB)
-    l256KB512KBCnt++;
+    l256KB512KBCnt += cnt;
   else if (nb <= _1000KB)
-    l512KB1000KBCnt++;
+    l512KB1000KBCnt += cnt;
   else if (nb <= _10MB)
-    l1000KB10MBCnt++;
+    l1000KB10MBCnt += cnt;
   else if (nb <= _100MB)
-    l10MB100MBCnt++;
+    l10MB100MBCnt += cnt;
   else if (nb <= _1GB)
-    l100MB1GBCnt++;
+    l100MB1GBCnt += cnt;
   else if (nb <= _10GB)
-    l1GB10GBCnt++;
+    l1GB10GBCnt += cnt;
   else if (nb <= _100GB)
-    l10GB100GBCnt++;
+    l10GB100GBCnt += cnt;
   else if (nb <= _1TB)
-    l100GB1TBCnt++;
+    l100GB1TBCnt += cnt;
   else if (nb <= _10TB)
-    l1TB10TBCnt++;
+    l1TB10TBCnt += cnt;
 }
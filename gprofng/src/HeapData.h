@@ -86,10 +86,10 @@ public:
   }
 
   void
-  addAllocEvent (uint64_t nb)
+  addAllocEvent (uint64_t nb, int32_t cnt = 1)
   {
     allocBytes += nb;
-    allocCnt++;
+    allocCnt += cnt;
   }
 
   uint64_t
@@ -105,10 +105,10 @@ public:
   }
 
   void
-  addLeakEvent (uint64_t nb)
+  addLeakEvent (uint64_t nb, int32_t cnt = 1)
   {
     leakBytes += nb;
-    leakCnt++;
+    leakCnt += cnt;
   }
 
   uint64_t
@@ -201,7 +201,7 @@ public:
     return userExpId;
   }
 
-  void setAllocStat (int64_t nb);
+  void setAllocStat (int64_t nb, int32_t cnt = 1);
 
   int64_t
   getASmallestBytes ()
@@ -299,7 +299,7 @@ public:
     return a1TB10TBCnt;
   }
 
-  void setLeakStat (int64_t nb);
+  void setLeakStat (int64_t nb, int32_t cnt = 1);
 
   int64_t
   getLSmallestBytes ()
@@ -258,6 +258,7 @@ public:
 
 class DbeLine : public Histable
 {
+  friend class ExpIndex;
 public:
 
   enum Flag
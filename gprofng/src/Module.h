@@ -69,6 +69,8 @@ public:
 class Module : public HistableFile
 {
 public:
+  friend class ExpIndex;
+
   // Annotated Source or Disassembly
   enum Anno_Errors
   {
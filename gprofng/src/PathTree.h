@@ -37,6 +37,7 @@ typedef enum
 class PathTree
 {
 public:
+  friend class ExpIndex;
 
   PathTree (DbeView *_dbev, int _indxtype = -1)
   {
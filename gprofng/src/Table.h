@@ -174,6 +174,8 @@ enum Prop_type
   PROP_HCUR_ALLOCS, // int64_t (net allocations running total.  Recomputed after each filter)
   PROP_HCUR_NET_ALLOC, // int64_t (net allocation for this packet.  Recomputed after each filter)
   PROP_HCUR_LEAKS,  // Size (net leaks running total.  Recomputed after each filter)
+  PROP_HALLOCS,     // uint64_t (estimated allocations made by this event)
+  PROP_HALLOC_BYTES, // Size (estimated bytes alloc'd by this event)
 
   // DATA_IOTRACE
   PROP_IOTYPE,      // IOTrace_type IOTracePacket::iotype
@@ -568,7 +568,10 @@ Coll_Ctrl::show (int i)
 	sb.appendf ("\t  %u. %s\n", ii + 1,
 		hwc_hwcentry_specd_string (ctrbuf, sizeof (ctrbuf), &hwctr[ii]));
     }
-  if (heaptrace_mode != NULL)
+  if (heaptrace_mode != NULL && strncmp (heaptrace_mode, "sample=", 7) == 0)
+    sb.appendf (GTXT ("\theap tracing enabled, sampling one allocation per %s bytes\n"),
+		heaptrace_mode + 7);
+  else if (heaptrace_mode != NULL)
     sb.append (GTXT ("\theap tracing enabled\n"));
   if (iotrace_enabled != 0)
     sb.append (GTXT ("\tI/O tracing enabled\n"));
@@ -1064,6 +1067,22 @@ Coll_Ctrl::set_heaptrace (const char *string)
 	       GTXT ("Incorrect range in heap trace parameter '%s'\n"), string);
       heaptrace_mode = xstrdup (string);
     }
+  else if (strncmp (string, "sample", 6) == 0
+	   && (string[6] == 0 || string[6] == '='))
+    {
+      // Sample allocations, one per N bytes allocated on average
+      unsigned long long n = HEAPTRACE_SAMPLE_DEFAULT;
+      if (string[6] == '=')
+	{
+	  char *s;
+	  n = isdigit (string[7]) ? strtoull (string + 7, &s, 0) : 0;
+	  if (n == 0 || *s != 0)
+	    return dbe_sprintf (
+	       GTXT ("Incorrect sampling interval in heap trace parameter '%s'\n"),
+	       string);
+	}
+      heaptrace_mode = dbe_sprintf ("sample=%llu", n);
+    }
   else
     return dbe_sprintf (GTXT ("Unrecognized heap tracing parameter `%s'\n"),
 			string);
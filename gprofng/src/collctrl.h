@@ -61,6 +61,9 @@ typedef struct {
 #define PROFINT_MIN 500
 #define PROFINT_MAX 1000000
 
+/* Mean number of bytes allocated between heap trace samples */
+#define HEAPTRACE_SAMPLE_DEFAULT (512 * 1024)
+
 class Coll_Ctrl {
 public:
 
@@ -340,7 +343,7 @@ private:
   /* 	definitions in data_pckts.h */
   int synctrace_scope;
 
-  char *heaptrace_mode; /* NULL, or on, or off, or range */
+  char *heaptrace_mode; /* NULL, or on, or off, or range, or sample=N */
   int iotrace_enabled;  /* T if I/O tracing */
 
   /* count controls */
@@ -110,6 +110,7 @@ struct Collection_params
   int sync_scope;       // value of synctrace scope: Java and/or native
 
   int heap_mode;        // if heaptrace is on
+  long long heap_sample; // mean bytes between sampled allocations, or 0
   int io_mode;          // if iotrace is on
   int race_mode;        // if race-detection is on
   int race_stack;       // setting for stack data collection
@@ -1467,8 +1467,9 @@ collect::usage ()
     "                       \"n\" selects native/Pthreads, \"j\" selects Java, and \"nj\" selects both;\n"
     "                       the default is \"-s off\".\n"
     "\n"
-    " -H {off|on|N1[-N2]}  disable (off), or enable (on) heap tracing, or\n"
-    "                      specify the heap data collection range. The default is \"-H off\".\n"
+    " -H {off|on|N1[-N2]|sample[=N]}  disable (off), or enable (on) heap tracing, or\n"
+    "                      specify the heap data collection range, or trace one allocation\n"
+    "                      per N bytes allocated on average. The default is \"-H off\".\n"
     "\n"
     " -i {off|on}        disable (off), or enable (on) I/O tracing; the default is \"-i off\".\n"
     "\n"
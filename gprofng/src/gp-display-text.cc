@@ -29,6 +29,7 @@
 #include "DbeApplication.h"
 #include "DbeSession.h"
 #include "Experiment.h"
+#include "ExpIndex.h"
 #include "Emsg.h"
 #include "DbeView.h"
 #include "DataObject.h"
@@ -169,11 +170,13 @@ er_print::er_print (int argc, char *argv[])
   limit = 0;
   cstack = new Vector<Histable*>();
   was_QQUIT = false;
+  index_dir = NULL;
 }
 
 er_print::~er_print ()
 {
   free (cov_string);
+  free (index_dir);
   delete cstack;
   if (inp_file != stdin)
     fclose (inp_file);
@@ -199,6 +202,8 @@ er_print::start (int argc, char *argv[])
     }
   dbeDetectLoadMachineModel (dbevindex);
   run (argc, argv);
+  if (index_dir != NULL)
+    ExpIndex::write (index_dir, dbev);
 }
 
 bool
@@ -392,8 +397,29 @@ er_print::check_args (int argc, char *argv[])
       exit (1);
     }
 
+  // An up to date index replaces reading the load objects and packets
+  ExpIndex *exp_index = NULL;
+  if (exp_no == 1 && use_index (argc, argv))
+    {
+      index_dir = dbe_strdup (exp_list->get (0)->get (0));
+      exp_index = ExpIndex::open (index_dir, dbev);
+      dbeSession->exp_index = exp_index;
+    }
+
   // add the experiments to the session
   char *errstr = dbeOpenExperimentList (0, exp_list, false);
+  if (exp_index != NULL)
+    {
+      dbeSession->exp_index = NULL;
+      if (exp_index->restore (dbev))
+	{
+	  free (index_dir);
+	  index_dir = NULL;
+	}
+      else
+	ExpIndex::read_skipped (dbeSession->get_exp (0));
+      delete exp_index;
+    }
   for (long i = 0; i < exp_list->size (); i++)
     {
       Vector<char*>* p = exp_list->get (i);
@@ -409,6 +435,47 @@ er_print::check_args (int argc, char *argv[])
   return exp_no;
 }
 
+// Return true if the command line only prints reports that can be
+// computed from an experiment index (see ExpIndex.h)
+bool
+er_print::use_index (int argc, char *argv[])
+{
+  char *s = getenv ("GPROFNG_INDEX");
+  if (s != NULL && strcasecmp (s, "no") == 0)
+    return false;
+  bool report = false;
+  for (int i = 1; i < argc; i++)
+    {
+      if (*argv[i] != '-')
+	continue;
+      int arg_count, cparam;
+      switch (Command::get_command (argv[i] + 1, arg_count, cparam))
+	{
+	case FUNCS:
+	case HOTLINES:
+	case GPROF:
+	case CALLTREE:
+	  report = true;
+	  break;
+	case METRIC_LIST:
+	case GMETRIC_LIST:
+	case METRICS:
+	case SORT:
+	case LIMIT:
+	case NAMEFMT:
+	case PRINTMODE:
+	case OUTFILE:
+	case APPENDFILE:
+	case WHOAMI:
+	  break;
+	default:
+	  return false;
+	}
+      i += arg_count;
+    }
+  return report;
+}
+
 int
 er_print::is_valid_seg_name (char *lo_name, int prev)
 {
@@ -54,9 +54,11 @@ private:
   int limit;
   Vector<Histable*> *cstack;
   bool was_QQUIT;
+  char *index_dir;      // experiment to write an index for, or NULL
 
   // override methods in base class
   int check_args (int argc, char *argv[]);
+  bool use_index (int argc, char *argv[]);
   void usage ();
 
   int is_valid_seg_name (char *seg_name, int prev);
@@ -738,7 +738,7 @@ Experiment::process_seg_map_cmd (char */*cmd*/, hrtime_t ts, Vaddr vaddr,
 	      lo->dbeFile->sbuf.st_mtime = 0; // Don't check timestamps
 	      free (archName);
 	    }
-	  if (!dbeSession->archive_mode)
+	  if (!dbeSession->archive_mode && dbeSession->exp_index == NULL)
 	    lo->sync_read_stabs ();
 	}
       append (lo);
@@ -0,0 +1,34 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Heap sampling test: make NALLOCS allocations of different sizes and
+   report how many allocations and bytes there were, so that the
+   estimates of a sampled experiment can be checked.  Up to NLIVE
+   blocks are kept live at a time.  */
+
+#define NLIVE 1024
+
+static void *live[NLIVE];
+
+int
+main (int argc, char **argv)
+{
+  long nallocs = argc > 1 ? atol (argv[1]) : 1000000;
+  long long nbytes = 0;
+
+  for (long i = 0; i < nallocs; i++)
+    {
+      size_t size = 16 + (i * 7919) % 4096;
+      char *p = malloc (size);
+      if (p == NULL)
+	return 1;
+      p[0] = p[size - 1] = (char) i;
+      nbytes += size;
+      free (live[i % NLIVE]);
+      live[i % NLIVE] = p;
+    }
+  for (int i = 0; i < NLIVE; i++)
+    free (live[i]);
+  printf ("allocs=%ld bytes=%lld\n", nallocs, nbytes);
+  return 0;
+}
@@ -0,0 +1,84 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Collector overhead benchmark: NTHREADS threads spin for SECONDS
+   seconds and the work done per thread per second is reported, along
+   with the CPU time used by the process.  */
+
+typedef long long hrtime_t;
+
+hrtime_t
+gethrtime (void)
+{
+  struct timespec tp;
+  hrtime_t rc = 0;
+#ifdef CLOCK_MONOTONIC_RAW
+  int r = clock_gettime (CLOCK_MONOTONIC_RAW, &tp);
+#else
+  int r = clock_gettime (CLOCK_MONOTONIC, &tp);
+#endif
+
+  if (r == 0)
+    rc = ((hrtime_t) tp.tv_sec) * 1e9 + (hrtime_t) tp.tv_nsec;
+  return rc;
+}
+
+static int seconds = 2;
+
+__attribute__ ((noinline)) static long
+leaf (long x)
+{
+  for (int j = 0; j < 10000; j++)
+    x = x * 3 + j;
+  return x;
+}
+
+__attribute__ ((noinline)) static long
+middle (long x)
+{
+  return leaf (x) + 1;
+}
+
+static void *
+spin (void *arg)
+{
+  long long *count = (long long *) arg;
+  volatile long x = 0;
+  hrtime_t end = gethrtime () + seconds * (hrtime_t) 1000000000;
+  do
+    {
+      x = middle (x);
+      (*count)++;
+    }
+  while (gethrtime () < end);
+  return NULL;
+}
+
+int
+main (int argc, char **argv)
+{
+  int nthreads = argc > 1 ? atoi (argv[1]) : 4;
+  if (argc > 2)
+    seconds = atoi (argv[2]);
+  if (nthreads < 1 || seconds < 1)
+    return 1;
+
+  pthread_t *tids = (pthread_t *) calloc (nthreads, sizeof (pthread_t));
+  long long *counts = (long long *) calloc (nthreads, sizeof (long long));
+  for (int i = 0; i < nthreads; i++)
+    pthread_create (&tids[i], NULL, spin, &counts[i]);
+  long long total = 0;
+  for (int i = 0; i < nthreads; i++)
+    {
+      pthread_join (tids[i], NULL);
+      total += counts[i];
+    }
+  struct timespec cpu;
+  clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &cpu);
+  printf ("threads=%d rate=%lld cpu=%.3f\n", nthreads,
+	  total / nthreads / seconds,
+	  (double) cpu.tv_sec + (double) cpu.tv_nsec / 1e9);
+  return 0;
+}
@@ -919,7 +919,9 @@ extern int ctf_arc_write_fd (int, ctf_dict_t **, size_t, const char **,
 extern int ctf_link_add_ctf (ctf_dict_t *, ctf_archive_t *, const char *name);
 
 /* Do the deduplicating link, filling the dict with types.  The FLAGS are the
-   CTF_LINK_* flags above.  */
+   CTF_LINK_* flags above.  Where threads are supported, the types of the
+   inputs are hashed by one thread per processor, or by as many threads as
+   LIBCTF_DEDUP_THREADS in the environment says: the result is the same.  */
 
 extern int ctf_link (ctf_dict_t *, int flags);
 
@@ -189,6 +189,10 @@ typedef struct disassemble_info
 #define USER_SPECIFIED_MACHINE_TYPE (1u << 29)
   /* Set if the user has requested wide output.  */
 #define WIDE_OUTPUT (1u << 28)
+  /* Set if the caller only wants the instruction length and the branch
+     information below, not the text of the instruction.  Disassemblers
+     may then skip formatting and printing the instruction.  */
+#define DISASSEMBLE_NO_TEXT (1u << 27)
 
   /* Dynamic relocations, if they have been loaded.  */
   arelent **dynrelbuf;
@@ -152,6 +152,13 @@ extern int
 sframe_find_fre (sframe_decoder_ctx *ctx, int32_t pc,
 		 sframe_frame_row_entry *frep);
 
+/* Build a flat index of the SFrame Frame Row Entries in the decoder context
+   DCTX, sorted on PC, for faster lookups by sframe_find_fre.  Worthwhile
+   when many lookups are going to be done.  Returns SFRAME_ERR if failure.  */
+
+extern int
+sframe_decoder_build_index (sframe_decoder_ctx *dctx);
+
 /* Get the FRE_IDX'th FRE of the function at FUNC_IDX'th function
    index entry in the SFrame decoder CTX.  Returns error code as
    applicable.  */
@@ -432,6 +432,9 @@ ctf_add_generic (ctf_dict_t *fp, uint32_t flag, const char *name, int kind,
   if (LCTF_INDEX_TO_TYPE (fp, fp->ctf_typemax, 1) == (CTF_MAX_PTYPE - 1))
     return (ctf_set_typed_errno (fp, ECTF_FULL));
 
+  if (ctf_hash_static_names (fp) < 0)
+    return CTF_ERR;				/* errno is set for us.  */
+
   /* Prohibit addition of a root-visible type that is already present
      in the non-dynamic portion. */
 
@@ -1448,16 +1451,32 @@ ctf_add_func_sym (ctf_dict_t *fp, const char *name, ctf_id_t id)
 int
 ctf_track_enumerator (ctf_dict_t *fp, ctf_id_t type, const char *cte_name)
 {
+  const ctf_strs_t *strtab = &fp->ctf_str[CTF_STRTAB_0];
   int err;
 
   if (ctf_dynhash_lookup_type (fp->ctf_names, cte_name) == 0)
     {
-      uint32_t name = ctf_str_add (fp, cte_name);
+      uint32_t name;
 
-      if (name == 0)
-	return -1;				/* errno is set for us.  */
+      /* Constants of static enums are already in the strtab, and are hashed
+	 directly, like static type names: passing them through ctf_str_add
+	 would pull the entire strtab into the atoms table.  */
+
+      if (cte_name >= strtab->cts_strs
+	  && cte_name < strtab->cts_strs + strtab->cts_len)
+	{
+	  err = ctf_dynhash_insert (fp->ctf_names, (char *) cte_name,
+				    (void *) (uintptr_t) type);
+	  if (err != 0)
+	    ctf_set_errno (fp, err * -1);
+	}
+      else
+	{
+	  if ((name = ctf_str_add (fp, cte_name)) == 0)
+	    return -1;				/* errno is set for us.  */
 
-      err = ctf_dynhash_insert_type (fp, fp->ctf_names, type, name);
+	  err = ctf_dynhash_insert_type (fp, fp->ctf_names, type, name);
+	}
     }
   else
     {
@@ -21,6 +21,10 @@
 #include <string.h>
 #include <errno.h>
 #include <assert.h>
+#include <unistd.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 #include "hashtab.h"
 
 /* (In the below, relevant functions are named in square brackets.)  */
@@ -109,6 +113,17 @@
    down the volume of output (hundreds of gigabytes of debug output are not
    uncommon on larger links).
 
+   [ctf_dedup_hash_inputs, ctf_dedup_hash_input_worker]
+   Hashing an input only ever populates cd_type_hashes with GIDs in that
+   input (even types in a parent are cached under the GID of the child citing
+   them), so on hosts with threads the inputs are hashed concurrently, one
+   input per thread at a time.  Each input gets its own type hash cache and a
+   record of the types it populated in the order it populated them: the atoms
+   table, decorated names, struct origins and citers are shared, under a lock.
+   Once all inputs are hashed, the records are replayed into cd_type_hashes
+   and the output mapping in input order, so the result is exactly the same as
+   hashing the inputs one after another.
+
    We have to do *something* about potential cycles in the type graph.  We'd
    like to avoid emitting forwards in the final output if possible, because
    forwards aren't much use: they have no members.  We are mostly saved from
@@ -151,10 +166,14 @@
 
    2) COLLISIONAL MARKING.
 
-   [ctf_dedup_detect_name_ambiguity, ctf_dedup_mark_conflicting_hash]
+   [ctf_dedup_count_names, ctf_dedup_detect_name_ambiguity,
+    ctf_dedup_mark_conflicting_hash]
    We identify types whose names collide during the hashing process, and count
    the rough number of uses of each name (caching may throw it off a bit: this
-   doesn't need to be accurate).  We then mark the less-frequently-cited types
+   doesn't need to be accurate).  The hashing pass only counts how often each
+   type is seen: the names are counted once hashing is done, so that big enums
+   cited from everywhere do not have all their enumerators recounted each
+   time.  We then mark the less-frequently-cited types
    with each names conflicting: the most-frequently-cited one goes into the
    shared type dictionary, while all others are duplicated into per-TU
    dictionaries, named after the input TU, that have the shared dictionary as a
@@ -287,6 +306,71 @@
 # define CTF_DEDUP_GID_TO_TYPE(id) (ctf_id_t) (((uint64_t) id) & ~(0xffffffff00000000ULL))
 #endif
 
+/* Inputs can be hashed in parallel only if there are threads, and GIDs need
+   no allocation: the pool behind id_to_packed_id is not shared safely.  */
+
+#if defined (HAVE_PTHREAD_H) && defined (HAVE_PTHREAD_CREATE) \
+  && !defined (IDS_NEED_ALLOCATION)
+# define CTF_DEDUP_THREADS 1
+
+/* A type hashed while hashing inputs in parallel, and the number of times its
+   hash was used.  These are kept in hashing order, and replayed into the
+   output mapping in that order once hashing is done.  */
+
+typedef struct ctf_dedup_hashed
+{
+  ctf_list_t cdt_list;
+  ctf_id_t cdt_type;
+  void *cdt_id;
+  const char *cdt_decorated;
+  const char *cdt_hval;
+  long cdt_count;
+} ctf_dedup_hashed_t;
+
+/* The hashing state of a single input.  */
+
+typedef struct ctf_dedup_input_hashes
+{
+  ctf_dynhash_t *cdi_type_hashes;	/* GID -> ctf_dedup_hashed_t.  */
+  ctf_list_t cdi_hashed;		/* In hashing order.  */
+} ctf_dedup_input_hashes_t;
+
+/* The state shared by all threads hashing inputs: cd_hashing points to it
+   while they run.  */
+
+struct ctf_dedup_hashing
+{
+  pthread_mutex_t cdh_lock;		/* Protects all shared dedup state.  */
+  ctf_dict_t *cdh_output;
+  ctf_dict_t **cdh_inputs;
+  uint32_t cdh_ninputs;
+  uint32_t cdh_next_input;		/* The next input to hash.  */
+  int cdh_err;				/* The first error seen, if any.  */
+  ctf_dedup_input_hashes_t *cdh_input_hashes;
+};
+#endif
+
+/* Lock and unlock the dedup state shared between threads hashing inputs, if
+   there are any.  */
+
+static void
+ctf_dedup_lock (ctf_dict_t *fp _libctf_unused_)
+{
+#ifdef CTF_DEDUP_THREADS
+  if (fp->ctf_dedup.cd_hashing)
+    pthread_mutex_lock (&fp->ctf_dedup.cd_hashing->cdh_lock);
+#endif
+}
+
+static void
+ctf_dedup_unlock (ctf_dict_t *fp _libctf_unused_)
+{
+#ifdef CTF_DEDUP_THREADS
+  if (fp->ctf_dedup.cd_hashing)
+    pthread_mutex_unlock (&fp->ctf_dedup.cd_hashing->cdh_lock);
+#endif
+}
+
 #ifdef IDS_NEED_ALLOCATION
 
  /* This is the 32-bit path, which stores GIDs in a pool and returns a pointer
@@ -351,7 +435,7 @@ make_set_element (ctf_dynhash_t *set, const void *key)
 
   if ((element = ctf_dynhash_lookup (set, key)) == NULL)
     {
-      if ((element = ctf_dynset_create (htab_hash_string,
+      if ((element = ctf_dynset_create (ctf_hash_type_hash_raw,
 					htab_eq_string,
 					NULL)) == NULL)
 	return NULL;
@@ -384,10 +468,11 @@ ctf_dedup_atoms_init (ctf_dict_t *fp)
   return 0;
 }
 
-/* Intern things in the dedup atoms table.  */
+/* Intern things in the dedup atoms table.  The caller must hold the dedup
+   lock.  */
 
 static const char *
-intern (ctf_dict_t *fp, char *atom)
+intern_1 (ctf_dict_t *fp, char *atom)
 {
   const void *foo;
 
@@ -409,6 +494,17 @@ intern (ctf_dict_t *fp, char *atom)
   return (const char *) foo;
 }
 
+static const char *
+intern (ctf_dict_t *fp, char *atom)
+{
+  const char *ret;
+
+  ctf_dedup_lock (fp);
+  ret = intern_1 (fp, atom);
+  ctf_dedup_unlock (fp);
+  return ret;
+}
+
 /* Add an indication of the namespace to a type name in a way that is not valid
    for C identifiers.  Used to maintain hashes of type names to other things
    while allowing for the four C namespaces (normal, struct, union, enum).
@@ -441,6 +537,7 @@ ctf_decorate_type_name (ctf_dict_t *fp, const char *name, int kind)
       i = 3;
     }
 
+  ctf_dedup_lock (fp);
   if ((ret = ctf_dynhash_lookup (d->cd_decorated_names[i], name)) == NULL)
     {
       char *str;
@@ -450,17 +547,19 @@ ctf_decorate_type_name (ctf_dict_t *fp, const char *name, int kind)
 
       p = stpcpy (str, k);
       strcpy (p, name);
-      ret = intern (fp, str);
+      ret = intern_1 (fp, str);
       if (!ret)
 	goto oom;
 
       if (ctf_dynhash_cinsert (d->cd_decorated_names[i], name, ret) < 0)
 	goto oom;
     }
+  ctf_dedup_unlock (fp);
 
   return ret;
 
  oom:
+  ctf_dedup_unlock (fp);
   ctf_set_errno (fp, ENOMEM);
   return NULL;
 }
@@ -524,7 +623,9 @@ ctf_dedup_record_origin (ctf_dict_t *fp, int input_num, const char *decorated,
   ctf_dedup_t *d = &fp->ctf_dedup;
   void *origin;
   int populate_origin = 0;
+  int ret = 0;
 
+  ctf_dedup_lock (fp);
   if (ctf_dynhash_lookup_kv (d->cd_struct_origin, decorated, NULL, &origin))
     {
       if (CTF_DEDUP_GID_TO_INPUT (origin) != input_num
@@ -542,10 +643,67 @@ ctf_dedup_record_origin (ctf_dict_t *fp, int input_num, const char *decorated,
 
   if (populate_origin)
     if (ctf_dynhash_cinsert (d->cd_struct_origin, decorated, origin) < 0)
-      return ctf_set_errno (fp, errno);
+      ret = -1;
+  ctf_dedup_unlock (fp);
+
+  if (ret < 0)
+    return ctf_set_errno (fp, errno);
   return 0;
 }
 
+/* Note that HVAL cites the type with hash CITER, or all the types with
+   hashes in the CITERS set (which is freed).  Returns -1 with errno set on
+   error.  */
+
+static int
+ctf_dedup_add_citers (ctf_dict_t *fp, const char *citer,
+		      ctf_dynset_t *citers, const char *hval)
+{
+  ctf_dedup_t *d = &fp->ctf_dedup;
+  ctf_dynset_t *citer_hashes;
+  ctf_next_t *i = NULL;
+  const void *k;
+  int err;
+
+  ctf_dedup_lock (fp);
+  if (citer)
+    {
+      if ((citer_hashes = make_set_element (d->cd_citers, citer)) == NULL)
+	goto oom;
+      if (ctf_dynset_cinsert (citer_hashes, hval) < 0)
+	goto oom;
+    }
+  else if (citers)
+    {
+      while ((err = ctf_dynset_cnext (citers, &i, &k)) == 0)
+	{
+	  citer = (const char *) k;
+
+	  if ((citer_hashes = make_set_element (d->cd_citers, citer)) == NULL)
+	    goto oom_iter;
+
+	  if (ctf_dynset_exists (citer_hashes, hval, NULL))
+	    continue;
+	  if (ctf_dynset_cinsert (citer_hashes, hval) < 0)
+	    goto oom_iter;
+	}
+      if (err != ECTF_NEXT_END)
+	{
+	  errno = err;
+	  goto oom;
+	}
+      ctf_dynset_destroy (citers);
+    }
+  ctf_dedup_unlock (fp);
+  return 0;
+
+ oom_iter:
+  ctf_next_destroy (i);
+ oom:
+  ctf_dedup_unlock (fp);
+  return -1;
+}
+
 /* Do the underlying hashing and recursion for ctf_dedup_hash_type (which it
    calls, recursively).  */
 
@@ -582,7 +740,7 @@ ctf_dedup_rhash_type (ctf_dict_t *fp, ctf_dict_t *input, ctf_dict_t **inputs,
     {									\
       whaterr = N_("error updating citers");				\
       if (!citers)							\
-	if ((citers = ctf_dynset_create (htab_hash_string,		\
+	if ((citers = ctf_dynset_create (ctf_hash_type_hash_raw,	\
 					 htab_eq_string,		\
 					 NULL)) == NULL)		\
 	  goto oom;							\
@@ -935,36 +1093,8 @@ ctf_dedup_rhash_type (ctf_dict_t *fp, ctf_dict_t *input, ctf_dict_t **inputs,
      itself is known.  */
   whaterr = N_("error tracking citers");
 
-  if (citer)
-    {
-      ctf_dynset_t *citer_hashes;
-
-      if ((citer_hashes = make_set_element (d->cd_citers, citer)) == NULL)
-	goto oom;
-      if (ctf_dynset_cinsert (citer_hashes, hval) < 0)
-	goto oom;
-    }
-  else if (citers)
-    {
-      const void *k;
-
-      while ((err = ctf_dynset_cnext (citers, &i, &k)) == 0)
-	{
-	  ctf_dynset_t *citer_hashes;
-	  citer = (const char *) k;
-
-	  if ((citer_hashes = make_set_element (d->cd_citers, citer)) == NULL)
-	    goto oom;
-
-	  if (ctf_dynset_exists (citer_hashes, hval, NULL))
-	    continue;
-	  if (ctf_dynset_cinsert (citer_hashes, hval) < 0)
-	    goto oom;
-	}
-      if (err != ECTF_NEXT_END)
-	goto err;
-      ctf_dynset_destroy (citers);
-    }
+  if (ctf_dedup_add_citers (fp, citer, citers, hval) < 0)
+    goto oom;
 
   return hval;
 
@@ -986,6 +1116,64 @@ ctf_dedup_rhash_type (ctf_dict_t *fp, ctf_dict_t *input, ctf_dict_t **inputs,
   return NULL;
 }
 
+/* Look up the cached hash of the type with GID TYPE_ID in input INPUT_NUM: in
+   the cache for that input if inputs are being hashed in parallel.  */
+
+static const char *
+ctf_dedup_cached_hash (ctf_dict_t *fp, int input_num _libctf_unused_,
+		       void *type_id)
+{
+#ifdef CTF_DEDUP_THREADS
+  struct ctf_dedup_hashing *h = fp->ctf_dedup.cd_hashing;
+
+  if (h)
+    {
+      ctf_dedup_input_hashes_t *ih = &h->cdh_input_hashes[input_num];
+      ctf_dedup_hashed_t *hashed;
+
+      hashed = ctf_dynhash_lookup (ih->cdi_type_hashes, type_id);
+      return hashed ? hashed->cdt_hval : NULL;
+    }
+#endif
+  return ctf_dynhash_lookup (fp->ctf_dedup.cd_type_hashes, type_id);
+}
+
+/* Cache the HVAL of TYPE, with GID TYPE_ID and DECORATED name, in input
+   INPUT_NUM.  Returns -1 with errno set on error.  */
+
+static int
+ctf_dedup_cache_hash (ctf_dict_t *fp, int input_num _libctf_unused_,
+		      ctf_id_t type _libctf_unused_, void *type_id,
+		      const char *decorated _libctf_unused_, const char *hval)
+{
+#ifdef CTF_DEDUP_THREADS
+  struct ctf_dedup_hashing *h = fp->ctf_dedup.cd_hashing;
+
+  if (h)
+    {
+      ctf_dedup_input_hashes_t *ih = &h->cdh_input_hashes[input_num];
+      ctf_dedup_hashed_t *hashed;
+
+      if ((hashed = malloc (sizeof (ctf_dedup_hashed_t))) == NULL)
+	return -1;
+      memset (hashed, 0, sizeof (ctf_dedup_hashed_t));
+      hashed->cdt_type = type;
+      hashed->cdt_id = type_id;
+      hashed->cdt_decorated = decorated;
+      hashed->cdt_hval = hval;
+
+      if (ctf_dynhash_cinsert (ih->cdi_type_hashes, type_id, hashed) < 0)
+	{
+	  free (hashed);
+	  return -1;
+	}
+      ctf_list_append (&ih->cdi_hashed, hashed);
+      return 0;
+    }
+#endif
+  return ctf_dynhash_cinsert (fp->ctf_dedup.cd_type_hashes, type_id, hval);
+}
+
 /* Hash a TYPE in the INPUT: FP is the eventual output, where the ctf_dedup
    state is stored.  INPUT_NUM is the number of this input in the set of inputs.
    Record its hash in FP's cd_type_hashes once it is known.
@@ -1019,7 +1207,6 @@ ctf_dedup_hash_type (ctf_dict_t *fp, ctf_dict_t *input,
 					  const char *decorated_name,
 					  const char *hash))
 {
-  ctf_dedup_t *d = &fp->ctf_dedup;
   const ctf_type_t *tp;
   void *type_id;
   const char *hval = NULL;
@@ -1080,7 +1267,7 @@ ctf_dedup_hash_type (ctf_dict_t *fp, ctf_dict_t *input,
 
   if (!ctf_dedup_is_stub (name, kind, fwdkind, flags))
     {
-      if ((hval = ctf_dynhash_lookup (d->cd_type_hashes, type_id)) != NULL)
+      if ((hval = ctf_dedup_cached_hash (fp, input_num, type_id)) != NULL)
 	{
 #ifdef ENABLE_LIBCTF_HASH_DEBUGGING
 	  ctf_dprintf ("%lu: Known hash for ID %i/%lx: %s\n", depth, input_num,
@@ -1115,7 +1302,8 @@ ctf_dedup_hash_type (ctf_dict_t *fp, ctf_dict_t *input,
 		   type_id, name ? name : "", hval);
 #endif
 
-      if (ctf_dynhash_cinsert (d->cd_type_hashes, type_id, hval) < 0)
+      if (ctf_dedup_cache_hash (fp, input_num, type, type_id, decorated,
+				hval) < 0)
 	{
 	  whaterr = N_("error hash caching");
 	  goto oom;
@@ -1146,7 +1334,16 @@ ctf_dedup_hash_type (ctf_dict_t *fp, ctf_dict_t *input,
 }
 
 static int
-ctf_dedup_count_name (ctf_dict_t *fp, const char *name, void *id);
+ctf_dedup_count_name (ctf_dict_t *fp, const char *name, void *id, long n);
+
+/* The number of times a named type or enum was seen while hashing: see
+   cd_name_refs.  */
+
+typedef struct ctf_dedup_name_ref
+{
+  const char *decorated;
+  long count;
+} ctf_dedup_name_ref_t;
 
 /* Populate a number of useful mappings not directly used by the hashing
    machinery: the output mapping, the cd_name_counts mapping from name -> hash
@@ -1163,6 +1360,7 @@ ctf_dedup_populate_mappings (ctf_dict_t *fp, ctf_dict_t *input _libctf_unused_,
 {
   ctf_dedup_t *d = &fp->ctf_dedup;
   ctf_dynset_t *type_ids;
+  ctf_dedup_name_ref_t *ref;
 
 #ifdef ENABLE_LIBCTF_HASH_DEBUGGING
   ctf_dprintf ("Hash %s, %s, into output mapping for %i/%lx @ %s\n",
@@ -1255,35 +1453,88 @@ ctf_dedup_populate_mappings (ctf_dict_t *fp, ctf_dict_t *input _libctf_unused_,
       && ctf_dynset_insert (type_ids, id) < 0)
     return ctf_set_errno (fp, errno);
 
-  if (ctf_type_kind_unsliced (input, type) == CTF_K_ENUM)
+  /* The rest only needs to happen for types with names, and for enums, whose
+     enumerators are counted as names too.  Just note that the type has been
+     seen again: the names are counted by ctf_dedup_count_names once hashing
+     is done.  */
+  if (!decorated_name && ctf_type_kind_unsliced (input, type) != CTF_K_ENUM)
+    return 0;
+
+  if ((ref = ctf_dynhash_lookup (d->cd_name_refs, id)) == NULL)
     {
-      ctf_next_t *i = NULL;
-      const char *enumerator;
+      if ((ref = malloc (sizeof (ctf_dedup_name_ref_t))) == NULL)
+	return ctf_set_errno (fp, errno);
+      ref->decorated = decorated_name;
+      ref->count = 0;
+      if (ctf_dynhash_cinsert (d->cd_name_refs, id, ref) < 0)
+	{
+	  free (ref);
+	  return ctf_set_errno (fp, errno);
+	}
+    }
+  ref->count++;
+
+  return 0;
+}
+
+/* Populate the cd_name_counts from the cd_name_refs: count the decorated name
+   of every named type, and the enumerators of every enum, as many times as
+   the type was seen during hashing.  */
 
-      while ((enumerator = ctf_enum_next (input, type, &i, NULL)) != NULL)
+static int
+ctf_dedup_count_names (ctf_dict_t *fp, ctf_dict_t **inputs)
+{
+  ctf_dedup_t *d = &fp->ctf_dedup;
+  ctf_next_t *i = NULL;
+  void *id;
+  void *v;
+  int err;
+
+  while ((err = ctf_dynhash_next (d->cd_name_refs, &i, &id, &v)) == 0)
+    {
+      ctf_dedup_name_ref_t *ref = (ctf_dedup_name_ref_t *) v;
+      ctf_dict_t *input = inputs[CTF_DEDUP_GID_TO_INPUT (id)];
+      ctf_id_t type = CTF_DEDUP_GID_TO_TYPE (id);
+
+      if (ctf_type_kind_unsliced (input, type) == CTF_K_ENUM)
 	{
-	  if (ctf_dedup_count_name (fp, enumerator, id) < 0)
+	  ctf_next_t *j = NULL;
+	  const char *enumerator;
+
+	  while ((enumerator = ctf_enum_next (input, type, &j, NULL)) != NULL)
 	    {
-	      ctf_next_destroy (i);
-	      return -1;
+	      if (ctf_dedup_count_name (fp, enumerator, id, ref->count) < 0)
+		{
+		  ctf_next_destroy (j);
+		  goto err;
+		}
+	    }
+	  if (ctf_errno (input) != ECTF_NEXT_END)
+	    {
+	      ctf_set_errno (fp, ctf_errno (input));
+	      goto err;
 	    }
 	}
-      if (ctf_errno (input) != ECTF_NEXT_END)
-	return ctf_set_errno (fp, ctf_errno (input));
-    }
 
-  /* The rest only needs to happen for types with names.  */
-  if (!decorated_name)
-    return 0;
-
-  if (ctf_dedup_count_name (fp, decorated_name, id) < 0)
-    return -1;					/* errno is set for us. */
+      if (ref->decorated
+	  && ctf_dedup_count_name (fp, ref->decorated, id, ref->count) < 0)
+	goto err;
+    }
+  if (err != ECTF_NEXT_END)
+    {
+      ctf_err_warn (fp, 0, err, _("iteration failed counting type names"));
+      return ctf_set_errno (fp, err);
+    }
 
   return 0;
+
+ err:
+  ctf_next_destroy (i);
+  return -1;					/* errno is set for us.  */
 }
 
 static int
-ctf_dedup_count_name (ctf_dict_t *fp, const char *name, void *id)
+ctf_dedup_count_name (ctf_dict_t *fp, const char *name, void *id, long n)
 {
   ctf_dedup_t *d = &fp->ctf_dedup;
   ctf_dynhash_t *name_counts;
@@ -1297,7 +1548,7 @@ ctf_dedup_count_name (ctf_dict_t *fp, const char *name, void *id)
   /* Mapping from name -> hash(hashval, count) not already present?  */
   if ((name_counts = ctf_dynhash_lookup (d->cd_name_counts, name)) == NULL)
     {
-      if ((name_counts = ctf_dynhash_create (ctf_hash_string,
+      if ((name_counts = ctf_dynhash_create (ctf_hash_type_hash,
 					     ctf_hash_eq_string,
 					     NULL, NULL)) == NULL)
 	  return ctf_set_errno (fp, errno);
@@ -1312,7 +1563,7 @@ ctf_dedup_count_name (ctf_dict_t *fp, const char *name, void *id)
   count = (long int) (uintptr_t) ctf_dynhash_lookup (name_counts, hval);
 
   if (ctf_dynhash_cinsert (name_counts, hval,
-			   (const void *) (uintptr_t) (count + 1)) < 0)
+			   (const void *) (uintptr_t) (count + n)) < 0)
     return ctf_set_errno (fp, errno);
 
   return 0;
@@ -1648,6 +1899,12 @@ ctf_dedup_init (ctf_dict_t *fp)
 			     (ctf_hash_free_fun) ctf_dynhash_destroy)) == NULL)
     goto oom;
 
+  if ((d->cd_name_refs
+       = ctf_dynhash_create (ctf_hash_integer,
+			     ctf_hash_eq_integer,
+			     NULL, free)) == NULL)
+    goto oom;
+
   if ((d->cd_type_hashes
        = ctf_dynhash_create (ctf_hash_integer,
 			     ctf_hash_eq_integer,
@@ -1661,19 +1918,19 @@ ctf_dedup_init (ctf_dict_t *fp)
     goto oom;
 
   if ((d->cd_citers
-       = ctf_dynhash_create (ctf_hash_string,
+       = ctf_dynhash_create (ctf_hash_type_hash,
 			     ctf_hash_eq_string, NULL,
 			     (ctf_hash_free_fun) ctf_dynset_destroy)) == NULL)
     goto oom;
 
   if ((d->cd_output_mapping
-       = ctf_dynhash_create (ctf_hash_string,
+       = ctf_dynhash_create (ctf_hash_type_hash,
 			     ctf_hash_eq_string, NULL,
 			     (ctf_hash_free_fun) ctf_dynset_destroy)) == NULL)
     goto oom;
 
   if ((d->cd_output_first_gid
-       = ctf_dynhash_create (ctf_hash_string,
+       = ctf_dynhash_create (ctf_hash_type_hash,
 			     ctf_hash_eq_string,
 			     NULL, NULL)) == NULL)
     goto oom;
@@ -1698,7 +1955,7 @@ ctf_dedup_init (ctf_dict_t *fp)
     goto oom;
 
   if ((d->cd_conflicting_types
-       = ctf_dynset_create (htab_hash_string,
+       = ctf_dynset_create (ctf_hash_type_hash_raw,
 			    htab_eq_string, NULL)) == NULL)
     goto oom;
 
@@ -1725,6 +1982,7 @@ ctf_dedup_fini (ctf_dict_t *fp, ctf_dict_t **outputs, uint32_t noutputs)
   for (i = 0; i < 4; i++)
     ctf_dynhash_destroy (d->cd_decorated_names[i]);
   ctf_dynhash_destroy (d->cd_name_counts);
+  ctf_dynhash_destroy (d->cd_name_refs);
   ctf_dynhash_destroy (d->cd_type_hashes);
   ctf_dynhash_destroy (d->cd_struct_origin);
   ctf_dynhash_destroy (d->cd_citers);
@@ -1857,7 +2115,7 @@ ctf_dedup_conflictify_unshared (ctf_dict_t *output, ctf_dict_t **inputs)
   const void *k;
   ctf_dynset_t *to_mark = NULL;
 
-  if ((to_mark = ctf_dynset_create (htab_hash_string, htab_eq_string,
+  if ((to_mark = ctf_dynset_create (ctf_hash_type_hash_raw, htab_eq_string,
 				    NULL)) == NULL)
     goto err_no;
 
@@ -1906,6 +2164,268 @@ ctf_dedup_conflictify_unshared (ctf_dict_t *output, ctf_dict_t **inputs)
   return ctf_set_errno (output, err);
 }
 
+/* Hash all the types in input INPUT_NUM, calling POPULATE_FUN for each.  */
+
+static int
+ctf_dedup_hash_input (ctf_dict_t *output, ctf_dict_t **inputs,
+		      uint32_t input_num,
+		      int (*populate_fun) (ctf_dict_t *fp,
+					   ctf_dict_t *input,
+					   ctf_dict_t **inputs,
+					   int input_num,
+					   ctf_id_t type,
+					   void *id,
+					   const char *decorated_name,
+					   const char *hash))
+{
+  ctf_dict_t *input = inputs[input_num];
+  ctf_next_t *it = NULL;
+  ctf_id_t id;
+
+  while ((id = ctf_type_next (input, &it, NULL, 1)) != CTF_ERR)
+    {
+      if (ctf_dedup_hash_type (output, input, inputs, input_num, id, 0, 0,
+			       populate_fun) == NULL)
+	{
+	  ctf_next_destroy (it);
+	  return -1;				/* errno is set for us.  */
+	}
+    }
+  if (ctf_errno (input) != ECTF_NEXT_END)
+    {
+      ctf_set_errno (output, ctf_errno (input));
+      ctf_err_warn (output, 0, 0, _("iteration failure "
+				    "computing type hashes"));
+      return -1;
+    }
+  return 0;
+}
+
+#ifdef CTF_DEDUP_THREADS
+
+/* The populate_fun used while hashing inputs in parallel: just count another
+   use of the hash of this type, which has already been cached.  The output
+   mapping is populated later, by ctf_dedup_hash_inputs.  */
+
+static int
+ctf_dedup_count_hashed (ctf_dict_t *fp, ctf_dict_t *input _libctf_unused_,
+			ctf_dict_t **inputs _libctf_unused_, int input_num,
+			ctf_id_t type _libctf_unused_, void *id,
+			const char *decorated_name _libctf_unused_,
+			const char *hval _libctf_unused_)
+{
+  ctf_dedup_input_hashes_t *ih;
+  ctf_dedup_hashed_t *hashed;
+
+  ih = &fp->ctf_dedup.cd_hashing->cdh_input_hashes[input_num];
+  hashed = ctf_dynhash_lookup (ih->cdi_type_hashes, id);
+  if (!ctf_assert (fp, hashed))
+    return -1;
+  hashed->cdt_count++;
+  return 0;
+}
+
+/* Hash inputs in one thread, until there are none left or hashing of some
+   input has failed.
+
+   Several threads can look at the same parent dict at once (when hashing its
+   children): only reading it, but type iterators may set its errno to
+   ECTF_NEXT_END concurrently, which is harmless.  */
+
+static void *
+ctf_dedup_hash_input_worker (void *arg)
+{
+  struct ctf_dedup_hashing *h = (struct ctf_dedup_hashing *) arg;
+
+  for (;;)
+    {
+      uint32_t input_num;
+
+      pthread_mutex_lock (&h->cdh_lock);
+      input_num = h->cdh_next_input++;
+      if (h->cdh_err != 0)
+	input_num = h->cdh_ninputs;
+      pthread_mutex_unlock (&h->cdh_lock);
+
+      if (input_num >= h->cdh_ninputs)
+	break;
+
+      if (ctf_dedup_hash_input (h->cdh_output, h->cdh_inputs, input_num,
+				ctf_dedup_count_hashed) < 0)
+	{
+	  pthread_mutex_lock (&h->cdh_lock);
+	  if (h->cdh_err == 0)
+	    h->cdh_err = ctf_errno (h->cdh_output) != 0
+	      ? ctf_errno (h->cdh_output) : ECTF_INTERNAL;
+	  pthread_mutex_unlock (&h->cdh_lock);
+	}
+    }
+  return NULL;
+}
+
+/* The number of threads to hash NINPUTS inputs with: one per processor, or as
+   many as the LIBCTF_DEDUP_THREADS environment variable says.  */
+
+static long
+ctf_dedup_hash_threads (uint32_t ninputs)
+{
+  const char *env = getenv ("LIBCTF_DEDUP_THREADS");
+  long nthreads = 1;
+
+  if (env != NULL)
+    nthreads = strtol (env, NULL, 10);
+#ifdef _SC_NPROCESSORS_ONLN
+  else
+    nthreads = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+
+  if (nthreads > (long) ninputs)
+    nthreads = ninputs;
+  return nthreads;
+}
+
+/* Hash the NINPUTS INPUTS using NTHREADS threads, then populate the output
+   mapping from the hashes they recorded, in input order.  */
+
+static int
+ctf_dedup_hash_inputs_threaded (ctf_dict_t *output, ctf_dict_t **inputs,
+				uint32_t ninputs, long nthreads)
+{
+  ctf_dedup_t *d = &output->ctf_dedup;
+  struct ctf_dedup_hashing h;
+  pthread_t *threads;
+  long nstarted = 0;
+  uint32_t i;
+  long j;
+  int err = 0;
+
+  memset (&h, 0, sizeof (struct ctf_dedup_hashing));
+  h.cdh_output = output;
+  h.cdh_inputs = inputs;
+  h.cdh_ninputs = ninputs;
+
+  if ((threads = calloc (nthreads, sizeof (pthread_t))) == NULL
+      || (h.cdh_input_hashes = calloc (ninputs,
+				       sizeof (ctf_dedup_input_hashes_t))) == NULL)
+    {
+      free (threads);
+      goto oom;
+    }
+
+  for (i = 0; i < ninputs; i++)
+    {
+      if ((h.cdh_input_hashes[i].cdi_type_hashes
+	   = ctf_dynhash_create (ctf_hash_integer, ctf_hash_eq_integer,
+				 NULL, free)) == NULL)
+	{
+	  free (threads);
+	  goto oom;
+	}
+    }
+
+  if ((err = pthread_mutex_init (&h.cdh_lock, NULL)) != 0)
+    {
+      free (threads);
+      ctf_set_errno (output, err);
+      goto err;
+    }
+  d->cd_hashing = &h;
+
+  /* If threads cannot be started, the ones that were (or just this one) hash
+     all the inputs anyway.  */
+  for (j = 1; j < nthreads; j++)
+    {
+      if (pthread_create (&threads[nstarted], NULL,
+			  ctf_dedup_hash_input_worker, &h) != 0)
+	break;
+      nstarted++;
+    }
+  ctf_dedup_hash_input_worker (&h);
+  for (j = 0; j < nstarted; j++)
+    pthread_join (threads[j], NULL);
+  free (threads);
+
+  d->cd_hashing = NULL;
+  pthread_mutex_destroy (&h.cdh_lock);
+
+  if (h.cdh_err != 0)
+    {
+      ctf_set_errno (output, h.cdh_err);
+      goto err;
+    }
+
+  /* Populate the type hashes and output mapping just as hashing the inputs one
+     by one would have done: in input order, and in the order each input first
+     populated each type.  Populating a type more than once only bumps the count
+     of its name, if it has one.  */
+
+  for (i = 0; i < ninputs; i++)
+    {
+      ctf_dedup_hashed_t *hashed;
+
+      for (hashed = ctf_list_next (&h.cdh_input_hashes[i].cdi_hashed);
+	   hashed != NULL; hashed = ctf_list_next (hashed))
+	{
+	  ctf_dedup_name_ref_t *ref;
+
+	  if (ctf_dynhash_cinsert (d->cd_type_hashes, hashed->cdt_id,
+				   hashed->cdt_hval) < 0)
+	    goto oom;
+
+	  if (ctf_dedup_populate_mappings (output, inputs[i], inputs, i,
+					   hashed->cdt_type, hashed->cdt_id,
+					   hashed->cdt_decorated,
+					   hashed->cdt_hval) < 0)
+	    goto err;				/* errno is set for us.  */
+
+	  if (hashed->cdt_count > 1
+	      && (ref = ctf_dynhash_lookup (d->cd_name_refs,
+					    hashed->cdt_id)) != NULL)
+	    ref->count += hashed->cdt_count - 1;
+	}
+    }
+
+  for (i = 0; i < ninputs; i++)
+    ctf_dynhash_destroy (h.cdh_input_hashes[i].cdi_type_hashes);
+  free (h.cdh_input_hashes);
+  return 0;
+
+ oom:
+  ctf_set_errno (output, ENOMEM);
+  ctf_err_warn (output, 0, 0, _("out of memory hashing inputs"));
+ err:
+  if (h.cdh_input_hashes)
+    for (i = 0; i < ninputs; i++)
+      ctf_dynhash_destroy (h.cdh_input_hashes[i].cdi_type_hashes);
+  free (h.cdh_input_hashes);
+  return -1;
+}
+#endif
+
+/* Compute hash values for all types in all NINPUTS INPUTS, populating the
+   output mapping as we go: in parallel, if possible.  */
+
+static int
+ctf_dedup_hash_inputs (ctf_dict_t *output, ctf_dict_t **inputs,
+		       uint32_t ninputs)
+{
+  uint32_t i;
+
+#ifdef CTF_DEDUP_THREADS
+  long nthreads = ctf_dedup_hash_threads (ninputs);
+
+  if (nthreads > 1)
+    return ctf_dedup_hash_inputs_threaded (output, inputs, ninputs, nthreads);
+#endif
+
+  for (i = 0; i < ninputs; i++)
+    if (ctf_dedup_hash_input (output, inputs, i,
+			      ctf_dedup_populate_mappings) < 0)
+      return -1;				/* errno is set for us.  */
+
+  return 0;
+}
+
 /* The core deduplicator.  Populate cd_output_mapping in the output ctf_dedup with a
    mapping of all types that belong in this dictionary and where they come from, and
    cd_conflicting_types with an indication of whether each type is conflicted or not.
@@ -1924,7 +2444,6 @@ ctf_dedup (ctf_dict_t *output, ctf_dict_t **inputs, uint32_t ninputs,
 {
   ctf_dedup_t *d = &output->ctf_dedup;
   size_t i;
-  ctf_next_t *it = NULL;
 
   if (ctf_dedup_init (output) < 0)
     return -1; 					/* errno is set for us.  */
@@ -1959,25 +2478,12 @@ ctf_dedup (ctf_dict_t *output, ctf_dict_t **inputs, uint32_t ninputs,
      IDs in cd_output_mapping.  */
 
   ctf_dprintf ("Computing type hashes\n");
-  for (i = 0; i < ninputs; i++)
-    {
-      ctf_id_t id;
+  if (ctf_dedup_hash_inputs (output, inputs, ninputs) < 0)
+    goto err;					/* errno is set for us.  */
 
-      while ((id = ctf_type_next (inputs[i], &it, NULL, 1)) != CTF_ERR)
-	{
-	  if (ctf_dedup_hash_type (output, inputs[i], inputs,
-				   i, id, 0, 0,
-				   ctf_dedup_populate_mappings) == NULL)
-	    goto err;				/* errno is set for us.  */
-	}
-      if (ctf_errno (inputs[i]) != ECTF_NEXT_END)
-	{
-	  ctf_set_errno (output, ctf_errno (inputs[i]));
-	  ctf_err_warn (output, 0, 0, _("iteration failure "
-					"computing type hashes"));
-	  goto err;
-	}
-    }
+  ctf_dprintf ("Counting type names\n");
+  if (ctf_dedup_count_names (output, inputs) < 0)
+    goto err;					/* errno is set for us.  */
 
   /* Go through the cd_name_counts name->hash->count mapping for all CTF
      namespaces: any name with many hashes associated with it at this stage is
@@ -2395,7 +2901,7 @@ ctf_dedup_walk_output_mapping (ctf_dict_t *output, ctf_dict_t **inputs,
   int err;
   void *k;
 
-  if ((already_visited = ctf_dynset_create (htab_hash_string,
+  if ((already_visited = ctf_dynset_create (ctf_hash_type_hash_raw,
 					    htab_eq_string,
 					    NULL)) == NULL)
     return ctf_set_errno (output, ENOMEM);
@@ -2727,7 +3233,7 @@ ctf_dedup_emit_type (const char *hval, ctf_dict_t *output, ctf_dict_t **inputs,
 
   if (!target->ctf_dedup.cd_output_emission_hashes)
     if ((target->ctf_dedup.cd_output_emission_hashes
-	 = ctf_dynhash_create (ctf_hash_string, ctf_hash_eq_string,
+	 = ctf_dynhash_create (ctf_hash_type_hash, ctf_hash_eq_string,
 			      NULL, NULL)) == NULL)
       goto oom_hash;
 
@@ -82,6 +82,32 @@ ctf_hash_string (const void *ptr)
   return htab_hash_string (hep->key);
 }
 
+/* Hash a type hash value computed by the deduplicator.  These are hex SHA-1
+   digests, so their first few characters are as well distributed as the whole
+   string: hashing only those saves a lot of time in the deduplicator, which
+   looks these up millions of times.  */
+
+hashval_t
+ctf_hash_type_hash_raw (const void *ptr)
+{
+  const unsigned char *str = (const unsigned char *) ptr;
+  hashval_t r = 0;
+  size_t i;
+
+  for (i = 0; i < 8 && str[i] != '\0'; i++)
+    r = r * 67 + str[i] - 113;
+
+  return r;
+}
+
+unsigned int
+ctf_hash_type_hash (const void *ptr)
+{
+  ctf_helem_t *hep = (ctf_helem_t *) ptr;
+
+  return ctf_hash_type_hash_raw (hep->key);
+}
+
 int
 ctf_hash_eq_string (const void *a, const void *b)
 {
@@ -298,6 +298,13 @@ typedef struct ctf_dedup
      in.  */
   ctf_dynhash_t *cd_name_counts;
 
+  /* Map global type IDs of named types and enums to a ctf_dedup_name_ref_t
+     counting the times the hashing phase has seen them.  The cd_name_counts
+     are computed from this once all types are hashed, so that the names of
+     types cited many times (and the enumerators of big enums) are counted
+     once per type rather than once per citation.  */
+  ctf_dynhash_t *cd_name_refs;
+
   /* Map global type IDs to type hash values.  Used to determine if types are
      already hashed without having to recompute their hash values again, and to
      link types together at later stages.  Forwards that are peeked through to
@@ -347,6 +354,10 @@ typedef struct ctf_dedup
      not take an inputs array.  */
   ctf_dynhash_t *cd_input_nums;
 
+  /* The state shared between threads hashing inputs in parallel, while they
+     run: see ctf_dedup_hash_inputs.  NULL otherwise.  */
+  struct ctf_dedup_hashing *cd_hashing;
+
   /* Maps type hashes to ctf_id_t's in this dictionary.  Populated only at
      emission time, in the dictionary where emission is taking place.  */
   ctf_dynhash_t *cd_output_emission_hashes;
@@ -604,6 +615,8 @@ struct ctf_next
 #define LCTF_CHILD	0x0001	/* CTF dict is a child.  */
 #define LCTF_LINKING	0x0002	/* CTF link is underway: respect ctf_link_flags.  */
 #define LCTF_STRICT_NO_DUP_ENUMERATORS 0x0004 /* Duplicate enums prohibited.  */
+#define LCTF_NAMES_UNHASHED 0x0008 /* Static type names not yet hashed.  */
+#define LCTF_STRS_UNATOMIZED 0x0010 /* Static strings not yet atoms.  */
 
 extern ctf_dynhash_t *ctf_name_table (ctf_dict_t *, int);
 extern const ctf_type_t *ctf_lookup_by_id (ctf_dict_t **, ctf_id_t);
@@ -613,6 +626,7 @@ extern ctf_id_t ctf_lookup_by_sym_or_name (ctf_dict_t *, unsigned long symidx,
 					   int is_function);
 extern ctf_id_t ctf_lookup_by_rawname (ctf_dict_t *, int, const char *);
 extern void ctf_set_ctl_hashes (ctf_dict_t *);
+extern int ctf_hash_static_names (ctf_dict_t *);
 extern ctf_id_t ctf_symbol_next_static (ctf_dict_t *, ctf_next_t **,
 					const char **, int);
 
@@ -625,6 +639,8 @@ extern ctf_dict_t *ctf_get_dict (ctf_dict_t *fp, ctf_id_t type);
 typedef unsigned int (*ctf_hash_fun) (const void *ptr);
 extern unsigned int ctf_hash_integer (const void *ptr);
 extern unsigned int ctf_hash_string (const void *ptr);
+extern unsigned int ctf_hash_type_hash (const void *ptr);
+extern hashval_t ctf_hash_type_hash_raw (const void *ptr);
 extern unsigned int ctf_hash_type_key (const void *ptr);
 extern unsigned int ctf_hash_type_id_key (const void *ptr);
 
@@ -244,6 +244,9 @@ ctf_lookup_by_name_internal (ctf_dict_t *fp, ctf_dict_t *child,
       if (isqualifier (p, (size_t) (q - p)))
 	continue;		/* Skip qualifier keyword.  */
 
+      if (ctf_hash_static_names (fp) < 0)
+	return CTF_ERR;			/* errno is set for us.  */
+
       for (lp = fp->ctf_lookups; lp->ctl_prefix != NULL; lp++)
 	{
 	  /* TODO: This is not MT-safe.  */
@@ -426,6 +429,9 @@ ctf_lookup_enumerator (ctf_dict_t *fp, const char *name, int64_t *enum_value)
   ctf_id_t type;
   int enum_int_value;
 
+  if (ctf_hash_static_names (fp) < 0)
+    return CTF_ERR;				/* errno is set for us.  */
+
   if (ctf_dynset_lookup (fp->ctf_conflicting_enums, name))
     return (ctf_set_typed_errno (fp, ECTF_DUPLICATE));
 
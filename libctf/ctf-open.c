@@ -670,59 +670,37 @@ upgrade_types (ctf_dict_t *fp, ctf_header_t *cth)
   return 0;
 }
 
-static int
-init_static_types_internal (ctf_dict_t *fp, ctf_header_t *cth,
-			    ctf_dynset_t *all_enums);
+static int init_static_names (ctf_dict_t *fp);
 
 /* Populate statically-defined types (those loaded from a saved buffer).
 
    Initialize the type ID translation table with the byte offset of each type,
-   and initialize the hash tables of each named type.  Upgrade the type table to
-   the latest supported representation in the process, if needed, and if this
-   recension of libctf supports upgrading.
+   and the pointer table.  Upgrade the type table to the latest supported
+   representation in the process, if needed, and if this recension of libctf
+   supports upgrading.
 
-   Returns zero on success and a *positive* ECTF_* or errno value on error.
+   The hash tables of named types are not populated here: this is deferred to
+   the first operation that needs them (see ctf_hash_static_names), so that
+   opening a large dict (or a whole archive of them) just to look at a few
+   types by ID is cheap.
 
-   This is a wrapper to simplify memory allocation on error in the _internal
-   function that does all the actual work.  */
+   Returns zero on success and a *positive* ECTF_* or errno value on error.  */
 
 static int
 init_static_types (ctf_dict_t *fp, ctf_header_t *cth)
-{
-  ctf_dynset_t *all_enums;
-  int err;
-
-  if ((all_enums = ctf_dynset_create (htab_hash_pointer, htab_eq_pointer,
-				      NULL)) == NULL)
-    return ENOMEM;
-
-  err = init_static_types_internal (fp, cth, all_enums);
-  ctf_dynset_destroy (all_enums);
-  return err;
-}
-
-static int
-init_static_types_internal (ctf_dict_t *fp, ctf_header_t *cth,
-			    ctf_dynset_t *all_enums)
 {
   const ctf_type_t *tbuf;
   const ctf_type_t *tend;
 
-  unsigned long pop[CTF_K_MAX + 1] = { 0 };
-  int pop_enumerators = 0;
   const ctf_type_t *tp;
   uint32_t id;
   uint32_t *xp;
   unsigned long typemax = 0;
-  ctf_next_t *i = NULL;
-  void *k;
 
   /* We determine whether the dict is a child or a parent based on the value of
      cth_parname.  */
 
   int child = cth->cth_parname != 0;
-  int nlstructs = 0, nlunions = 0;
-  int err;
 
   if (_libctf_unlikely_ (fp->ctf_version == CTF_VERSION_1))
     {
@@ -734,9 +712,8 @@ init_static_types_internal (ctf_dict_t *fp, ctf_header_t *cth,
   tbuf = (ctf_type_t *) (fp->ctf_buf + cth->cth_typeoff);
   tend = (ctf_type_t *) (fp->ctf_buf + cth->cth_stroff);
 
-  /* We make two passes through the entire type section, and one third pass
-     through part of it.  In this first pass, we count the number of each type
-     and type-like identifier (like enumerators) and the total number of
+  /* We make two passes through the entire type section.  In this first pass,
+     we validate the size of every type and count the total number of
      types.  */
 
   for (tp = tbuf; tp < tend; typemax++)
@@ -751,16 +728,7 @@ init_static_types_internal (ctf_dict_t *fp, ctf_header_t *cth,
       if (vbytes < 0)
 	return ECTF_CORRUPT;
 
-      /* For forward declarations, ctt_type is the CTF_K_* kind for the tag,
-	 so bump that population count too.  */
-      if (kind == CTF_K_FORWARD)
-	pop[tp->ctt_type]++;
-
       tp = (ctf_type_t *) ((uintptr_t) tp + increment + vbytes);
-      pop[kind]++;
-
-      if (kind == CTF_K_ENUM)
-	pop_enumerators += vlen;
     }
 
   if (child)
@@ -771,8 +739,175 @@ init_static_types_internal (ctf_dict_t *fp, ctf_header_t *cth,
   else
     ctf_dprintf ("CTF dict %p is a parent\n", (void *) fp);
 
+  /* The ptrtab and txlate can be appropriately sized for precisely this set
+     of types: the txlate because it is only used to look up static types,
+     so dynamic types added later will never go through it, and the ptrtab
+     because later-added types will call grow_ptrtab() automatically, as
+     needed.  */
+
+  fp->ctf_txlate = malloc (sizeof (uint32_t) * (typemax + 1));
+  fp->ctf_ptrtab_len = typemax + 1;
+  fp->ctf_ptrtab = malloc (sizeof (uint32_t) * fp->ctf_ptrtab_len);
+  fp->ctf_stypes = typemax;
+
+  if (fp->ctf_txlate == NULL || fp->ctf_ptrtab == NULL)
+    return ENOMEM;		/* Memory allocation failed.  */
+
+  xp = fp->ctf_txlate;
+  *xp++ = 0;			/* Type id 0 is used as a sentinel value.  */
+
+  memset (fp->ctf_txlate, 0, sizeof (uint32_t) * (typemax + 1));
+  memset (fp->ctf_ptrtab, 0, sizeof (uint32_t) * (typemax + 1));
+
+  /* In the second pass through the types, we fill in each entry of the
+     type and pointer tables.
+
+     Bump ctf_typemax as we go, but keep it one higher than normal, so that
+     only pointers to types earlier in the dict (or to the pointer itself)
+     are entered in the pointer table.  */
+
+  for (id = 1, fp->ctf_typemax = 1, tp = tbuf; tp < tend;
+       xp++, id++, fp->ctf_typemax++)
+    {
+      unsigned short kind = LCTF_INFO_KIND (fp, tp->ctt_info);
+      unsigned long vlen = LCTF_INFO_VLEN (fp, tp->ctt_info);
+      ssize_t size, increment, vbytes;
+
+      (void) ctf_get_ctt_size (fp, tp, &size, &increment);
+      /* Cannot fail: shielded by call in loop above.  */
+      vbytes = LCTF_VBYTES (fp, kind, size, vlen);
+
+      *xp = (uint32_t) ((uintptr_t) tp - (uintptr_t) fp->ctf_buf);
+
+      switch (kind)
+	{
+	case CTF_K_UNKNOWN:
+	case CTF_K_INTEGER:
+	case CTF_K_FLOAT:
+	case CTF_K_ARRAY:
+	case CTF_K_SLICE:
+	case CTF_K_FUNCTION:
+	case CTF_K_STRUCT:
+	case CTF_K_UNION:
+	case CTF_K_ENUM:
+	case CTF_K_TYPEDEF:
+	case CTF_K_FORWARD:
+	case CTF_K_VOLATILE:
+	case CTF_K_CONST:
+	case CTF_K_RESTRICT:
+	  break;
+
+	case CTF_K_POINTER:
+	  /* If the type referenced by the pointer is in this CTF dict, then
+	     store the index of the pointer type in fp->ctf_ptrtab[ index of
+	     referenced type ].  */
+
+	  if (LCTF_TYPE_ISCHILD (fp, tp->ctt_type) == child
+	      && LCTF_TYPE_TO_INDEX (fp, tp->ctt_type) <= fp->ctf_typemax)
+	    fp->ctf_ptrtab[LCTF_TYPE_TO_INDEX (fp, tp->ctt_type)] = id;
+	  break;
+
+	default:
+	  ctf_err_warn (fp, 0, ECTF_CORRUPT,
+			_("init_static_types(): unhandled CTF kind: %x"), kind);
+	  return ECTF_CORRUPT;
+	}
+      tp = (ctf_type_t *) ((uintptr_t) tp + increment + vbytes);
+    }
+  fp->ctf_typemax--;
+  assert (fp->ctf_typemax == typemax);
+
+  ctf_dprintf ("%lu total types processed\n", fp->ctf_typemax);
+
+  /* Nothing is saved by deferring the name hashing of an empty dict, such as
+     one created by ctf_create().  */
+
+  if (typemax == 0)
+    return init_static_names (fp);
+
+  fp->ctf_flags |= LCTF_NAMES_UNHASHED;
+  return 0;
+}
+
+static int
+init_static_names_internal (ctf_dict_t *fp, ctf_dynset_t *all_enums);
+
+/* Initialize the hash tables of each named static type, and track all the
+   enumeration constants.
+
+   Returns zero on success and a *positive* ECTF_* or errno value on error, in
+   which case all the name tables are freed again.
+
+   This is a wrapper to simplify memory allocation on error in the _internal
+   function that does all the actual work.  */
+
+static int
+init_static_names (ctf_dict_t *fp)
+{
+  ctf_dynset_t *all_enums;
+  int err;
+
+  if ((all_enums = ctf_dynset_create (htab_hash_pointer, htab_eq_pointer,
+				      NULL)) == NULL)
+    return ENOMEM;
+
+  err = init_static_names_internal (fp, all_enums);
+  ctf_dynset_destroy (all_enums);
+
+  if (err != 0)
+    {
+      ctf_dynset_destroy (fp->ctf_conflicting_enums);
+      ctf_dynhash_destroy (fp->ctf_structs);
+      ctf_dynhash_destroy (fp->ctf_unions);
+      ctf_dynhash_destroy (fp->ctf_enums);
+      ctf_dynhash_destroy (fp->ctf_names);
+      fp->ctf_conflicting_enums = NULL;
+      fp->ctf_structs = NULL;
+      fp->ctf_unions = NULL;
+      fp->ctf_enums = NULL;
+      fp->ctf_names = NULL;
+    }
+  return err;
+}
+
+static int
+init_static_names_internal (ctf_dict_t *fp, ctf_dynset_t *all_enums)
+{
+  unsigned long pop[CTF_K_MAX + 1] = { 0 };
+  int pop_enumerators = 0;
+  const ctf_type_t *tp;
+  uint32_t id;
+  ctf_next_t *i = NULL;
+  void *k;
+
+  int child = (fp->ctf_flags & LCTF_CHILD) != 0;
+  int nlstructs = 0, nlunions = 0;
+  int err;
+
+  /* We make two passes through all the static types, and one third pass
+     through part of them.  In this first pass, we count the number of each
+     type and type-like identifier (like enumerators).  */
+
+  for (id = 1; id <= fp->ctf_stypes; id++)
+    {
+      unsigned short kind;
+
+      tp = (ctf_type_t *) (fp->ctf_buf + fp->ctf_txlate[id]);
+      kind = LCTF_INFO_KIND (fp, tp->ctt_info);
+
+      /* For forward declarations, ctt_type is the CTF_K_* kind for the tag,
+	 so bump that population count too.  */
+      if (kind == CTF_K_FORWARD)
+	pop[tp->ctt_type]++;
+
+      pop[kind]++;
+
+      if (kind == CTF_K_ENUM)
+	pop_enumerators += LCTF_INFO_VLEN (fp, tp->ctt_info);
+    }
+
   /* Now that we've counted up the number of each type, we can allocate
-     the hash tables, type translation table, and pointer table.  */
+     the hash tables.  */
 
   if ((fp->ctf_structs
        = ctf_dynhash_create_sized (pop[CTF_K_STRUCT], ctf_hash_string,
@@ -808,50 +943,23 @@ init_static_types_internal (ctf_dict_t *fp, ctf_header_t *cth,
        = ctf_dynset_create (htab_hash_string, htab_eq_string, NULL)) == NULL)
     return ENOMEM;
 
-  /* The ptrtab and txlate can be appropriately sized for precisely this set
-     of types: the txlate because it is only used to look up static types,
-     so dynamic types added later will never go through it, and the ptrtab
-     because later-added types will call grow_ptrtab() automatically, as
-     needed.  */
-
-  fp->ctf_txlate = malloc (sizeof (uint32_t) * (typemax + 1));
-  fp->ctf_ptrtab_len = typemax + 1;
-  fp->ctf_ptrtab = malloc (sizeof (uint32_t) * fp->ctf_ptrtab_len);
-  fp->ctf_stypes = typemax;
-
-  if (fp->ctf_txlate == NULL || fp->ctf_ptrtab == NULL)
-    return ENOMEM;		/* Memory allocation failed.  */
-
-  xp = fp->ctf_txlate;
-  *xp++ = 0;			/* Type id 0 is used as a sentinel value.  */
-
-  memset (fp->ctf_txlate, 0, sizeof (uint32_t) * (typemax + 1));
-  memset (fp->ctf_ptrtab, 0, sizeof (uint32_t) * (typemax + 1));
-
-  /* In the second pass through the types, we fill in each entry of the
-     type and pointer tables and add names to the appropriate hashes.
-
-     (Not all names are added in this pass, only type names.  See below.)
+  /* In the second pass through the types, we add names to the appropriate
+     hashes.
 
-     Bump ctf_typemax as we go, but keep it one higher than normal, so that
-     the type being read in is considered a valid type and it is at least
-     barely possible to run simple lookups on it.  */
+     (Not all names are added in this pass, only type names.  See below.)  */
 
-  for (id = 1, fp->ctf_typemax = 1, tp = tbuf; tp < tend; xp++, id++, fp->ctf_typemax++)
+  for (id = 1; id <= fp->ctf_stypes; id++)
     {
-      unsigned short kind = LCTF_INFO_KIND (fp, tp->ctt_info);
-      unsigned short isroot = LCTF_INFO_ISROOT (fp, tp->ctt_info);
-      unsigned long vlen = LCTF_INFO_VLEN (fp, tp->ctt_info);
-      ssize_t size, increment, vbytes;
-
+      unsigned short kind, isroot;
+      ssize_t size, increment;
       const char *name;
 
+      tp = (ctf_type_t *) (fp->ctf_buf + fp->ctf_txlate[id]);
+      kind = LCTF_INFO_KIND (fp, tp->ctt_info);
+      isroot = LCTF_INFO_ISROOT (fp, tp->ctt_info);
+
       (void) ctf_get_ctt_size (fp, tp, &size, &increment);
       name = ctf_strptr (fp, tp->ctt_name);
-      /* Cannot fail: shielded by call in loop above.  */
-      vbytes = LCTF_VBYTES (fp, kind, size, vlen);
-
-      *xp = (uint32_t) ((uintptr_t) tp - (uintptr_t) fp->ctf_buf);
 
       switch (kind)
 	{
@@ -993,15 +1101,6 @@ init_static_types_internal (ctf_dict_t *fp, ctf_header_t *cth,
 	  }
 
 	case CTF_K_POINTER:
-	  /* If the type referenced by the pointer is in this CTF dict, then
-	     store the index of the pointer type in fp->ctf_ptrtab[ index of
-	     referenced type ].  */
-
-	  if (LCTF_TYPE_ISCHILD (fp, tp->ctt_type) == child
-	      && LCTF_TYPE_TO_INDEX (fp, tp->ctt_type) <= fp->ctf_typemax)
-	    fp->ctf_ptrtab[LCTF_TYPE_TO_INDEX (fp, tp->ctt_type)] = id;
-	 /*FALLTHRU*/
-
 	case CTF_K_VOLATILE:
 	case CTF_K_CONST:
 	case CTF_K_RESTRICT:
@@ -1015,16 +1114,9 @@ init_static_types_internal (ctf_dict_t *fp, ctf_header_t *cth,
 	    return err * -1;
 	  break;
 	default:
-	  ctf_err_warn (fp, 0, ECTF_CORRUPT,
-			_("init_static_types(): unhandled CTF kind: %x"), kind);
-	  return ECTF_CORRUPT;
+	  break;
 	}
-      tp = (ctf_type_t *) ((uintptr_t) tp + increment + vbytes);
     }
-  fp->ctf_typemax--;
-  assert (fp->ctf_typemax == typemax);
-
-  ctf_dprintf ("%lu total types processed\n", fp->ctf_typemax);
 
   /* In the third pass, we traverse the enums we spotted earlier and track all
      the enumeration constants to aid in future detection of duplicates.
@@ -1071,6 +1163,29 @@ init_static_types_internal (ctf_dict_t *fp, ctf_header_t *cth,
   return 0;
 }
 
+/* Hash the names of the static types in FP, if this has not been done yet.
+   Everything that looks up types by name, or adds new types, calls this first.
+
+   Returns -1 and sets the errno on FP on error.  */
+
+int
+ctf_hash_static_names (ctf_dict_t *fp)
+{
+  int old_errno = fp->ctf_errno;
+  int err;
+
+  if (!(fp->ctf_flags & LCTF_NAMES_UNHASHED))
+    return 0;
+
+  if ((err = init_static_names (fp)) != 0)
+    return (ctf_set_errno (fp, err));
+
+  fp->ctf_flags &= ~LCTF_NAMES_UNHASHED;
+  fp->ctf_errno = old_errno;
+  ctf_set_ctl_hashes (fp);
+  return 0;
+}
+
 /* Endianness-flipping routines.
 
    We flip everything, mindlessly, even 1-byte entities, so that future
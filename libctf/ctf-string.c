@@ -145,7 +145,8 @@ ctf_str_free_atom (void *a)
 }
 
 /* Create the atoms table.  There is always at least one atom in it, the null
-   string: but also pull in atoms from the internal strtab.  (We rely on
+   string: atoms from the internal strtab are pulled in later, by
+   ctf_str_populate_atoms, the first time a string is added.  (We rely on
    calls to ctf_str_add_external to populate external strtab entries, since
    these are often not quite the same as what appears in any external
    strtab, and the external strtab is often huge and best not aggressively
@@ -153,8 +154,6 @@ ctf_str_free_atom (void *a)
 int
 ctf_str_create_atoms (ctf_dict_t *fp)
 {
-  size_t i;
-
   fp->ctf_str_atoms = ctf_dynhash_create (ctf_hash_string, ctf_hash_eq_string,
 					  NULL, ctf_str_free_atom);
   if (!fp->ctf_str_atoms)
@@ -178,10 +177,46 @@ ctf_str_create_atoms (ctf_dict_t *fp)
   if (errno == ENOMEM)
     goto oom_str_add;
 
-  /* Pull in all the strings in the strtab as new atoms.  The provisional
-     strtab must be empty at this point, so there is no need to populate
-     atoms from it as well.  Types in this subset are frozen and readonly,
-     so the refs list and movable refs list need not be populated.  */
+  fp->ctf_str_prov_offset = fp->ctf_str[CTF_STRTAB_0].cts_len + 1;
+
+  if (fp->ctf_str[CTF_STRTAB_0].cts_len > 1)
+    fp->ctf_flags |= LCTF_STRS_UNATOMIZED;
+
+  return 0;
+
+ oom_str_add:
+  ctf_dynhash_destroy (fp->ctf_str_movable_refs);
+  fp->ctf_str_movable_refs = NULL;
+ oom_movable_refs:
+  ctf_dynhash_destroy (fp->ctf_prov_strtab);
+  fp->ctf_prov_strtab = NULL;
+ oom_prov_strtab:
+  ctf_dynhash_destroy (fp->ctf_str_atoms);
+  fp->ctf_str_atoms = NULL;
+  return -ENOMEM;
+}
+
+/* Pull in all the strings in the internal strtab as new atoms, if not already
+   done, so that strings added later are deduplicated against them.  Opening a
+   dict does not do this, since many dicts are opened only to be read.
+
+   The provisional strtab cannot contain any of these strings, so there is no
+   need to populate atoms from it as well.  Types in this subset are frozen and
+   readonly, so the refs list and movable refs list need not be populated, and
+   the atoms must never be rolled back.
+
+   Returns -1 and sets the errno on FP on error.  */
+
+static int
+ctf_str_populate_atoms (ctf_dict_t *fp)
+{
+  size_t i;
+
+  if (!(fp->ctf_flags & LCTF_STRS_UNATOMIZED))
+    return 0;
+
+  /* Avoid recursing back in here from ctf_str_add_ref_internal.  */
+  fp->ctf_flags &= ~LCTF_STRS_UNATOMIZED;
 
   for (i = 0; i < fp->ctf_str[CTF_STRTAB_0].cts_len;
        i += strlen (&fp->ctf_str[CTF_STRTAB_0].cts_strs[i]) + 1)
@@ -195,25 +230,16 @@ ctf_str_create_atoms (ctf_dict_t *fp)
 				       0, 0);
 
       if (!atom)
-	goto oom_str_add;
+	{
+	  fp->ctf_flags |= LCTF_STRS_UNATOMIZED;
+	  return -1;				/* errno is set for us.  */
+	}
 
       atom->csa_offset = i;
+      atom->csa_snapshot_id = 0;
     }
 
-  fp->ctf_str_prov_offset = fp->ctf_str[CTF_STRTAB_0].cts_len + 1;
-
   return 0;
-
- oom_str_add:
-  ctf_dynhash_destroy (fp->ctf_str_movable_refs);
-  fp->ctf_str_movable_refs = NULL;
- oom_movable_refs:
-  ctf_dynhash_destroy (fp->ctf_prov_strtab);
-  fp->ctf_prov_strtab = NULL;
- oom_prov_strtab:
-  ctf_dynhash_destroy (fp->ctf_str_atoms);
-  fp->ctf_str_atoms = NULL;
-  return -ENOMEM;
 }
 
 /* Destroy the atoms table and associated refs.  */
@@ -293,6 +319,9 @@ ctf_str_add_ref_internal (ctf_dict_t *fp, const char *str,
   ctf_str_atom_t *atom = NULL;
   int added = 0;
 
+  if (ctf_str_populate_atoms (fp) < 0)
+    return NULL;
+
   atom = ctf_dynhash_lookup (fp->ctf_str_atoms, str);
 
   /* Existing atoms get refs added only if they are provisional:
@@ -658,6 +687,9 @@ ctf_str_write_strtab (ctf_dict_t *fp)
   int new_strtab = 0;
   int any_external = 0;
 
+  if (ctf_str_populate_atoms (fp) < 0)
+    return NULL;
+
   strtab = calloc (1, sizeof (ctf_strs_writable_t));
   if (!strtab)
     return NULL;
@@ -25,6 +25,9 @@
 #include <stdarg.h>
 #include <string.h>
 #include <unistd.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 #ifndef ENOTSUP
 #define ENOTSUP ENOSYS
@@ -233,6 +236,10 @@ void ctf_dprintf (const char *format, ...)
 /* This needs more attention to thread-safety later on.  */
 static ctf_list_t open_errors;
 
+#if defined (HAVE_PTHREAD_H) && defined (HAVE_PTHREAD_CREATE)
+static pthread_mutex_t errs_warnings_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 /* Errors and warnings.  Report the warning or error to the list in FP (or the
    open errors list if NULL): if ERR is nonzero it is the errno to report to the
    debug stream instead of that recorded on fp.  */
@@ -275,10 +282,17 @@ ctf_err_warn (ctf_dict_t *fp, int is_warning, int err,
     ctf_dprintf ("%s: %s\n", is_warning ? _("warning") : _("error"),
 		 cew->cew_text);
 
+  /* The deduplicator can report errors from several threads at once.  */
+#if defined (HAVE_PTHREAD_H) && defined (HAVE_PTHREAD_CREATE)
+  pthread_mutex_lock (&errs_warnings_lock);
+#endif
   if (fp != NULL)
     ctf_list_append (&fp->ctf_errs_warnings, cew);
   else
     ctf_list_append (&open_errors, cew);
+#if defined (HAVE_PTHREAD_H) && defined (HAVE_PTHREAD_CREATE)
+  pthread_mutex_unlock (&errs_warnings_lock);
+#endif
 }
 
 /* Move all the errors/warnings from an fp into the open_errors.  */
@@ -625,10 +625,14 @@ ctf_get_dict (ctf_dict_t *fp, ctf_id_t type)
 }
 
 /* Look up a name in the given name table, in the appropriate hash given the
-   kind of the identifier.  The name is a raw, undecorated identifier.  */
+   kind of the identifier.  The name is a raw, undecorated identifier.  Returns
+   zero, with the errno set, if the name tables could not be built.  */
 
 ctf_id_t ctf_lookup_by_rawname (ctf_dict_t *fp, int kind, const char *name)
 {
+  if (ctf_hash_static_names (fp) < 0)
+    return 0;
+
   return (ctf_id_t) (uintptr_t)
     ctf_dynhash_lookup (ctf_name_table (fp, kind), name);
 }
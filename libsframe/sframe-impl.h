@@ -30,6 +30,18 @@ extern "C"
 #include <assert.h>
 #define sframe_assert(expr) (assert (expr))
 
+/* An entry in the flat PC index of a decoder context, for the FRE starting at
+   the corresponding PC in sfd_index_pcs.  */
+typedef struct sframe_index_entry
+{
+  /* Last PC covered by the FRE.  */
+  int32_t sfi_end_pc;
+  /* Offset of the FRE in the FRE table.  */
+  uint32_t sfi_fre_off;
+  /* Index of the FDE the FRE belongs to.  */
+  uint32_t sfi_fde_idx;
+} sframe_index_entry;
+
 struct sframe_decoder_ctx
 {
   /* SFrame header.  */
@@ -43,6 +55,13 @@ struct sframe_decoder_ctx
   /* Reference to the internally malloc'd buffer, if any, for endian flipping
      the original input buffer before decoding.  */
   void *sfd_buf;
+  /* Sorted start PCs of all the FREs in the flat PC index, if built.  Kept
+     apart from the rest of each entry, so the search stays in cache.  */
+  int32_t *sfd_index_pcs;
+  /* The rest of each flat PC index entry.  */
+  sframe_index_entry *sfd_index;
+  /* Number of entries in the flat PC index.  */
+  uint32_t sfd_index_num;
 };
 
 typedef struct sf_fde_tbl sf_fde_tbl;
@@ -621,6 +621,8 @@ sframe_decoder_free (sframe_decoder_ctx **dctxp)
 	  free (dctx->sfd_buf);
 	  dctx->sfd_buf = NULL;
 	}
+      free (dctx->sfd_index_pcs);
+      free (dctx->sfd_index);
 
       free (*dctxp);
       *dctxp = NULL;
@@ -1103,6 +1105,43 @@ sframe_fre_get_end_ip_offset (sframe_func_desc_entry *fdep, unsigned int i,
   return end_ip_offset;
 }
 
+/* Find the SFrame Row Entry which contains the PC using the flat PC index
+   of CTX.  Returns SFRAME_ERR if the index has no FRE covering PC.  */
+
+static int
+sframe_find_fre_indexed (sframe_decoder_ctx *ctx, int32_t pc,
+			 sframe_frame_row_entry *frep)
+{
+  const int32_t *base = ctx->sfd_index_pcs;
+  const sframe_index_entry *ent;
+  sframe_func_desc_entry *fdep;
+  uint32_t n = ctx->sfd_index_num;
+  size_t size = 0;
+  int err = 0;
+
+  if (n == 0 || pc < base[0])
+    return sframe_set_errno (&err, SFRAME_ERR_FRE_NOTFOUND);
+
+  /* Find the last FRE starting at or before PC.  The loop has no
+     unpredictable branches: the compiler turns the select into a
+     conditional move.  */
+  while (n > 1)
+    {
+      uint32_t half = n / 2;
+
+      base = (base[half] <= pc) ? base + half : base;
+      n -= half;
+    }
+
+  ent = &ctx->sfd_index[base - ctx->sfd_index_pcs];
+  if (pc > ent->sfi_end_pc)
+    return sframe_set_errno (&err, SFRAME_ERR_FRE_NOTFOUND);
+
+  fdep = ctx->sfd_funcdesc + ent->sfi_fde_idx;
+  return sframe_decode_fre (ctx->sfd_fres + ent->sfi_fre_off, frep,
+			    sframe_get_fre_type (fdep), &size);
+}
+
 /* Find the SFrame Row Entry which contains the PC.  Returns
    SFRAME_ERR if failure.  */
 
@@ -1124,6 +1163,13 @@ sframe_find_fre (sframe_decoder_ctx *ctx, int32_t pc,
   if ((ctx == NULL) || (frep == NULL))
     return sframe_set_errno (&err, SFRAME_ERR_INVAL);
 
+  /* Try the flat PC index first, if one has been built.  Anything it does
+     not cover (including FDEs of type SFRAME_FDE_TYPE_PCMASK) is looked up
+     the slow way below, which also diagnoses errors.  */
+  if (ctx->sfd_index_pcs != NULL
+      && sframe_find_fre_indexed (ctx, pc, frep) == 0)
+    return 0;
+
   /* Find the FDE which contains the PC, then scan its fre entries.  */
   fdep = sframe_get_funcdesc_with_addr_internal (ctx, pc, &err);
   if (fdep == NULL || ctx->sfd_fres == NULL)
@@ -1159,6 +1205,121 @@ sframe_find_fre (sframe_decoder_ctx *ctx, int32_t pc,
   return sframe_set_errno (&err, SFRAME_ERR_FDE_INVAL);
 }
 
+/* Build a flat index of the FREs in the decoder context DCTX, sorted on PC,
+   to speed up all later calls to sframe_find_fre.  Returns SFRAME_ERR if
+   failure, in which case sframe_find_fre keeps working without an index.  */
+
+int
+sframe_decoder_build_index (sframe_decoder_ctx *dctx)
+{
+  sframe_func_desc_entry *fdep;
+  sframe_frame_row_entry fre;
+  sframe_header *dhp;
+  int32_t *pcs = NULL;
+  sframe_index_entry *index = NULL;
+  uint32_t num_fdes, num = 0, n = 0;
+  int64_t last_pc = INT64_MIN;
+  uint32_t i, j;
+  int err = 0;
+
+  if (dctx == NULL)
+    return sframe_set_errno (&err, SFRAME_ERR_INVAL);
+
+  dhp = sframe_decoder_get_header (dctx);
+  if (dctx->sfd_funcdesc == NULL || dctx->sfd_fres == NULL)
+    return sframe_set_errno (&err, SFRAME_ERR_DCTX_INVAL);
+  if ((dhp->sfh_preamble.sfp_flags & SFRAME_F_FDE_SORTED) == 0)
+    return sframe_set_errno (&err, SFRAME_ERR_FDE_NOTSORTED);
+
+  if (dctx->sfd_index_pcs != NULL)
+    return 0;
+
+  /* FREs of SFRAME_FDE_TYPE_PCMASK FDEs apply to any number of PCs, so
+     they are left out.  */
+  num_fdes = dhp->sfh_num_fdes;
+  for (i = 0; i < num_fdes; i++)
+    {
+      fdep = dctx->sfd_funcdesc + i;
+      if (sframe_get_fde_type (fdep) != SFRAME_FDE_TYPE_PCMASK)
+	num += fdep->sfde_func_num_fres;
+    }
+
+  pcs = malloc (((size_t) num + 1) * sizeof (int32_t));
+  index = malloc (((size_t) num + 1) * sizeof (sframe_index_entry));
+  if (pcs == NULL || index == NULL)
+    {
+      free (pcs);
+      free (index);
+      return sframe_set_errno (&err, SFRAME_ERR_NOMEM);
+    }
+
+  for (i = 0; i < num_fdes; i++)
+    {
+      int64_t func_start, func_end;
+      uint32_t fre_type;
+      uint32_t fre_off;
+      size_t size = 0;
+
+      fdep = dctx->sfd_funcdesc + i;
+      func_start = fdep->sfde_func_start_address;
+      func_end = func_start + fdep->sfde_func_size;
+
+      /* The index must give the same answers as the FDE search in
+	 sframe_find_fre: so each PC must be covered by at most one FDE,
+	 which must also be the last one starting at or before it.  */
+      if (i + 1 < num_fdes)
+	{
+	  int64_t next_start = fdep[1].sfde_func_start_address;
+
+	  if (next_start <= func_start || next_start < func_end)
+	    goto fail;
+	}
+
+      if (sframe_get_fde_type (fdep) == SFRAME_FDE_TYPE_PCMASK)
+	continue;
+
+      fre_type = sframe_get_fre_type (fdep);
+      fre_off = fdep->sfde_func_start_fre_off;
+      for (j = 0; j < fdep->sfde_func_num_fres; j++)
+	{
+	  const char *fres = dctx->sfd_fres + fre_off;
+	  int32_t start_pc, end_ip_offset;
+
+	  if (fre_off >= (uint32_t) dctx->sfd_fre_nbytes
+	      || sframe_decode_fre (fres, &fre, fre_type, &size))
+	    goto fail;
+
+	  /* Same arithmetic as in sframe_find_fre.  */
+	  start_pc = (int32_t) fre.fre_start_addr
+	    + fdep->sfde_func_start_address;
+	  end_ip_offset = sframe_fre_get_end_ip_offset (fdep, j, fres + size);
+	  if (start_pc < last_pc)
+	    goto fail;
+
+	  pcs[n] = start_pc;
+	  index[n].sfi_end_pc = end_ip_offset + fdep->sfde_func_start_address;
+	  index[n].sfi_fre_off = fre_off;
+	  index[n].sfi_fde_idx = i;
+	  last_pc = start_pc;
+	  fre_off += size;
+	  n++;
+	}
+    }
+
+  dctx->sfd_index_pcs = pcs;
+  dctx->sfd_index = index;
+  dctx->sfd_index_num = n;
+
+  debug_printf ("%u FREs in flat PC index\n", n);
+
+  return 0;
+
+fail:
+  free (pcs);
+  free (index);
+  return sframe_set_errno (&err, SFRAME_ERR_FRE_INVAL);
+}
+
 /* Return the number of function descriptor entries in the SFrame decoder
    DCTX.  */
 
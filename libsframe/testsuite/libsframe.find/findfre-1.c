@@ -148,6 +148,26 @@ int main (void)
   TEST("findfre-1: Find FRE for out of range PC",
        (err == SFRAME_ERR));
 
+  /* Repeat the lookups with the flat PC index in place.  */
+  err = sframe_decoder_build_index (dctx);
+  TEST("findfre-1: Build index", err == 0);
+
+  err = sframe_find_fre (dctx, (0xfffff03e + 0x9), &frep);
+  TEST("findfre-1: Find FRE for last PC covered by FRE (index)",
+       ((err == 0) && (sframe_fre_get_cfa_offset(dctx, &frep, &err) == 0x2)));
+
+  err = sframe_find_fre (dctx, (0xfffff03e + 0x39), &frep);
+  TEST("findfre-1: Find last FRE (index)",
+       ((err == 0) && (sframe_fre_get_cfa_offset(dctx, &frep, &err) == 0x8)));
+
+  err = sframe_find_fre (dctx, (0xfffff08e + 0x0), &frep);
+  TEST("findfre-1: Find first FRE (index)",
+       ((err == 0) && (sframe_fre_get_cfa_offset(dctx, &frep, &err) == 0x10)));
+
+  err = sframe_find_fre (dctx, (0xfffff03e + 0x40), &frep);
+  TEST("findfre-1: Find FRE for out of range PC (index)",
+       (err == SFRAME_ERR));
+
   sframe_encoder_free (&encode);
   sframe_decoder_free (&dctx);
 
@@ -0,0 +1,160 @@
+/* findfre-bench.c -- Benchmark sframe_find_fre with and without an index.
+
+   Copyright (C) 2025 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sframe-api.h"
+
+/* DejaGnu should not use gnulib's vsnprintf replacement here.  */
+#undef vsnprintf
+#include <dejagnu.h>
+
+/* A section of NUM_FDES functions of FUNC_SIZE bytes, starting at
+   FUNC_BASE, each with NUM_FRES FREs FRE_STEP bytes apart.  */
+#define NUM_FDES 4096
+#define NUM_FRES 8
+#define FUNC_BASE 0x10000
+#define FUNC_SIZE 0x100
+#define FRE_STEP (FUNC_SIZE / NUM_FRES)
+
+#define NUM_LOOKUPS (1 << 20)
+
+/* The CFA offset of the FRE covering PC.  */
+
+static int32_t
+expected_cfa_offset (int32_t pc)
+{
+  int fre = (pc - FUNC_BASE) % FUNC_SIZE / FRE_STEP;
+  return fre == 0 ? 0x8 : 0x10 + fre;
+}
+
+static int
+add_fdes (sframe_encoder_ctx *encode)
+{
+  unsigned char finfo = sframe_fde_create_func_info (SFRAME_FRE_TYPE_ADDR1,
+						     SFRAME_FDE_TYPE_PCINC);
+  int i, j;
+
+  for (i = 0; i < NUM_FDES; i++)
+    {
+      if (sframe_encoder_add_funcdesc (encode, FUNC_BASE + i * FUNC_SIZE,
+				       FUNC_SIZE, finfo, NUM_FRES) == -1)
+	return -1;
+
+      for (j = 0; j < NUM_FRES; j++)
+	{
+	  sframe_frame_row_entry fre
+	    = { j * FRE_STEP, { 0x10 + j, 0xf0, 0 }, 0x5 };
+	  if (j == 0)
+	    {
+	      fre.fre_offsets[0] = 0x8;
+	      fre.fre_offsets[1] = 0;
+	      fre.fre_info = 0x3;
+	    }
+	  if (sframe_encoder_add_fre (encode, i, &fre) == SFRAME_ERR)
+	    return -1;
+	}
+    }
+
+  return 0;
+}
+
+/* Look up NUM_LOOKUPS pseudo-random PCs in DCTX.  Return the number of
+   lookups per second, or -1 if any result is wrong.  */
+
+static double
+lookup_rate (sframe_decoder_ctx *dctx)
+{
+  sframe_frame_row_entry frep;
+  uint32_t seed = 12345;
+  clock_t start;
+  double secs;
+  int i, err;
+
+  start = clock ();
+  for (i = 0; i < NUM_LOOKUPS; i++)
+    {
+      int32_t pc;
+
+      seed = seed * 1103515245 + 12345;
+      pc = FUNC_BASE + (seed >> 8) % (NUM_FDES * FUNC_SIZE);
+      if (sframe_find_fre (dctx, pc, &frep) != 0
+	  || sframe_fre_get_cfa_offset (dctx, &frep, &err)
+	     != expected_cfa_offset (pc))
+	return -1;
+    }
+  secs = (double) (clock () - start) / CLOCKS_PER_SEC;
+
+  return secs > 0 ? NUM_LOOKUPS / secs : NUM_LOOKUPS;
+}
+
+int main (void)
+{
+  sframe_encoder_ctx *encode;
+  sframe_decoder_ctx *dctx;
+  char *sframe_buf;
+  size_t sf_size;
+  double rate, index_rate;
+  int err = 0;
+
+#define TEST(name, cond)                                                      \
+  do                                                                          \
+    {                                                                         \
+      if (cond)                                                               \
+	pass (name);                                                          \
+      else                                                                    \
+	fail (name);                                                          \
+    }                                                                         \
+    while (0)
+
+  encode = sframe_encode (SFRAME_VERSION, 0,
+			  SFRAME_ABI_AMD64_ENDIAN_LITTLE,
+			  SFRAME_CFA_FIXED_FP_INVALID,
+			  -8, /* Fixed RA offset for AMD64.  */
+			  &err);
+
+  err = add_fdes (encode);
+  TEST ("findfre-bench: Adding FDEs", err == 0);
+
+  sframe_buf = sframe_encoder_write (encode, &sf_size, &err);
+  TEST ("findfre-bench: Encoder write", err == 0);
+
+  dctx = sframe_decode (sframe_buf, sf_size, &err);
+  TEST ("findfre-bench: Decoder setup", dctx != NULL);
+
+  rate = lookup_rate (dctx);
+  TEST ("findfre-bench: Lookups", rate > 0);
+
+  err = sframe_decoder_build_index (dctx);
+  TEST ("findfre-bench: Build index", err == 0);
+
+  index_rate = lookup_rate (dctx);
+  TEST ("findfre-bench: Lookups (index)", index_rate > 0);
+
+  note ("findfre-bench: %d FDEs, %d FREs: %.2fM lookups/s, "
+	"%.2fM lookups/s with the index\n", NUM_FDES, NUM_FDES * NUM_FRES,
+	rate / 1e6, index_rate / 1e6);
+
+  sframe_encoder_free (&encode);
+  sframe_decoder_free (&dctx);
+
+  return 0;
+}
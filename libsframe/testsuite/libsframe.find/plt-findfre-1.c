@@ -120,6 +120,14 @@ int main (void)
   TEST("plt-findfre-1: Find last FRE in PLT4",
        ((err == 0) && (sframe_fre_get_cfa_offset (dctx, &frep, &err) == 0x3)));
 
+  /* PCMASK FDEs are not in the PC index; lookups must still find them.  */
+  err = sframe_decoder_build_index (dctx);
+  TEST("plt-findfre-1: Build index", err == 0);
+
+  err = sframe_find_fre (dctx, (0x1000 + 16*3 + 0x6), &frep);
+  TEST("plt-findfre-1: Find second FRE in PLT4 (index)",
+       ((err == 0) && (sframe_fre_get_cfa_offset (dctx, &frep, &err) == 0x2)));
+
   sframe_encoder_free (&ectx);
   sframe_decoder_free (&dctx);
 
@@ -9614,6 +9614,9 @@ i386_dis_printf (const disassemble_info *info, enum disassembler_style style,
   const char *start, *curr;
   char staging_area[50];
 
+  if (info->flags & DISASSEMBLE_NO_TEXT)
+    return;
+
   va_start (ap, fmt);
   /* In particular print_insn()'s processing of op_txt[] can hand rather long
      strings here.  Bypass vsnprintf() in such cases to avoid capacity issues
@@ -10228,6 +10231,20 @@ print_insn (bfd_vma pc, disassemble_info *info, int intel_syntax)
       goto out;
     }
 
+  /* When only the length and branch information are wanted, don't bother
+     arranging and printing the operands.  */
+  if (info->flags & DISASSEMBLE_NO_TEXT)
+    {
+      for (i = 0; i < MAX_OPERANDS; ++i)
+	if (ins.op_is_jump && ins.op_index[i] != -1 && !ins.op_riprel[i])
+	  {
+	    info->insn_info_valid = 1;
+	    info->target = (bfd_vma) ins.op_address[ins.op_index[i]];
+	  }
+      ret = ins.codep - priv.the_buffer;
+      goto out;
+    }
+
   /* Calculate the number of operands this instruction has.  */
   op_count = 0;
   for (i = 0; i < MAX_OPERANDS; ++i)